@@ -0,0 +1,119 @@
+#include "bench_util.hpp"
+#include <iris/aggregate.hpp>
+#include <iostream>
+#include <map>
+#include <random>
+
+namespace {
+
+const char* const kTypes[] = {"give", "take", "sweets_log", "gold_log", "trade"};
+
+iris::RecordTable makeTable(size_t records) {
+    iris::RecordTable table;
+    table.reserve(records);
+    for (const char* type : kTypes) {
+        table.types().intern(type);
+    }
+    std::mt19937_64 random(42);
+    for (size_t i = 0; i < records; ++i) {
+        table.append(static_cast<int64_t>(100000 + random() % 50000),
+                     static_cast<int32_t>(random() % 1000) + 1,
+                     static_cast<int64_t>(1700000000 + i / 4),
+                     static_cast<uint8_t>(random() % 5));
+    }
+    return table;
+}
+
+std::vector<iris::HistoryData> makeRecords(size_t records) {
+    std::vector<iris::HistoryData> result(records);
+    std::mt19937_64 random(42);
+    for (size_t i = 0; i < records; ++i) {
+        iris::HistoryData& record = result[i];
+        record.user_id = static_cast<long>(100000 + random() % 50000);
+        record.amount = static_cast<int>(random() % 1000) + 1;
+        record.timestamp = static_cast<long>(1700000000 + i / 4);
+        record.type = kTypes[random() % 5];
+    }
+    return result;
+}
+
+const char* levelName(iris::SimdLevel level) {
+    switch (level) {
+    case iris::SimdLevel::AVX2: return "avx2";
+    case iris::SimdLevel::SSE42: return "sse4.2";
+    default: return "scalar";
+    }
+}
+
+template <typename Fn>
+void compare(const std::string& label, size_t records, size_t iterations, Fn&& fn) {
+    for (iris::SimdLevel level : {iris::SimdLevel::SCALAR, iris::SimdLevel::SSE42,
+                                  iris::SimdLevel::AVX2}) {
+        if (level > iris::supportedSimdLevel()) {
+            continue;
+        }
+        iris::setSimdLevel(level);
+        iris::bench::report(label + " " + levelName(level),
+                            iris::bench::measure(iterations, records, fn));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? std::stoul(argv[1]) : 10000000;
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 10;
+
+    iris::RecordTable table = makeTable(records);
+    iris::RecordView view = table.view();
+    uint8_t give = *table.types().find("give");
+
+    iris::RecordFilter window;
+    window.fromTimestamp = 1700000000 + static_cast<int64_t>(records / 16);
+    window.toTimestamp = 1700000000 + static_cast<int64_t>(records / 8);
+    iris::RecordFilter gives;
+    gives.type = give;
+    iris::RecordFilter oneUser;
+    oneUser.userId = 100042;
+
+    iris::bench::trackAllocations();
+    std::cout << records << " records, " << iterations << " iterations\n";
+    volatile int64_t sink = 0;
+
+    compare("total", records, iterations, [&] { sink = sink + iris::total(view).amount; });
+    compare("total type=give", records, iterations,
+            [&] { sink = sink + iris::total(view, gives).amount; });
+    compare("total time window", records, iterations,
+            [&] { sink = sink + iris::total(view, window).amount; });
+    compare("total user_id", records, iterations,
+            [&] { sink = sink + iris::total(view, oneUser).amount; });
+    compare("by type, type=give", records, iterations,
+            [&] { sink = sink + iris::totalsByType(view, gives)[give].amount; });
+    compare("by hour", records, iterations,
+            [&] { sink = sink + static_cast<int64_t>(iris::totalsByTime(view, 3600).size()); });
+    compare("by user", records, iterations,
+            [&] { sink = sink + static_cast<int64_t>(iris::totalsByUser(view).size()); });
+    compare("top 10 users, type=give", records, iterations,
+            [&] { sink = sink + iris::topUsers(view, 10, gives).front().totals.amount; });
+
+    // Same questions over decoded structs, for scale.
+    size_t structs = std::min<size_t>(records, 1000000);
+    std::vector<iris::HistoryData> decoded = makeRecords(structs);
+    iris::bench::report("AoS total type=give", iris::bench::measure(iterations, structs, [&] {
+        int64_t sum = 0;
+        for (const iris::HistoryData& record : decoded) {
+            if (record.type == "give") {
+                sum += record.amount;
+            }
+        }
+        sink = sink + sum;
+    }));
+    iris::bench::report("AoS by user (std::map)", iris::bench::measure(iterations, structs, [&] {
+        std::map<long, int64_t> users;
+        for (const iris::HistoryData& record : decoded) {
+            users[record.user_id] += record.amount;
+        }
+        sink = sink + static_cast<int64_t>(users.size());
+    }));
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "bench_util.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <curl/curl.h>
+
+namespace iris {
+namespace bench {
+
+std::atomic<size_t> allocationCount{0};
+
+namespace {
+
+thread_local bool tracked = false;
+std::atomic<size_t> curlAllocationCount{0};
+
+void countCurl() {
+    if (tracked) {
+        curlAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void* curlMalloc(size_t size) {
+    countCurl();
+    return std::malloc(size);
+}
+
+void curlFree(void* p) {
+    std::free(p);
+}
+
+void* curlRealloc(void* p, size_t size) {
+    countCurl();
+    return std::realloc(p, size);
+}
+
+char* curlStrdup(const char* str) {
+    countCurl();
+    size_t length = std::strlen(str) + 1;
+    auto* copy = static_cast<char*>(std::malloc(length));
+    if (copy) {
+        std::memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+void* curlCalloc(size_t count, size_t size) {
+    countCurl();
+    return std::calloc(count, size);
+}
+
+} // namespace
+
+void trackAllocations(bool enabled) {
+    tracked = enabled;
+}
+
+void countCurlAllocations() {
+    curl_global_init_mem(CURL_GLOBAL_DEFAULT, curlMalloc, curlFree, curlRealloc,
+                         curlStrdup, curlCalloc);
+}
+
+size_t curlAllocations() {
+    return curlAllocationCount.load(std::memory_order_relaxed);
+}
+
+bool isTracked() {
+    return tracked;
+}
+
+} // namespace bench
+} // namespace iris
+
+void* operator new(std::size_t size) {
+    if (iris::bench::isTracked()) {
+        iris::bench::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
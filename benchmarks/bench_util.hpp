@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace iris {
+namespace bench {
+
+// Counts operator new calls made on threads that called trackAllocations();
+// see alloc_counter.cpp. Server threads stay untracked so they do not skew
+// per-call numbers.
+extern std::atomic<size_t> allocationCount;
+void trackAllocations(bool enabled = true);
+
+// Routes libcurl's own malloc family through a counter. Must run before any
+// other libcurl call.
+void countCurlAllocations();
+size_t curlAllocations();
+bool isTracked();
+
+inline size_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+struct Measurement {
+    double nsPerItem;
+    double allocsPerItem;
+    double curlAllocsPerItem;
+};
+
+template <typename Fn>
+Measurement measure(size_t iterations, size_t itemsPerIteration, Fn&& fn) {
+    size_t allocsBefore = allocations();
+    size_t curlBefore = curlAllocations();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    size_t allocs = allocations() - allocsBefore;
+    size_t curlAllocs = curlAllocations() - curlBefore;
+
+    double items = static_cast<double>(iterations * itemsPerIteration);
+    return {
+        std::chrono::duration<double, std::nano>(elapsed).count() / items,
+        static_cast<double>(allocs) / items,
+        static_cast<double>(curlAllocs) / items
+    };
+}
+
+inline void report(const std::string& name, const Measurement& m) {
+    std::printf("%-40s %10.1f ns/item %8.2f allocs/item %8.2f curl mallocs/item\n",
+                name.c_str(), m.nsPerItem, m.allocsPerItem, m.curlAllocsPerItem);
+}
+
+} // namespace bench
+} // namespace iris
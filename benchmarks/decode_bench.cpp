@@ -0,0 +1,36 @@
+#include "bench_util.hpp"
+#include "mock_iris.hpp"
+#include <iris/json_decode.hpp>
+#include <iostream>
+
+namespace {
+
+template <typename T>
+void compare(const std::string& label, const std::string& body, size_t records, size_t iterations) {
+    volatile size_t sink = 0;
+    auto dom = iris::bench::measure(iterations, records, [&] {
+        sink = sink + nlohmann::json::parse(body).get<T>().size();
+    });
+    auto sax = iris::bench::measure(iterations, records, [&] {
+        T decoded;
+        std::string error;
+        iris::tryDecodeJson(body, decoded, error);
+        sink = sink + decoded.size();
+    });
+    iris::bench::report(label + " json::parse + get", dom);
+    iris::bench::report(label + " tryDecodeJson", sax);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    iris::bench::trackAllocations();
+
+    std::cout << records << " records per page, " << iterations << " iterations\n";
+    compare<std::vector<iris::HistoryData>>("history", iris::bench::makeHistoryPage(records), records, iterations);
+    compare<std::vector<iris::UpdatesLog>>("updates", iris::bench::makeUpdatesPage(records), records, iterations);
+    return 0;
+}
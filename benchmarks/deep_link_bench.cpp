@@ -0,0 +1,86 @@
+#include "bench_util.hpp"
+#include <iris/iris_api.hpp>
+#include <cstdio>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+namespace {
+
+constexpr long kBotId = 123456789;
+
+std::vector<iris::DeepLinkItem> makeItems(size_t count) {
+    const iris::Currency currencies[] = {iris::Currency::SWEETS, iris::Currency::GOLD,
+                                         iris::Currency::DONATE_SCORE};
+    std::vector<iris::DeepLinkItem> items;
+    items.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string comment = i % 4 == 0 ? "" : "campaign_" + std::to_string(i % 1000) + "_promo";
+        items.push_back({currencies[i % 3], static_cast<int>(i % 5000) + 1, std::move(comment)});
+    }
+    return items;
+}
+
+// The per-call implementation generateDeepLink had before the bulk path:
+// std::regex validation and a std::stringstream.
+std::string streamDeepLink(long botId, iris::Currency currency, int count, const std::string& comment) {
+    if (!comment.empty()) {
+        static const std::regex pattern("^[a-zA-Z0-9_]+$");
+        if (!std::regex_match(comment, pattern)) {
+            throw std::invalid_argument("Comment can only contain letters, numbers and underscore");
+        }
+    }
+    std::stringstream url;
+    url << "https://t.me/iris_black_bot?start=";
+    switch (currency) {
+        case iris::Currency::GOLD:
+            url << "givegold_bot";
+            break;
+        case iris::Currency::SWEETS:
+            url << "give_bot";
+            break;
+        case iris::Currency::DONATE_SCORE:
+            url << "givedonate_score_bot";
+            break;
+    }
+    url << botId << "_" << count;
+    if (!comment.empty()) {
+        url << "_" << comment;
+    }
+    return url.str();
+}
+
+void compare(const std::string& name, size_t links, size_t iterations, const std::function<void()>& fn) {
+    auto m = iris::bench::measure(iterations, links, fn);
+    iris::bench::report(name, m);
+    std::printf("%-40s %10.2f M links/s\n", "", 1e3 / m.nsPerItem);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t links = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 5;
+
+    iris::IrisApi api(kBotId, "token", "http://127.0.0.1:1");
+    std::vector<iris::DeepLinkItem> items = makeItems(links);
+
+    iris::bench::trackAllocations();
+    std::cout << links << " links, " << iterations << " iterations\n";
+    volatile size_t sink = 0;
+
+    compare("stringstream + regex", links, iterations, [&] {
+        for (const auto& item : items) {
+            sink = sink + streamDeepLink(kBotId, item.currency, item.count, item.comment).size();
+        }
+    });
+    compare("generateDeepLink", links, iterations, [&] {
+        for (const auto& item : items) {
+            sink = sink + api.generateDeepLink(item.currency, item.count, item.comment).size();
+        }
+    });
+    compare("generateDeepLinks (bulk)", links, iterations, [&] {
+        sink = sink + api.generateDeepLinks(items).buffer().size();
+    });
+    return 0;
+}
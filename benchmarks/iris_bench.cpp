@@ -0,0 +1,299 @@
+#include "bench_util.hpp"
+#include "mock_iris.hpp"
+#include <iris/iris_api.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// Every IrisApi method against a loopback emulation of the Iris API:
+//   rps       blocking calls per second from one thread
+//   p50/p99   blocking call latency (us)
+//   allocs    operator new calls per blocking call on the calling thread
+//   async     callback calls per second with `concurrency` in flight
+//   decode    response decoding throughput (MB/s of JSON)
+//
+// iriscpp_bench [--iterations N] [--concurrency N] [--latency-us N]
+//               [--records N] [--filter TEXT]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+    size_t iterations = 2000;
+    size_t concurrency = 32;
+    iris::bench::MockIrisOptions server;
+    std::string filter;
+};
+
+struct Case {
+    std::string name;
+    iris::EndpointId id;
+    std::function<bool()> call;
+    std::function<void(std::function<void()>)> callAsync;
+    std::function<size_t(std::string_view)> decode;
+};
+
+template <typename T>
+bool succeeded(const std::optional<T>& result) {
+    return result.has_value();
+}
+
+template <typename T>
+bool succeeded(const std::vector<T>&) {
+    // An empty page is a valid answer.
+    return true;
+}
+
+template <typename T>
+size_t items(const std::optional<T>& result) {
+    return result ? 1 : 0;
+}
+
+template <typename T>
+size_t items(const std::vector<T>& result) {
+    return result.size();
+}
+
+template <typename E, typename Call, typename CallAsync>
+Case makeCase(std::string name, const E& endpoint, Call call, CallAsync callAsync) {
+    return Case{
+        std::move(name),
+        E::id,
+        [call] { return succeeded(call()); },
+        [callAsync](std::function<void()> done) {
+            callAsync([done = std::move(done)](typename E::result_type) { done(); });
+        },
+        [tryDecode = endpoint.tryDecode](std::string_view body) {
+            typename E::result_type result{};
+            std::string error;
+            tryDecode(body, result, error);
+            return items(result);
+        },
+    };
+}
+
+std::vector<Case> makeCases(iris::IrisApi& api) {
+    namespace ep = iris::endpoints;
+    const long user = 42;
+    std::vector<Case> cases;
+
+    cases.push_back(makeCase("giveSweets", ep::kGiveSweets,
+        [&] { return api.giveSweets(10, user, "bench"); },
+        [&](auto done) { api.giveSweetsAsync(10, user, "bench", true, std::move(done)); }));
+    cases.push_back(makeCase("giveGold", ep::kGiveGold,
+        [&] { return api.giveGold(1, user); },
+        [&](auto done) { api.giveGoldAsync(1, user, "", true, std::move(done)); }));
+    cases.push_back(makeCase("giveDonateScore", ep::kGiveDonateScore,
+        [&] { return api.giveDonateScore(1, user); },
+        [&](auto done) { api.giveDonateScoreAsync(1, user, "", std::move(done)); }));
+    cases.push_back(makeCase("getBalance", ep::kBalance,
+        [&] { return api.getBalance(); },
+        [&](auto done) { api.getBalanceAsync(std::move(done)); }));
+    cases.push_back(makeCase("getSweetsHistory", ep::kSweetsHistory,
+        [&] { return api.getSweetsHistory(); },
+        [&](auto done) { api.getSweetsHistoryAsync(0, std::move(done)); }));
+    cases.push_back(makeCase("getGoldHistory", ep::kGoldHistory,
+        [&] { return api.getGoldHistory(); },
+        [&](auto done) { api.getGoldHistoryAsync(0, std::move(done)); }));
+    cases.push_back(makeCase("getDonateScoreHistory", ep::kDonateScoreHistory,
+        [&] { return api.getDonateScoreHistory(); },
+        [&](auto done) { api.getDonateScoreHistoryAsync(0, std::move(done)); }));
+    cases.push_back(makeCase("enablePocket", ep::kPocketEnable,
+        [&] { return api.enablePocket(true); },
+        [&](auto done) { api.enablePocketAsync(true, std::move(done)); }));
+    cases.push_back(makeCase("enableAllPocket", ep::kPocketAllowAll,
+        [&] { return api.enableAllPocket(true); },
+        [&](auto done) { api.enableAllPocketAsync(true, std::move(done)); }));
+    cases.push_back(makeCase("allowUserPocket", ep::kPocketAllowUser,
+        [&] { return api.allowUserPocket(user, true); },
+        [&](auto done) { api.allowUserPocketAsync(user, true, std::move(done)); }));
+    cases.push_back(makeCase("getUpdates", ep::kGetUpdates,
+        [&] { return api.getUpdates(); },
+        [&](auto done) { api.getUpdatesAsync(0, 0, std::move(done)); }));
+    cases.push_back(makeCase("getIrisAgents", ep::kIrisAgents,
+        [&] { return api.getIrisAgents(); },
+        [&](auto done) { api.getIrisAgentsAsync(std::move(done)); }));
+    cases.push_back(makeCase("checkUserReg", ep::kUserReg,
+        [&] { return api.checkUserReg(user); },
+        [&](auto done) { api.checkUserRegAsync(user, std::move(done)); }));
+    cases.push_back(makeCase("checkUserSpam", ep::kUserSpam,
+        [&] { return api.checkUserSpam(user); },
+        [&](auto done) { api.checkUserSpamAsync(user, std::move(done)); }));
+    cases.push_back(makeCase("checkUserActivity", ep::kUserActivity,
+        [&] { return api.checkUserActivity(user); },
+        [&](auto done) { api.checkUserActivityAsync(user, std::move(done)); }));
+    cases.push_back(makeCase("checkUserStars", ep::kUserStars,
+        [&] { return api.checkUserStars(user); },
+        [&](auto done) { api.checkUserStarsAsync(user, std::move(done)); }));
+    cases.push_back(makeCase("checkUserPocket", ep::kUserPocket,
+        [&] { return api.checkUserPocket(user); },
+        [&](auto done) { api.checkUserPocketAsync(user, std::move(done)); }));
+    cases.push_back(makeCase("buyTrade", ep::kTradeBuy,
+        [&] { return api.buyTrade(0.5, 5); },
+        [&](auto done) { api.buyTradeAsync(0.5, 5, std::move(done)); }));
+    cases.push_back(makeCase("sellTrade", ep::kTradeSell,
+        [&] { return api.sellTrade(0.6, 5); },
+        [&](auto done) { api.sellTradeAsync(0.6, 5, std::move(done)); }));
+    cases.push_back(makeCase("getOrdersTrade", ep::kTradeMyOrders,
+        [&] { return api.getOrdersTrade(); },
+        [&](auto done) { api.getOrdersTradeAsync(std::move(done)); }));
+    cases.push_back(makeCase("cancelPriceTrade", ep::kTradeCancelPrice,
+        [&] { return api.cancelPriceTrade(0.5); },
+        [&](auto done) { api.cancelPriceTradeAsync(0.5, std::move(done)); }));
+    cases.push_back(makeCase("cancelAllTrade", ep::kTradeCancelAll,
+        [&] { return api.cancelAllTrade(); },
+        [&](auto done) { api.cancelAllTradeAsync(std::move(done)); }));
+    cases.push_back(makeCase("cancelPartTrade", ep::kTradeCancelPart,
+        [&] { return api.cancelPartTrade(5001, 5); },
+        [&](auto done) { api.cancelPartTradeAsync(5001, 5, std::move(done)); }));
+    return cases;
+}
+
+struct BlockingResult {
+    double rps;
+    uint64_t p50;
+    uint64_t p99;
+    double allocsPerCall;
+};
+
+BlockingResult runBlocking(const Case& c, size_t iterations) {
+    iris::LatencyHistogram latency;
+    size_t allocsBefore = iris::bench::allocations();
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        Clock::time_point before = Clock::now();
+        if (!c.call()) {
+            std::cerr << c.name << " failed" << std::endl;
+            std::exit(1);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - before);
+        latency.record(static_cast<uint64_t>(elapsed.count()));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t allocs = iris::bench::allocations() - allocsBefore;
+
+    iris::HistogramSnapshot snapshot = latency.snapshot();
+    return {
+        static_cast<double>(iterations) / seconds,
+        snapshot.percentile(0.5),
+        snapshot.percentile(0.99),
+        static_cast<double>(allocs) / static_cast<double>(iterations),
+    };
+}
+
+double runAsync(const Case& c, size_t iterations, size_t concurrency) {
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t started = 0;
+    size_t completed = 0;
+
+    Clock::time_point start = Clock::now();
+    // Completions chain into the next request, keeping the window full.
+    std::function<void()> chained;
+    chained = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (started == iterations) {
+                return;
+            }
+            ++started;
+        }
+        c.callAsync([&] {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++completed == iterations) {
+                    finished.notify_all();
+                    return;
+                }
+            }
+            chained();
+        });
+    };
+    for (size_t i = 0; i < std::min(concurrency, iterations); ++i) {
+        chained();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return completed == iterations; });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(iterations) / seconds;
+}
+
+double runDecode(const Case& c, const std::string& body) {
+    // Enough passes for about 64MB of JSON, at least 1000.
+    size_t passes = std::max<size_t>(1000, (64u << 20) / std::max<size_t>(body.size(), 1));
+    volatile size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < passes; ++i) {
+        sink = sink + c.decode(body);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(body.size() * passes) / seconds / 1e6;
+}
+
+bool parseArguments(int argc, char** argv, Settings& settings) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--iterations") {
+            settings.iterations = std::stoul(value);
+        } else if (flag == "--concurrency") {
+            settings.concurrency = std::stoul(value);
+        } else if (flag == "--latency-us") {
+            settings.server.latency = std::chrono::microseconds(std::stol(value));
+        } else if (flag == "--records") {
+            settings.server.historyRecords = settings.server.updateRecords = std::stoul(value);
+        } else if (flag == "--filter") {
+            settings.filter = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && settings.iterations > 0 && settings.concurrency > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Settings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        std::cerr << "usage: iriscpp_bench [--iterations N] [--concurrency N] [--latency-us N]"
+                     " [--records N] [--filter TEXT]" << std::endl;
+        return 2;
+    }
+
+    iris::bench::MockIris server(settings.server);
+    iris::IrisApi api(1, "token", server.baseUrl());
+    std::vector<Case> cases = makeCases(api);
+
+    std::printf("%zu iterations, %zu in flight, %lld us server latency, %zu records per page\n",
+                settings.iterations, settings.concurrency,
+                static_cast<long long>(settings.server.latency.count()), settings.server.historyRecords);
+    std::printf("%-24s %10s %9s %9s %8s %10s %10s\n",
+                "method", "rps", "p50 us", "p99 us", "allocs", "async rps", "decode MB/s");
+
+    iris::bench::trackAllocations();
+    for (const Case& c : cases) {
+        if (!settings.filter.empty() && c.name.find(settings.filter) == std::string::npos) {
+            continue;
+        }
+        // Warm the connection and the pooled buffers.
+        for (int i = 0; i < 50; ++i) {
+            c.call();
+        }
+        BlockingResult blocking = runBlocking(c, settings.iterations);
+        double asyncRps = runAsync(c, settings.iterations, settings.concurrency);
+        double decodeMBps = runDecode(c, server.payload(c.id));
+        std::printf("%-24s %10.0f %9llu %9llu %8.2f %10.0f %10.1f\n", c.name.c_str(), blocking.rps,
+                    static_cast<unsigned long long>(blocking.p50),
+                    static_cast<unsigned long long>(blocking.p99), blocking.allocsPerCall, asyncRps,
+                    decodeMBps);
+    }
+    iris::bench::trackAllocations(false);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "mock_iris.hpp"
+#include <sstream>
+#include <thread>
+
+namespace iris {
+namespace bench {
+
+namespace {
+
+std::string makeOrders(std::string_view side, size_t count, double firstPrice, double step) {
+    std::ostringstream out;
+    out << '"' << side << "\":[";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) out << ',';
+        out << R"({"id":)" << 5000 + i << R"(,"volume":)" << 10 + i % 90
+            << R"(,"price":)" << firstPrice + step * static_cast<double>(i) << '}';
+    }
+    out << ']';
+    return out.str();
+}
+
+std::string makePayload(EndpointId id, const MockIrisOptions& options) {
+    switch (id) {
+    case EndpointId::BALANCE:
+        return R"({"gold":12,"sweets":1534.25,"donate_score":40})";
+    case EndpointId::SWEETS_HISTORY:
+    case EndpointId::GOLD_HISTORY:
+    case EndpointId::DONATE_SCORE_HISTORY:
+        return makeHistoryPage(options.historyRecords);
+    case EndpointId::GET_UPDATES:
+        return makeUpdatesPage(options.updateRecords);
+    case EndpointId::IRIS_AGENTS: {
+        std::ostringstream out;
+        out << '[';
+        for (size_t i = 0; i < options.agents; ++i) {
+            out << (i ? "," : "") << 700000 + i;
+        }
+        out << ']';
+        return out.str();
+    }
+    case EndpointId::USER_REG:
+        return R"({"timestamp":1600000000})";
+    case EndpointId::USER_SPAM:
+        return R"({"spam":false,"ignore":false,"scam":false})";
+    case EndpointId::USER_ACTIVITY:
+        return R"({"messages":1200,"characters":54000,"forwarded":12,"replies":300,"mentions":45})";
+    case EndpointId::USER_STARS:
+        return R"({"stars":3,"rank":"silver"})";
+    case EndpointId::USER_POCKET:
+        return R"({"gold":5,"sweets":120.5,"donate_score":7})";
+    case EndpointId::TRADE_BUY:
+        return R"({"done_volume":5,"sweets_spent":2.5,"new_order":{"id":9001,"volume":5,"price":0.5}})";
+    case EndpointId::TRADE_SELL:
+        return R"({"done_volume":5,"sweets_earned":2.5,"new_order":{"id":9002,"volume":5,"price":0.6}})";
+    case EndpointId::TRADE_MY_ORDERS:
+        return "{" + makeOrders("buy", options.orders, 0.40, -0.01) + ","
+            + makeOrders("sell", options.orders, 0.60, 0.01) + "}";
+    case EndpointId::TRADE_CANCEL_PRICE:
+    case EndpointId::TRADE_CANCEL_ALL:
+    case EndpointId::TRADE_CANCEL_PART:
+        return R"({"cancelled_orders":[5001,5002],"cancelled_volume":25})";
+    default:
+        return R"({"result":1})";
+    }
+}
+
+std::array<std::string, kEndpointCount> makePayloads(const MockIrisOptions& options) {
+    std::array<std::string, kEndpointCount> payloads;
+    for (const EndpointRoute& route : kEndpointRoutes) {
+        payloads[static_cast<size_t>(route.id)] = makePayload(route.id, options);
+    }
+    return payloads;
+}
+
+} // namespace
+
+std::string makeHistoryPage(size_t records) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < records; ++i) {
+        if (i > 0) out << ",";
+        out << R"({"user_id":)" << 100000 + i
+            << R"(,"type":"give","amount":)" << (i % 500) + 1;
+        if (i % 3 == 0) {
+            out << R"(,"comment":"payout for campaign )" << i << R"(")";
+        } else {
+            out << R"(,"comment":null)";
+        }
+        out << R"(,"timestamp":)" << 1700000000 + i << "}";
+    }
+    out << "]";
+    return out.str();
+}
+
+std::string makeUpdatesPage(size_t records) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < records; ++i) {
+        if (i > 0) out << ",";
+        out << R"({"update_id":)" << i << R"(,"type":"sweets_log","user_id":)" << 100000 + i
+            << R"(,"amount":)" << (i % 50) + 1 << R"(,"comment":null,"timestamp":)"
+            << 1700000000 + i << "}";
+    }
+    out << "]";
+    return out.str();
+}
+
+MockIris::MockIris(const MockIrisOptions& options)
+    : options_(options)
+    , payloads_(makePayloads(options))
+    , server_([this](std::string_view target, std::string& body) { handle(target, body); }) {
+}
+
+void MockIris::handle(std::string_view target, std::string& body) {
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    if (options_.latency.count() > 0) {
+        std::this_thread::sleep_for(options_.latency);
+    }
+
+    std::string_view path = target.substr(0, target.find('?'));
+    if (!path.empty() && path.front() == '/') {
+        path.remove_prefix(1);
+    }
+    for (const EndpointRoute& route : kEndpointRoutes) {
+        if (route.path == path) {
+            body.append(payload(route.id));
+            return;
+        }
+    }
+    body.append(R"({"error":{"code":404,"description":"Unknown method"}})");
+}
+
+} // namespace bench
+} // namespace iris
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "mock_server.hpp"
+#include <iris/endpoints.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace iris {
+namespace bench {
+
+struct MockIrisOptions {
+    // Added to every response, on the server's connection thread.
+    std::chrono::microseconds latency{0};
+    // Records in history pages, update pages and order lists.
+    size_t historyRecords = 50;
+    size_t updateRecords = 50;
+    size_t orders = 20;
+    size_t agents = 10;
+};
+
+// Loopback emulation of the Iris v0.3 API: every route in kEndpointRoutes
+// answers with a canned, well-formed payload of the configured size.
+// Payloads are built once, so the server adds almost no work per request.
+class MockIris {
+public:
+    explicit MockIris(const MockIrisOptions& options = {});
+
+    std::string baseUrl() const { return server_.baseUrl(); }
+    const std::string& payload(EndpointId id) const { return payloads_[static_cast<size_t>(id)]; }
+    size_t requests() const { return requests_.load(std::memory_order_relaxed); }
+
+private:
+    void handle(std::string_view target, std::string& body);
+
+    MockIrisOptions options_;
+    std::array<std::string, kEndpointCount> payloads_;
+    std::atomic<size_t> requests_{0};
+    // Last: starts serving once the payloads exist.
+    MockServer server_;
+};
+
+std::string makeHistoryPage(size_t records);
+std::string makeUpdatesPage(size_t records);
+
+} // namespace bench
+} // namespace iris
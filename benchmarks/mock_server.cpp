@@ -0,0 +1,216 @@
+#include "mock_server.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketLength = int;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketLength = socklen_t;
+#endif
+
+namespace iris {
+namespace bench {
+
+namespace {
+
+#ifdef _WIN32
+using Socket = SOCKET;
+
+struct WinsockInit {
+    WinsockInit() {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    }
+    ~WinsockInit() { WSACleanup(); }
+};
+
+constexpr Socket kInvalidSocket = INVALID_SOCKET;
+
+constexpr int kSendFlags = 0;
+
+void closeSocket(Socket s) { closesocket(s); }
+void shutdownSocket(Socket s) { shutdown(s, SD_BOTH); }
+#else
+using Socket = int;
+
+constexpr Socket kInvalidSocket = -1;
+// Clients may hang up mid-response (e.g. an abandoned hedge); that must not
+// raise SIGPIPE.
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+void closeSocket(Socket s) { close(s); }
+void shutdownSocket(Socket s) { shutdown(s, SHUT_RDWR); }
+#endif
+
+bool sendAll(Socket s, const char* data, size_t length) {
+    while (length > 0) {
+        auto sent = send(s, data, static_cast<int>(length), kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+size_t contentLength(std::string_view headers) {
+    static constexpr std::string_view kName = "content-length:";
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string_view::npos) {
+        pos += 2;
+        if (headers.size() - pos < kName.size()) {
+            break;
+        }
+        bool match = true;
+        for (size_t i = 0; i < kName.size(); ++i) {
+            char c = headers[pos + i];
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            if (c != kName[i]) {
+                match = false;
+                break;
+            }
+        }
+        if (match) {
+            return std::strtoul(headers.data() + pos + kName.size(), nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+MockServer::MockServer(Handler handler)
+    : MockServer(StatusHandler{[handler = std::move(handler)](std::string_view target, std::string& body) {
+          handler(target, body);
+          return 200;
+      }}) {
+}
+
+MockServer::MockServer(StatusHandler handler)
+    : handler_(std::move(handler)) {
+#ifdef _WIN32
+    static WinsockInit winsock;
+#endif
+    Socket listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    SocketLength length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), length) != 0
+        || listen(listener, 1024) != 0
+        || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        closeSocket(listener);
+        throw std::runtime_error("Failed to start mock server");
+    }
+    listener_ = static_cast<long long>(listener);
+    port_ = ntohs(address.sin_port);
+    acceptor_ = std::thread([this] { acceptLoop(); });
+}
+
+MockServer::~MockServer() {
+    stopping_ = true;
+    shutdownSocket(static_cast<Socket>(listener_));
+    closeSocket(static_cast<Socket>(listener_));
+    acceptor_.join();
+
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (long long client : clients_) {
+            shutdownSocket(static_cast<Socket>(client));
+        }
+        workers.swap(workers_);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::string MockServer::baseUrl() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+void MockServer::acceptLoop() {
+    while (!stopping_) {
+        Socket client = accept(static_cast<Socket>(listener_), nullptr, nullptr);
+        if (stopping_) {
+            if (client != kInvalidSocket) closeSocket(client);
+            break;
+        }
+        if (client == kInvalidSocket) {
+            continue;
+        }
+        int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY,
+                   reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.push_back(static_cast<long long>(client));
+        workers_.emplace_back([this, client] { serve(static_cast<long long>(client)); });
+    }
+}
+
+void MockServer::serve(long long socket) {
+    auto s = static_cast<Socket>(socket);
+    std::string input;
+    std::string body;
+    std::string head;
+    char chunk[16 * 1024];
+
+    for (;;) {
+        size_t headerEnd;
+        while ((headerEnd = input.find("\r\n\r\n")) == std::string::npos) {
+            auto received = recv(s, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                goto done;
+            }
+            input.append(chunk, static_cast<size_t>(received));
+        }
+
+        size_t requestEnd = headerEnd + 4 + contentLength(std::string_view(input).substr(0, headerEnd));
+        while (input.size() < requestEnd) {
+            auto received = recv(s, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                goto done;
+            }
+            input.append(chunk, static_cast<size_t>(received));
+        }
+
+        std::string_view line = std::string_view(input).substr(0, input.find("\r\n"));
+        size_t targetStart = line.find(' ') + 1;
+        std::string_view target = line.substr(targetStart, line.rfind(' ') - targetStart);
+
+        body.clear();
+        int status = handler_.handle(target, body);
+
+        head.assign("HTTP/1.1 ").append(std::to_string(status)).append(status == 200 ? " OK" : " Mock");
+        head.append("\r\nContent-Type: application/json\r\nContent-Length: ");
+        head.append(std::to_string(body.size())).append("\r\n\r\n");
+        if (!sendAll(s, head.data(), head.size()) || !sendAll(s, body.data(), body.size())) {
+            break;
+        }
+        input.erase(0, requestEnd);
+    }
+
+done:
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.erase(std::remove(clients_.begin(), clients_.end(), socket), clients_.end());
+    closeSocket(s);
+}
+
+} // namespace bench
+} // namespace iris
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace iris {
+namespace bench {
+
+// Minimal HTTP/1.1 server on 127.0.0.1 for benchmarks and tests. Every
+// request is answered with the body returned by the handler, with status 200
+// unless a StatusHandler picks another; connections are kept alive, one
+// thread per connection.
+class MockServer {
+public:
+    // Receives the request target (path + query) and fills `body`, which is
+    // reused between requests on the same connection.
+    using Handler = std::function<void(std::string_view target, std::string& body)>;
+    // Same, returning the HTTP status to answer with.
+    struct StatusHandler {
+        std::function<int(std::string_view target, std::string& body)> handle;
+    };
+
+    explicit MockServer(Handler handler);
+    explicit MockServer(StatusHandler handler);
+    ~MockServer();
+
+    MockServer(const MockServer&) = delete;
+    MockServer& operator=(const MockServer&) = delete;
+
+    unsigned short port() const { return port_; }
+    std::string baseUrl() const;
+
+private:
+    void acceptLoop();
+    void serve(long long socket);
+
+    StatusHandler handler_;
+    long long listener_;
+    unsigned short port_;
+    std::atomic<bool> stopping_{false};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<std::thread> workers_;
+    std::vector<long long> clients_;
+};
+
+} // namespace bench
+} // namespace iris
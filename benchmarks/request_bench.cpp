@@ -0,0 +1,49 @@
+#include "bench_util.hpp"
+#include "mock_server.hpp"
+#include <iris/iris_api.hpp>
+#include <iostream>
+
+// Steady-state cost of one blocking request over a kept-alive loopback
+// connection. "allocs" counts operator new on the calling thread, "curl
+// mallocs" counts libcurl's own allocations.
+int main() {
+    iris::bench::countCurlAllocations();
+
+    iris::bench::MockServer server([](std::string_view target, std::string& body) {
+        if (target.find("/balance") != std::string_view::npos) {
+            body.append(R"({"gold":12,"sweets":1534.25,"donate_score":40})");
+        } else {
+            body.append(R"({"result":1})");
+        }
+    });
+
+    iris::IrisApi api(1, "token", server.baseUrl());
+    const std::string comment = "benchmark payout";
+
+    for (int i = 0; i < 200; ++i) {
+        api.getBalance();
+        api.giveSweets(10, 42, comment);
+    }
+
+    iris::bench::trackAllocations();
+    constexpr size_t kIterations = 5000;
+
+    auto balance = iris::bench::measure(kIterations, 1, [&] {
+        if (!api.getBalance()) {
+            std::cerr << "getBalance failed" << std::endl;
+            std::exit(1);
+        }
+    });
+    iris::bench::report("getBalance", balance);
+
+    auto give = iris::bench::measure(kIterations, 1, [&] {
+        if (!api.giveSweets(10, 42, comment)) {
+            std::cerr << "giveSweets failed" << std::endl;
+            std::exit(1);
+        }
+    });
+    iris::bench::report("giveSweets", give);
+
+    iris::bench::trackAllocations(false);
+    return 0;
+}
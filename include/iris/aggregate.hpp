@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "record_view.hpp"
+
+namespace iris {
+
+// Instruction set used by the aggregation kernels. The best one the CPU
+// supports is picked at first use; setSimdLevel() can lower it (e.g. to
+// compare against the scalar path).
+enum class SimdLevel {
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+SimdLevel supportedSimdLevel();
+SimdLevel simdLevel();
+// Clamped to supportedSimdLevel(). Not meant to be changed while kernels run.
+void setSimdLevel(SimdLevel level);
+
+// Rows kept by a kernel; absent fields match everything.
+struct RecordFilter {
+    int64_t fromTimestamp = std::numeric_limits<int64_t>::min();
+    int64_t toTimestamp = std::numeric_limits<int64_t>::max();  // exclusive
+    std::optional<uint8_t> type;
+    std::optional<int64_t> userId;
+};
+
+struct Totals {
+    int64_t amount = 0;
+    size_t count = 0;
+};
+
+struct TimeBucket {
+    int64_t start;  // multiple of the bucket width
+    Totals totals;
+};
+
+struct UserTotal {
+    int64_t userId;
+    Totals totals;
+};
+
+// Sum and count of the matching rows in one pass.
+Totals total(const RecordView& view, const RecordFilter& filter = {});
+
+// Replaces `rows` with the indices of the matching rows, ascending.
+void filterRows(const RecordView& view, const RecordFilter& filter, std::vector<uint32_t>& rows);
+
+// Indexed by type code.
+std::array<Totals, TypeDictionary::kMaxTypes> totalsByType(const RecordView& view,
+                                                           const RecordFilter& filter = {});
+
+// Buckets of `bucketSeconds` aligned to the epoch, ascending, empty ones
+// omitted. Fastest when the rows are roughly ordered by time, as stores are.
+std::vector<TimeBucket> totalsByTime(const RecordView& view, int64_t bucketSeconds,
+                                     const RecordFilter& filter = {});
+
+// Ordered by userId.
+std::vector<UserTotal> totalsByUser(const RecordView& view, const RecordFilter& filter = {});
+
+// The `n` users with the largest total amount, largest first.
+std::vector<UserTotal> topUsers(const RecordView& view, size_t n, const RecordFilter& filter = {});
+
+} // namespace iris
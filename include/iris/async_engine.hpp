@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "http.hpp"
+
+namespace iris {
+
+struct TransferOptions {
+    // Replaces the default 30s CURLOPT_TIMEOUT when non-zero.
+    std::chrono::milliseconds timeout{0};
+    // Start the transfer no sooner than this after submit().
+    std::chrono::milliseconds delay{0};
+    // When non-zero and the transfer is still running after this long, a
+    // duplicate is started on a fresh connection; the first successful
+    // answer completes the request and the other transfer is abandoned.
+    // Only for idempotent requests.
+    std::chrono::milliseconds hedgeAfter{0};
+    // Told whether the duplicate won, for requests that were hedged.
+    std::function<void(bool won)> onHedge;
+};
+
+// Event loop over a curl_multi handle. Transfers to the same host are
+// multiplexed over a single HTTP/2 connection where the server allows it.
+// Completions are invoked on the loop thread and must not block.
+class AsyncEngine {
+public:
+    using Completion = std::function<void(HttpResponse)>;
+
+    // `share`, when given, lends its DNS and TLS session caches to every transfer.
+    explicit AsyncEngine(CURLSH* share = nullptr);
+    // Transfers not yet answered complete with CURLE_ABORTED_BY_CALLBACK, as
+    // does anything submitted from then on. A completion may destroy the
+    // engine (say, by dropping its last owner); the loop thread is then
+    // detached rather than joined.
+    ~AsyncEngine();
+
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    void submit(HttpRequest request, Completion done, TransferOptions options = {});
+    size_t inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+
+private:
+    struct Transfer;
+
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    void start(std::unique_ptr<Transfer> transfer);
+    void finish(CURL* handle, CURLcode code);
+    // Starts due delayed transfers and hedges; returns the poll timeout.
+    int runTimers();
+    void abandon(Transfer* transfer);
+    // Completes everything pending, delayed or running as aborted.
+    void cancelAll();
+
+    CURLM* multi_;
+    CURLSH* share_;
+    curl_slist* postHeaders_;
+    std::mutex mutex_;
+    std::deque<std::unique_ptr<Transfer>> pending_;
+    // Taken from pending_ and not yet started; only touched by the loop.
+    std::deque<std::unique_ptr<Transfer>> batch_;
+    std::vector<std::unique_ptr<Transfer>> delayed_;
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> active_;
+    std::vector<CURL*> idle_;
+    std::atomic<bool> stopping_;
+    std::atomic<size_t> inFlight_;
+    // Set by the destructor when it runs on the loop thread.
+    bool* destroyed_ = nullptr;
+    std::thread thread_;
+};
+
+} // namespace iris
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include "iris_api.hpp"
+
+namespace iris {
+
+// Server balance minus ledger balance, as found by BalanceLedger::reconcile().
+struct BalanceDrift {
+    int gold = 0;
+    double sweets = 0;
+    int donateScore = 0;
+
+    bool empty() const { return gold == 0 && sweets == 0 && donateScore == 0; }
+};
+
+struct BalanceLedgerStats {
+    uint64_t applied = 0;
+    uint64_t reconciles = 0;
+    // Reconciles that found a difference.
+    uint64_t drifts = 0;
+    // Reconciles dropped because events were applied while getBalance was
+    // in flight.
+    uint64_t skipped = 0;
+    // Updates ignored because their update_id was already applied.
+    uint64_t duplicates = 0;
+};
+
+// How one UpdatesLog entry moves the balance; nullopt leaves it alone.
+using UpdateRule = std::function<std::optional<std::pair<Currency, double>>(const UpdatesLog&)>;
+
+struct BalanceLedgerOptions {
+    // Age after which reconcileIfStale() refreshes from getBalance.
+    std::chrono::milliseconds reconcileInterval{std::chrono::seconds(30)};
+    // Sweets differences below this count as rounding, not drift.
+    double sweetsTolerance = 1e-6;
+    // Defaults to crediting "sweets_log", "gold_log" and "donate_score_log"
+    // updates (incoming transfers) by their amount.
+    UpdateRule updateRule;
+};
+
+// Local copy of the bot balance, seeded from one getBalance() and then
+// moved by the bot's own successful gives and trade fills and by incoming
+// transfers from the updates log, so payout decisions need no round trip.
+// Reads are lock-free atomic loads; writers serialize on a mutex.
+//
+// Only known movements are applied. Funds held by resting trade orders,
+// fees, and anything done outside this ledger show up as drift at the next
+// reconcile(), which then adopts the server balance; call
+// reconcileIfStale() once per tick. Like OrderBook::reconcile(), a
+// reconcile should not overlap applied events: if one lands while
+// getBalance is in flight, the comparison is ambiguous and it is skipped.
+class BalanceLedger {
+public:
+    explicit BalanceLedger(IrisApi& api, const BalanceLedgerOptions& options = {});
+
+    BalanceLedger(const BalanceLedger&) = delete;
+    BalanceLedger& operator=(const BalanceLedger&) = delete;
+
+    // IrisApi gives, folded into the ledger when they succeed.
+    std::optional<Response> giveSweets(int count, long userId, const std::string& comment = "",
+                                       bool withoutDonateScore = true);
+    std::optional<Response> giveGold(int count, long userId, const std::string& comment = "",
+                                     bool withoutDonateScore = true);
+    std::optional<Response> giveDonateScore(int count, long userId, const std::string& comment = "");
+
+    // Adopts the server balance. The first successful reconcile seeds the
+    // ledger and reports no drift. Returns nullopt, leaving the ledger
+    // untouched, when the request fails or was overlapped.
+    std::optional<BalanceDrift> reconcile();
+    // reconcile() when unseeded or the last one is older than the interval.
+    std::optional<BalanceDrift> reconcileIfStale();
+
+    // For async gives: debits `count` unless the response carries an error.
+    void applyGive(Currency currency, int count, const Response& response);
+    void applyBuy(const BuyTradesResponse& response);
+    void applySell(const SellTradesResponse& response);
+    // Applies each update_id once; older or repeated ids are ignored.
+    void applyUpdate(const UpdatesLog& update);
+    void applyBalance(const BalanceData& balance);
+
+    bool seeded() const { return seeded_.load(std::memory_order_acquire); }
+    int gold() const { return gold_.load(std::memory_order_acquire); }
+    double sweets() const { return sweets_.load(std::memory_order_acquire); }
+    int donateScore() const { return donateScore_.load(std::memory_order_acquire); }
+    double balance(Currency currency) const;
+    // Whether the ledger holds at least `amount` of `currency`.
+    bool covers(Currency currency, double amount) const { return balance(currency) >= amount; }
+    // All three currencies as of one moment.
+    BalanceData snapshot() const;
+
+    BalanceLedgerStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Callers hold mutex_.
+    void add(Currency currency, double amount);
+    void beginWrite();
+    void endWrite();
+
+    IrisApi& api_;
+    BalanceLedgerOptions options_;
+
+    std::atomic<int> gold_{0};
+    std::atomic<double> sweets_{0};
+    std::atomic<int> donateScore_{0};
+    std::atomic<bool> seeded_{false};
+    // Odd while a write is in progress; snapshot() retries across it.
+    std::atomic<uint64_t> sequence_{0};
+
+    mutable std::mutex mutex_;
+    // Bumped by every applied event; lets reconcile() detect overlaps.
+    uint64_t events_ = 0;
+    std::optional<long> lastUpdate_;
+    std::optional<Clock::time_point> reconciled_;
+    BalanceLedgerStats stats_;
+};
+
+} // namespace iris
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "connection_pool.hpp"
+#include "iris_api.hpp"
+#include "request_scheduler.hpp"
+
+namespace iris {
+
+class AsyncEngine;
+
+struct BotManagerOptions {
+    // Shared by all bots: the common Iris budget and in-flight cap.
+    SchedulerOptions scheduler;
+    // Applied to every bot; null leaves them off.
+    std::shared_ptr<ReadPolicy> readPolicy;
+    std::shared_ptr<Metrics> metrics;
+};
+
+// Hosts many bots on one connection pool, one async event loop and one
+// scheduler. A bot is only its credentials and URL prefixes; sockets, TLS
+// sessions, DNS cache and threads are shared, so N bots cost two threads
+// and the pool's warm connections instead of N of each. The scheduler
+// shares the common budget fairly between bots by their weights and applies
+// each bot's own budget on top. Bots can be added and removed at any time
+// from any thread.
+class BotManager {
+public:
+    explicit BotManager(const BotManagerOptions& options = {});
+    ~BotManager();
+
+    BotManager(const BotManager&) = delete;
+    BotManager& operator=(const BotManager&) = delete;
+
+    // Adds a bot and returns its client, which is used like a standalone
+    // IrisApi. Throws std::invalid_argument if `botId` is already hosted.
+    std::shared_ptr<IrisApi> addBot(long botId, const std::string& irisToken, const OwnerBudget& budget = {},
+                                    const std::string& baseUrl = "");
+    // Drops the bot and its queued requests, which complete as cancelled; it
+    // stops once the last reference to its client is gone, after its pending
+    // async calls finish. Returns false if not hosted.
+    bool removeBot(long botId);
+    // Replaces the budget of a hosted bot. Returns false if not hosted.
+    bool setBudget(long botId, const OwnerBudget& budget);
+
+    // Null if `botId` is not hosted.
+    std::shared_ptr<IrisApi> bot(long botId) const;
+    std::vector<long> botIds() const;
+    size_t size() const;
+
+    const std::shared_ptr<ConnectionPool>& pool() const { return pool_; }
+    const std::shared_ptr<RequestScheduler>& scheduler() const { return scheduler_; }
+    const std::shared_ptr<AsyncEngine>& engine() const { return engine_; }
+
+private:
+    BotManagerOptions options_;
+    std::shared_ptr<ConnectionPool> pool_;
+    std::shared_ptr<RequestScheduler> scheduler_;
+    std::shared_ptr<AsyncEngine> engine_;
+    mutable std::mutex mutex_;
+    std::unordered_map<long, std::shared_ptr<IrisApi>> bots_;
+};
+
+} // namespace iris
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.hpp"
+
+namespace iris {
+
+// Variable-length value kept in a store's string heap.
+struct StringRef {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t present;
+};
+
+struct ColumnSpec {
+    const char* name;
+    uint32_t width;
+};
+
+// Directory of memory-mapped files making up one append-only table: a small
+// header, one fixed-width file per column and a string heap. Opening maps the
+// files and reads nothing else, whatever the row count; a column file shorter
+// than count * width or a heap shorter than its recorded size throws
+// std::runtime_error. Column files grow by doubling. Appends write the rows first and publish the new count in the
+// header last, so a torn append is simply not visible on reopen. Files use
+// the host byte order. One writer at a time; readers must not overlap writes.
+class ColumnStore {
+public:
+    ColumnStore(const std::string& directory, uint32_t kind, std::vector<ColumnSpec> columns);
+
+    size_t size() const;
+    // Sync position owned by the caller (e.g. last timestamp or update_id).
+    int64_t cursor() const;
+
+    template <typename T>
+    const T* column(size_t index) const {
+        return reinterpret_cast<const T*>(columns_[index].data());
+    }
+    template <typename T>
+    T* column(size_t index) {
+        return reinterpret_cast<T*>(columns_[index].data());
+    }
+
+    // Makes room for `records` rows in total; invalidates column pointers.
+    void reserve(size_t records);
+    // Copies `value` into the heap.
+    StringRef appendString(std::string_view value);
+    StringRef nullString() const { return StringRef{0, 0, 0}; }
+    std::string_view string(const StringRef& ref) const;
+
+    // Makes rows [size(), count) visible and records the new cursor.
+    void publish(size_t count, int64_t cursor);
+    void flush();
+
+private:
+    struct Header;
+
+    Header& header() const;
+    void reserveHeap(size_t bytes);
+
+    std::vector<ColumnSpec> specs_;
+    MappedFile header_;
+    std::vector<MappedFile> columns_;
+    MappedFile heap_;
+    uint64_t heapUsed_;
+};
+
+} // namespace iris
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <curl/curl.h>
+#include "http.hpp"
+
+namespace iris {
+
+// Pool of easy handles that share DNS and TLS session caches through one
+// CURLSH. A handle keeps its live connection while idle in the pool, so any
+// thread that leases it skips the TCP and TLS handshake. Each handle carries
+// its own RequestContext, whose buffers are reused across requests.
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease(ConnectionPool* pool, RequestContext* context) : pool_(pool), context_(context) {}
+        Lease(Lease&& other) noexcept : pool_(other.pool_), context_(other.context_) {
+            other.context_ = nullptr;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease() {
+            if (context_) {
+                pool_->release(context_);
+            }
+        }
+
+        CURL* get() const { return context_->curl; }
+        RequestContext& context() const { return *context_; }
+        std::string_view body() const { return context_->response.body; }
+
+    private:
+        ConnectionPool* pool_;
+        RequestContext* context_;
+    };
+
+    ConnectionPool();
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Returns a reset handle already attached to the shared caches, with a
+    // cleared context.
+    Lease acquire();
+    CURLSH* share() const { return share_; }
+    curl_slist* postHeaders() const { return postHeaders_; }
+
+private:
+    static void lockShared(CURL* handle, curl_lock_data data,
+                           curl_lock_access access, void* userptr);
+    static void unlockShared(CURL* handle, curl_lock_data data, void* userptr);
+
+    void release(RequestContext* context);
+
+    CURLSH* share_;
+    curl_slist* postHeaders_;
+    std::mutex shareLocks_[CURL_LOCK_DATA_LAST];
+    std::mutex mutex_;
+    std::vector<RequestContext*> idle_;
+    std::vector<std::unique_ptr<RequestContext>> contexts_;
+};
+
+} // namespace iris
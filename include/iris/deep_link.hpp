@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iris {
+
+enum class Currency;
+enum class BotPermission;
+
+// One link of a bulk generateDeepLinks() call.
+struct DeepLinkItem {
+    Currency currency;
+    int count;
+    std::string comment;
+};
+
+// Links generated in bulk, stored back to back in one buffer. Link `i`
+// spans [offset(i), offset(i + 1)).
+class DeepLinks {
+public:
+    size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+    bool empty() const { return size() == 0; }
+    std::string_view operator[](size_t index) const {
+        return std::string_view(buffer_.get() + offsets_[index], offsets_[index + 1] - offsets_[index]);
+    }
+    size_t offset(size_t index) const { return offsets_[index]; }
+    // All links, unseparated.
+    std::string_view buffer() const { return std::string_view(buffer_.get(), offsets_.empty() ? 0 : offsets_.back()); }
+
+private:
+    friend DeepLinks makeDeepLinks(long botId, const std::vector<DeepLinkItem>& items);
+
+    // Not std::string: resizing one would zero the buffer before it is written.
+    std::unique_ptr<char[]> buffer_;
+    std::vector<size_t> offsets_;
+};
+
+// Why `count` / `comment` cannot go into a transfer link, or null. Comments
+// are checked against a character table: letters, digits and underscore.
+const char* deepLinkError(int count, std::string_view comment);
+
+// Appends the transfer link for bot `botId`. Arguments must have passed
+// deepLinkError().
+void appendDeepLink(std::string& out, long botId, Currency currency, int count, std::string_view comment);
+void appendBotPermissionsDeepLink(std::string& out, long botId, const std::vector<BotPermission>& permissions);
+
+// Validates every item, then writes all links into one exactly sized
+// buffer; throws std::invalid_argument naming the first bad item.
+DeepLinks makeDeepLinks(long botId, const std::vector<DeepLinkItem>& items);
+
+} // namespace iris
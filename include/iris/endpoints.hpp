@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "http.hpp"
+#include "json_decode.hpp"
+#include "models.hpp"
+
+namespace iris {
+
+enum class EndpointId : size_t {
+    GIVE_SWEETS,
+    GIVE_GOLD,
+    GIVE_DONATE_SCORE,
+    BALANCE,
+    SWEETS_HISTORY,
+    GOLD_HISTORY,
+    DONATE_SCORE_HISTORY,
+    POCKET_ENABLE,
+    POCKET_DISABLE,
+    POCKET_ALLOW_ALL,
+    POCKET_DENY_ALL,
+    POCKET_ALLOW_USER,
+    POCKET_DENY_USER,
+    GET_UPDATES,
+    IRIS_AGENTS,
+    USER_REG,
+    USER_SPAM,
+    USER_ACTIVITY,
+    USER_STARS,
+    USER_POCKET,
+    TRADE_BUY,
+    TRADE_SELL,
+    TRADE_MY_ORDERS,
+    TRADE_CANCEL_PRICE,
+    TRADE_CANCEL_ALL,
+    TRADE_CANCEL_PART,
+    COUNT
+};
+
+inline constexpr size_t kEndpointCount = static_cast<size_t>(EndpointId::COUNT);
+
+// Scheduling class of an endpoint, highest priority first; see RequestScheduler.
+enum class RequestClass : size_t {
+    TRADE,
+    PAYOUT,
+    INFO,
+    HISTORY,
+    COUNT
+};
+
+inline constexpr size_t kRequestClassCount = static_cast<size_t>(RequestClass::COUNT);
+
+struct EndpointRoute {
+    EndpointId id;
+    std::string_view path;
+    bool isPost;
+    RequestClass requestClass;
+    // Safe to send more than once (hedged or retried); see ReadPolicy.
+    bool idempotent;
+};
+
+// Indexed by EndpointId. IrisApi turns every path into a full URL prefix once,
+// in its constructor.
+inline constexpr std::array<EndpointRoute, kEndpointCount> kEndpointRoutes = {{
+    {EndpointId::GIVE_SWEETS, "pocket/sweets/give", true, RequestClass::PAYOUT, false},
+    {EndpointId::GIVE_GOLD, "pocket/gold/give", true, RequestClass::PAYOUT, false},
+    {EndpointId::GIVE_DONATE_SCORE, "pocket/donate_score/give", true, RequestClass::PAYOUT, false},
+    {EndpointId::BALANCE, "pocket/balance", false, RequestClass::INFO, true},
+    {EndpointId::SWEETS_HISTORY, "pocket/sweets/history", false, RequestClass::HISTORY, true},
+    {EndpointId::GOLD_HISTORY, "pocket/gold/history", false, RequestClass::HISTORY, true},
+    {EndpointId::DONATE_SCORE_HISTORY, "pocket/donate_score/history", false, RequestClass::HISTORY, true},
+    {EndpointId::POCKET_ENABLE, "pocket/enable", true, RequestClass::INFO, false},
+    {EndpointId::POCKET_DISABLE, "pocket/disable", true, RequestClass::INFO, false},
+    {EndpointId::POCKET_ALLOW_ALL, "pocket/allow_all", true, RequestClass::INFO, false},
+    {EndpointId::POCKET_DENY_ALL, "pocket/deny_all", true, RequestClass::INFO, false},
+    {EndpointId::POCKET_ALLOW_USER, "pocket/allow_user", true, RequestClass::INFO, false},
+    {EndpointId::POCKET_DENY_USER, "pocket/deny_user", true, RequestClass::INFO, false},
+    {EndpointId::GET_UPDATES, "getUpdates", true, RequestClass::HISTORY, true},
+    {EndpointId::IRIS_AGENTS, "iris_agents", false, RequestClass::INFO, true},
+    {EndpointId::USER_REG, "user_info/reg", true, RequestClass::INFO, true},
+    {EndpointId::USER_SPAM, "user_info/spam", true, RequestClass::INFO, true},
+    {EndpointId::USER_ACTIVITY, "user_info/activity", true, RequestClass::INFO, true},
+    {EndpointId::USER_STARS, "user_info/stars", true, RequestClass::INFO, true},
+    {EndpointId::USER_POCKET, "user_info/pocket", true, RequestClass::INFO, true},
+    {EndpointId::TRADE_BUY, "trade/buy", false, RequestClass::TRADE, false},
+    {EndpointId::TRADE_SELL, "trade/sell", false, RequestClass::TRADE, false},
+    {EndpointId::TRADE_MY_ORDERS, "trade/my_orders", false, RequestClass::TRADE, true},
+    {EndpointId::TRADE_CANCEL_PRICE, "trade/cancel_price", false, RequestClass::TRADE, false},
+    {EndpointId::TRADE_CANCEL_ALL, "trade/cancel_all", false, RequestClass::TRADE, false},
+    {EndpointId::TRADE_CANCEL_PART, "trade/cancel_part", false, RequestClass::TRADE, false},
+}};
+
+constexpr bool routesMatchIds() {
+    for (size_t i = 0; i < kEndpointCount; ++i) {
+        if (static_cast<size_t>(kEndpointRoutes[i].id) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(routesMatchIds(), "kEndpointRoutes must be ordered by EndpointId");
+
+constexpr bool isQueryKey(std::string_view key) {
+    if (key.empty()) {
+        return false;
+    }
+    for (char c : key) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '-' || c == '.' || c == '_' || c == '~';
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compile-time description of one endpoint: its route, the query keys its
+// values are bound to (in order) and the result type with its decoder. Keys
+// are checked while the constexpr descriptor is built, so they are written
+// into URLs without escaping.
+template <EndpointId Id, typename Result, size_t KeyCount>
+struct Endpoint {
+    using result_type = Result;
+    using TryDecoder = bool (*)(std::string_view body, Result& out, std::string& error);
+
+    static constexpr EndpointId id = Id;
+    static constexpr size_t keyCount = KeyCount;
+
+    std::array<std::string_view, KeyCount> keys;
+    TryDecoder tryDecode;
+
+    constexpr explicit Endpoint(std::array<std::string_view, KeyCount> keys,
+                                TryDecoder tryDecode = &tryDecodeResult<Result>)
+        : keys(keys), tryDecode(tryDecode) {
+        for (std::string_view key : keys) {
+            if (!isQueryKey(key)) {
+                throw std::logic_error("Query keys must consist of unreserved characters");
+            }
+        }
+    }
+
+    static constexpr const EndpointRoute& route() {
+        return kEndpointRoutes[static_cast<size_t>(Id)];
+    }
+};
+
+// A query value that is only sent when `present` is set.
+template <typename T>
+struct OptionalParam {
+    T value;
+    bool present;
+};
+
+template <typename T>
+OptionalParam<T> optionalParam(T value, bool present) {
+    return {value, present};
+}
+
+namespace endpoints {
+
+inline constexpr Endpoint<EndpointId::GIVE_SWEETS, std::optional<Response>, 4> kGiveSweets{
+    {"sweets", "user_id", "without_donate_score", "comment"}, &tryDecodeGiveResponse};
+inline constexpr Endpoint<EndpointId::GIVE_GOLD, std::optional<Response>, 4> kGiveGold{
+    {"gold", "user_id", "without_donate_score", "comment"}};
+inline constexpr Endpoint<EndpointId::GIVE_DONATE_SCORE, std::optional<Response>, 3> kGiveDonateScore{
+    {"amount", "user_id", "comment"}};
+
+inline constexpr Endpoint<EndpointId::BALANCE, std::optional<BalanceData>, 0> kBalance{{}};
+inline constexpr Endpoint<EndpointId::SWEETS_HISTORY, std::vector<HistoryData>, 1> kSweetsHistory{
+    {"offset"}};
+inline constexpr Endpoint<EndpointId::GOLD_HISTORY, std::vector<HistoryData>, 1> kGoldHistory{
+    {"offset"}};
+inline constexpr Endpoint<EndpointId::DONATE_SCORE_HISTORY, std::vector<HistoryData>, 1>
+    kDonateScoreHistory{{"offset"}};
+
+inline constexpr Endpoint<EndpointId::POCKET_ENABLE, std::optional<Response>, 0> kPocketEnable{{}};
+inline constexpr Endpoint<EndpointId::POCKET_DISABLE, std::optional<Response>, 0> kPocketDisable{{}};
+inline constexpr Endpoint<EndpointId::POCKET_ALLOW_ALL, std::optional<Response>, 0> kPocketAllowAll{{}};
+inline constexpr Endpoint<EndpointId::POCKET_DENY_ALL, std::optional<Response>, 0> kPocketDenyAll{{}};
+inline constexpr Endpoint<EndpointId::POCKET_ALLOW_USER, std::optional<Response>, 1> kPocketAllowUser{
+    {"user_id"}};
+inline constexpr Endpoint<EndpointId::POCKET_DENY_USER, std::optional<Response>, 1> kPocketDenyUser{
+    {"user_id"}};
+
+inline constexpr Endpoint<EndpointId::GET_UPDATES, std::vector<UpdatesLog>, 2> kGetUpdates{
+    {"offset", "limit"}};
+inline constexpr Endpoint<EndpointId::IRIS_AGENTS, std::vector<long>, 0> kIrisAgents{{}};
+
+inline constexpr Endpoint<EndpointId::USER_REG, std::optional<UserRegInfo>, 1> kUserReg{
+    {"user_id"}};
+inline constexpr Endpoint<EndpointId::USER_SPAM, std::optional<UserSpamInfo>, 1> kUserSpam{
+    {"user_id"}};
+inline constexpr Endpoint<EndpointId::USER_ACTIVITY, std::optional<UserActivityInfo>, 1> kUserActivity{
+    {"user_id"}};
+inline constexpr Endpoint<EndpointId::USER_STARS, std::optional<UserStarsInfo>, 1> kUserStars{
+    {"user_id"}};
+inline constexpr Endpoint<EndpointId::USER_POCKET, std::optional<UserPocketInfo>, 1> kUserPocket{
+    {"user_id"}};
+
+inline constexpr Endpoint<EndpointId::TRADE_BUY, std::optional<BuyTradesResponse>, 2> kTradeBuy{
+    {"price", "volume"}};
+inline constexpr Endpoint<EndpointId::TRADE_SELL, std::optional<SellTradesResponse>, 2> kTradeSell{
+    {"price", "volume"}};
+inline constexpr Endpoint<EndpointId::TRADE_MY_ORDERS, std::optional<OrdersResponse>, 0> kTradeMyOrders{
+    {}};
+inline constexpr Endpoint<EndpointId::TRADE_CANCEL_PRICE, std::optional<CancelTradesResponse>, 1>
+    kTradeCancelPrice{{"price"}};
+inline constexpr Endpoint<EndpointId::TRADE_CANCEL_ALL, std::optional<CancelTradesResponse>, 0>
+    kTradeCancelAll{{}};
+inline constexpr Endpoint<EndpointId::TRADE_CANCEL_PART, std::optional<CancelTradesResponse>, 2>
+    kTradeCancelPart{{"id", "volume"}};
+
+} // namespace endpoints
+
+namespace detail {
+
+template <typename T>
+void appendQueryParam(std::string& url, char& separator, std::string_view key, const T& value) {
+    url += separator;
+    url.append(key);
+    url += '=';
+    appendQueryValue(url, value);
+    separator = '&';
+}
+
+template <typename T>
+void appendQueryParam(std::string& url, char& separator, std::string_view key,
+                      const OptionalParam<T>& param) {
+    if (param.present) {
+        appendQueryParam(url, separator, key, param.value);
+    }
+}
+
+} // namespace detail
+
+// Writes `prefix` followed by the query string binding `values` to the
+// endpoint's keys, in order. Only the values are escaped.
+template <typename E, typename... Values>
+void buildEndpointUrl(std::string& url, std::string_view prefix, const E& endpoint,
+                      const Values&... values) {
+    static_assert(sizeof...(Values) == E::keyCount, "Pass exactly one value per endpoint key");
+    url.assign(prefix);
+    char separator = '?';
+    size_t index = 0;
+    (detail::appendQueryParam(url, separator, endpoint.keys[index++], values), ...);
+    (void)separator;
+    (void)index;
+}
+
+} // namespace iris
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define IRIS_HAS_COROUTINES 1
+#endif
+
+namespace iris {
+
+namespace detail {
+
+// Shared between the Future and the completion that fulfils it.
+template <typename T>
+class FutureState {
+public:
+    void set(T value) {
+        std::function<void()> next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            value_ = std::move(value);
+            next = std::move(continuation_);
+        }
+        ready_.notify_all();
+        if (next) {
+            next();
+        }
+    }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return value_.has_value();
+    }
+
+    // Registers `next` to run, on the fulfilling thread, once a value is
+    // set. Returns false without registering when one already is.
+    bool onReady(std::function<void()> next) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (value_) {
+            return false;
+        }
+        continuation_ = std::move(next);
+        return true;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return value_.has_value(); });
+    }
+
+    template <typename Clock, typename Duration>
+    bool waitUntil(const std::chrono::time_point<Clock, Duration>& deadline) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return ready_.wait_until(lock, deadline, [this] { return value_.has_value(); });
+    }
+
+    // Only valid once ready.
+    T take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::move(*value_);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::condition_variable ready_;
+    std::optional<T> value_;
+    std::function<void()> continuation_;
+};
+
+template <typename T>
+struct FutureAwaiter;
+
+} // namespace detail
+
+// Result of the IrisApi *Async() methods. Used like std::future (get(),
+// wait(), wait_for(), and it converts to one), and additionally:
+//   - then() runs a callback when the value arrives instead of blocking;
+//   - under C++20 it can be co_await-ed; the coroutine resumes on the thread
+//     that completed the request, which for IrisApi is the event loop.
+// Like std::future, the value can be taken once.
+template <typename T>
+class Future {
+public:
+    Future() = default;
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state) : state_(std::move(state)) {}
+
+    Future(Future&&) noexcept = default;
+    Future& operator=(Future&&) noexcept = default;
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    bool valid() const { return state_ != nullptr; }
+    bool ready() const { return state_ && state_->ready(); }
+
+    T get() {
+        auto state = release();
+        state->wait();
+        return state->take();
+    }
+
+    void wait() const {
+        check();
+        state_->wait();
+    }
+
+    template <typename Rep, typename Period>
+    std::future_status wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Clock, typename Duration>
+    std::future_status wait_until(const std::chrono::time_point<Clock, Duration>& deadline) const {
+        check();
+        return state_->waitUntil(deadline) ? std::future_status::ready : std::future_status::timeout;
+    }
+
+    // Hands the value to `next` instead of blocking: right away if it is
+    // already here, otherwise on the completing thread.
+    void then(std::function<void(T)> next) {
+        auto state = release();
+        auto deliver = [state, next = std::move(next)] { next(state->take()); };
+        if (!state->onReady(deliver)) {
+            deliver();
+        }
+    }
+
+    operator std::future<T>() && {
+        auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> future = promise->get_future();
+        then([promise](T value) { promise->set_value(std::move(value)); });
+        return future;
+    }
+
+private:
+    template <typename>
+    friend struct detail::FutureAwaiter;
+
+    void check() const {
+        if (!state_) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+    }
+
+    std::shared_ptr<detail::FutureState<T>> release() {
+        check();
+        return std::move(state_);
+    }
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+// Runs `start` with a callback that fulfils the returned future.
+template <typename T, typename Start>
+Future<T> makeFuture(Start&& start) {
+    auto state = std::make_shared<detail::FutureState<T>>();
+    start([state](T value) { state->set(std::move(value)); });
+    return Future<T>(std::move(state));
+}
+
+#ifdef IRIS_HAS_COROUTINES
+
+namespace detail {
+
+template <typename T>
+struct FutureAwaiter {
+    explicit FutureAwaiter(Future<T>& future) : state(future.release()) {}
+
+    std::shared_ptr<FutureState<T>> state;
+
+    bool await_ready() const { return state->ready(); }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return state->onReady([handle] { handle.resume(); });
+    }
+    T await_resume() { return state->take(); }
+};
+
+} // namespace detail
+
+// `co_await api.getBalanceAsync()`: suspends until the response is decoded.
+// Awaiting consumes the future, like get().
+template <typename T>
+detail::FutureAwaiter<T> operator co_await(Future<T>& future) {
+    return detail::FutureAwaiter<T>(future);
+}
+
+template <typename T>
+detail::FutureAwaiter<T> operator co_await(Future<T>&& future) {
+    return detail::FutureAwaiter<T>(future);
+}
+
+#endif
+
+} // namespace iris
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <vector>
+#include "future.hpp"
+#include "models.hpp"
+#include "result.hpp"
+
+namespace iris {
+
+class IrisApi;
+enum class Currency;
+
+struct HistoryRangeOptions {
+    int offset = 0;
+    // The range ends before the first record this returns true for, e.g.
+    // `[](const HistoryData& r) { return r.timestamp < cutoff; }`. No further
+    // pages are requested after that.
+    std::function<bool(const HistoryData&)> stopWhen;
+};
+
+// Lazy single-pass range over a whole pocket history. While the caller walks
+// page k, page k+1 is already being fetched on the async engine. The offset
+// advances by the number of records each page held; an empty page ends the
+// range. A failed page ends it too, with failed() set and the cause kept in
+// error(), so a caller can tell a complete walk from a cut-short one.
+class HistoryRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = HistoryData;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const HistoryData*;
+        using reference = const HistoryData&;
+
+        iterator() = default;
+
+        reference operator*() const { return range_->current(); }
+        pointer operator->() const { return &range_->current(); }
+        iterator& operator++() {
+            range_->advance();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& a, const iterator& b) {
+            return a.atEnd() == b.atEnd();
+        }
+        friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+
+    private:
+        friend class HistoryRange;
+        explicit iterator(HistoryRange* range) : range_(range) {}
+        bool atEnd() const { return !range_ || range_->done_; }
+
+        HistoryRange* range_ = nullptr;
+    };
+
+    HistoryRange(IrisApi& api, Currency currency, HistoryRangeOptions options = {});
+
+    HistoryRange(const HistoryRange&) = delete;
+    HistoryRange& operator=(const HistoryRange&) = delete;
+
+    // Fetches the first page on first call; the range can be walked once.
+    iterator begin();
+    iterator end() { return iterator(); }
+
+    // Records per page as served by Iris (the largest page seen so far).
+    size_t pageSize() const { return pageSize_; }
+    size_t pagesFetched() const { return pagesFetched_; }
+    // Offset of the page currently being consumed, or of the failed page.
+    int offset() const { return pageOffset_; }
+    // Whether the range ended on a failed request rather than on an empty
+    // page or stopWhen.
+    bool failed() const { return error_.has_value(); }
+    // Only valid when failed().
+    const Error& error() const { return *error_; }
+
+private:
+    const HistoryData& current() const { return page_[index_]; }
+    void advance();
+    bool nextPage();
+    void checkStop();
+    Future<Result<std::vector<HistoryData>>> fetch(int offset);
+
+    IrisApi& api_;
+    Currency currency_;
+    HistoryRangeOptions options_;
+    std::vector<HistoryData> page_;
+    size_t index_ = 0;
+    int pageOffset_;
+    int nextOffset_;
+    Future<Result<std::vector<HistoryData>>> prefetch_;
+    std::optional<Error> error_;
+    size_t pageSize_ = 0;
+    size_t pagesFetched_ = 0;
+    bool started_ = false;
+    bool done_ = false;
+};
+
+} // namespace iris
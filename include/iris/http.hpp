@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <curl/curl.h>
+
+namespace iris {
+
+struct HttpRequest {
+    std::string url;
+    bool isPost = false;
+};
+
+// Transfer phases in microseconds, measured by curl from the start of the
+// transfer (so connect includes namelookup, and so on). Zero for phases that
+// did not happen, e.g. connect on a reused connection.
+struct HttpTimings {
+    int64_t namelookup = 0;
+    int64_t connect = 0;
+    int64_t appconnect = 0;
+    int64_t starttransfer = 0;
+    int64_t total = 0;
+    // Body bytes as received, before any content decoding (gzip, brotli).
+    int64_t bytes = 0;
+};
+
+struct HttpResponse {
+    CURLcode curlCode = CURLE_OK;
+    long httpCode = 0;
+    // Seconds from a Retry-After header, 0 when absent.
+    long retryAfter = 0;
+    HttpTimings timings;
+    std::string body;
+    std::string error;
+};
+
+// Everything libcurl needs for one transfer. Contexts are pooled together with
+// their easy handle, so after warm-up the URL and body buffers already have
+// the capacity a request needs.
+struct RequestContext {
+    CURL* curl = nullptr;
+    HttpRequest request;
+    HttpResponse response;
+    // When set, the (decompressed) body of a 200 response is handed over
+    // chunk by chunk as it arrives instead of being collected in
+    // response.body. Returning false aborts the transfer.
+    std::function<bool(std::string_view chunk)> bodySink;
+    // With a bodySink: status of the response whose body is arriving, read
+    // once when its headers are complete (0 until then).
+    long bodyStatus = 0;
+    char errbuf[CURL_ERROR_SIZE];
+
+    void clear() {
+        request.url.clear();
+        request.isPost = false;
+        response.curlCode = CURLE_OK;
+        response.httpCode = 0;
+        response.retryAfter = 0;
+        response.timings = {};
+        response.body.clear();
+        response.error.clear();
+        bodySink = nullptr;
+        bodyStatus = 0;
+        errbuf[0] = 0;
+    }
+};
+
+// Appends `value` percent-encoded (RFC 3986 unreserved characters kept).
+void appendEscaped(std::string& out, std::string_view value);
+
+// Append one query value as it goes on the wire: strings percent-encoded,
+// numbers via to_chars (doubles as fixed with six decimals, the same text as
+// std::to_string), booleans as "true"/"false".
+void appendQueryValue(std::string& out, std::string_view value);
+void appendQueryValue(std::string& out, int value);
+void appendQueryValue(std::string& out, long value);
+void appendQueryValue(std::string& out, double value);
+void appendQueryValue(std::string& out, bool value);
+inline void appendQueryValue(std::string& out, const char* value) {
+    appendQueryValue(out, std::string_view(value));
+}
+
+// Applies the option set shared by the blocking and the asynchronous paths.
+void setupEasyHandle(RequestContext& context, curl_slist* postHeaders);
+
+// Reads the status code, Retry-After and timings of a finished transfer.
+void readResponseInfo(CURL* curl, HttpResponse& response);
+
+// One blocking or pooled transfer, as IrisApi and CurlTransport run it:
+// setupEasyHandle() plus a cleared response and an optional per-attempt
+// timeout, then the curl code, error text and readResponseInfo() after.
+void prepareTransfer(RequestContext& context, curl_slist* postHeaders,
+                     std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+void finishTransfer(RequestContext& context, CURLcode code);
+
+} // namespace iris
@@ -1,16 +1,40 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <optional>
 #include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
+#include <string_view>
 #include "models.hpp"
 #include "exceptions.hpp"
+#include "future.hpp"
+#include "connection_pool.hpp"
+#include "deep_link.hpp"
+#include "endpoints.hpp"
+#include "http.hpp"
+#include "metrics.hpp"
+#include "read_policy.hpp"
+#include "request_scheduler.hpp"
+#include "result.hpp"
+#include "transport.hpp"
 
 namespace iris {
 
+class AsyncEngine;
+
+template <typename T>
+using Callback = std::function<void(T)>;
+
+// Receives the records of a streamed page one at a time.
+template <typename T>
+using RecordSink = std::function<void(T&& record)>;
 
 enum class Currency {
     GOLD,
@@ -26,12 +50,148 @@ enum class BotPermission {
     POCKET
 };
 
+struct PayoutItem {
+    long userId;
+    int count;
+    std::string comment;
+};
+
+struct PayoutResult {
+    // The answer of a successful give.
+    std::optional<Response> response;
+    int errorCode = 0;
+    // Why the item failed: the transport, HTTP or decode Error, or an API
+    // one carrying the APIError that Iris answered with.
+    std::optional<Error> error;
+
+    bool success() const { return response && !error; }
+};
+
+struct BatchOptions {
+    size_t concurrency = 64;
+    bool withoutDonateScore = true;
+};
+
+enum class OrderSide {
+    BUY,
+    SELL
+};
+
+// A resting trade order.
+struct BookOrder {
+    int id;
+    OrderSide side;
+    double price;
+    int volume;
+};
+
+// One rung of a price ladder.
+struct LadderLevel {
+    OrderSide side;
+    double price;
+    int volume;
+};
+
+struct LadderFill {
+    bool success = false;
+    int doneVolume = 0;
+    // sweets_spent for a buy, sweets_earned for a sell.
+    double sweets = 0;
+    // The part left resting on the book, if any.
+    std::optional<BookOrder> order;
+};
+
+struct LadderResult {
+    // One per level, in level order.
+    std::vector<LadderFill> fills;
+    int boughtVolume = 0;
+    int soldVolume = 0;
+    double sweetsSpent = 0;
+    double sweetsEarned = 0;
+    std::vector<BookOrder> orders;
+    size_t failed = 0;
+};
+
+struct CancelLadderResult {
+    // Merged over all prices.
+    CancelTradesResponse cancelled{{}, 0};
+    std::vector<double> failedPrices;
+};
+
+struct ReplaceLadderResult {
+    CancelLadderResult cancelled;
+    LadderResult placed;
+};
+
+// Bitmask of the user_info kinds checkUsers() fetches.
+enum class UserInfoField : unsigned {
+    REG = 1u << 0,
+    SPAM = 1u << 1,
+    ACTIVITY = 1u << 2,
+    STARS = 1u << 3,
+    POCKET = 1u << 4,
+    ALL = (1u << 5) - 1
+};
+
+constexpr UserInfoField operator|(UserInfoField a, UserInfoField b) {
+    return static_cast<UserInfoField>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+}
+
+constexpr bool hasField(UserInfoField fields, UserInfoField field) {
+    return (static_cast<unsigned>(fields) & static_cast<unsigned>(field)) != 0;
+}
+
+// One row per screened user. A kind that was not requested, or whose lookup
+// failed, stays empty.
+struct UserInfoRow {
+    long userId = 0;
+    std::optional<UserRegInfo> reg;
+    std::optional<UserSpamInfo> spam;
+    std::optional<UserActivityInfo> activity;
+    std::optional<UserStarsInfo> stars;
+    std::optional<UserPocketInfo> pocket;
+};
+
 class IrisApi {
 public:
+    // All methods are safe to call from any number of threads concurrently.
+    // Clients constructed with the same pool share its DNS/TLS caches and
+    // warm connections.
     IrisApi(long botId, const std::string& irisToken, 
             const std::string& baseUrl = "");
+    IrisApi(long botId, const std::string& irisToken,
+            std::shared_ptr<ConnectionPool> pool,
+            const std::string& baseUrl = "");
     ~IrisApi();
 
+    // Routes every request, blocking or async, through `scheduler`; null
+    // turns scheduling off. Clients may share one scheduler to split a
+    // common budget. A client with a scheduler waits for its pending async
+    // calls when destroyed. Set it before issuing requests.
+    void setScheduler(std::shared_ptr<RequestScheduler> scheduler) { scheduler_ = std::move(scheduler); }
+    const std::shared_ptr<RequestScheduler>& scheduler() const { return scheduler_; }
+    // Applies `policy` (timeouts, hedging, retries) to idempotent reads;
+    // null turns it off. Set it before issuing requests.
+    void setReadPolicy(std::shared_ptr<ReadPolicy> policy) { readPolicy_ = std::move(policy); }
+    const std::shared_ptr<ReadPolicy>& readPolicy() const { return readPolicy_; }
+    // Records latency, curl phases, bytes, decode time and outcome of every
+    // request into `metrics`; null turns it off. Set it before issuing
+    // requests.
+    void setMetrics(std::shared_ptr<Metrics> metrics) { metrics_ = std::move(metrics); }
+    const std::shared_ptr<Metrics>& metrics() const { return metrics_; }
+    // Sends every request through `transport` (e.g. a RecordingTransport or
+    // ReplayTransport) instead of the built-in libcurl path; null restores
+    // it. Set it before issuing requests.
+    void setTransport(std::shared_ptr<Transport> transport) { transport_ = std::move(transport); }
+    const std::shared_ptr<Transport>& transport() const { return transport_; }
+    // Runs async requests on `engine` instead of an event loop of this
+    // client's own, so many clients share one thread. A client sharing its
+    // engine waits for its pending async calls when destroyed; do not
+    // destroy it from one of their callbacks. Set it before issuing
+    // requests.
+    void setEngine(std::shared_ptr<AsyncEngine> engine) { engine_ = std::move(engine); }
+    const std::string& baseUrl() const { return baseUrl_; }
+
     std::optional<Response> giveSweets(int count, long userId, 
                                      const std::string& comment = "", 
                                      bool withoutDonateScore = true);
@@ -52,11 +212,14 @@ public:
     std::optional<Response> enableAllPocket(bool enable = true);
     std::optional<Response> allowUserPocket(long userId, bool enable);
 
-    std::vector<UpdatesLog> getUpdates(int offset = 0, int limit = 0);
+    std::vector<UpdatesLog> getUpdates(long offset = 0, int limit = 0);
     std::vector<long> getIrisAgents();
 
     std::string generateDeepLink(Currency currency, int count, 
                                const std::string& comment = "");
+    // Many links at once, in one contiguous buffer; validates every item
+    // first and throws std::invalid_argument naming the first bad one.
+    DeepLinks generateDeepLinks(const std::vector<DeepLinkItem>& items) const;
     std::string generateBotPermissionsDeepLink(
         const std::vector<BotPermission>& permissions);
 
@@ -73,17 +236,241 @@ public:
     std::optional<CancelTradesResponse> cancelAllTrade();
     std::optional<CancelTradesResponse> cancelPartTrade(int id, int volume);
 
+    // Non-blocking variants, served by a curl_multi event loop that is started
+    // on first use. Callbacks run on the loop thread and must not block.
+    // The returned futures can also be co_await-ed (C++20); the coroutine
+    // resumes on the loop thread, with the same rule.
+    Future<std::optional<Response>> giveSweetsAsync(int count, long userId,
+                                                    const std::string& comment = "",
+                                                    bool withoutDonateScore = true);
+    void giveSweetsAsync(int count, long userId, const std::string& comment,
+                         bool withoutDonateScore, Callback<std::optional<Response>> done);
+
+    Future<std::optional<Response>> giveGoldAsync(int count, long userId,
+                                                  const std::string& comment = "",
+                                                  bool withoutDonateScore = true);
+    void giveGoldAsync(int count, long userId, const std::string& comment,
+                       bool withoutDonateScore, Callback<std::optional<Response>> done);
+
+    Future<std::optional<Response>> giveDonateScoreAsync(int count, long userId,
+                                                         const std::string& comment = "");
+    void giveDonateScoreAsync(int count, long userId, const std::string& comment,
+                              Callback<std::optional<Response>> done);
+
+    Future<std::optional<BalanceData>> getBalanceAsync();
+    void getBalanceAsync(Callback<std::optional<BalanceData>> done);
+
+    Future<std::vector<HistoryData>> getSweetsHistoryAsync(int offset = 0);
+    void getSweetsHistoryAsync(int offset, Callback<std::vector<HistoryData>> done);
+    Future<std::vector<HistoryData>> getGoldHistoryAsync(int offset = 0);
+    void getGoldHistoryAsync(int offset, Callback<std::vector<HistoryData>> done);
+    Future<std::vector<HistoryData>> getDonateScoreHistoryAsync(int offset = 0);
+    void getDonateScoreHistoryAsync(int offset, Callback<std::vector<HistoryData>> done);
+
+    Future<std::optional<Response>> enablePocketAsync(bool enable = true);
+    void enablePocketAsync(bool enable, Callback<std::optional<Response>> done);
+    Future<std::optional<Response>> enableAllPocketAsync(bool enable = true);
+    void enableAllPocketAsync(bool enable, Callback<std::optional<Response>> done);
+    Future<std::optional<Response>> allowUserPocketAsync(long userId, bool enable);
+    void allowUserPocketAsync(long userId, bool enable, Callback<std::optional<Response>> done);
+
+    Future<std::vector<UpdatesLog>> getUpdatesAsync(long offset = 0, int limit = 0);
+    void getUpdatesAsync(long offset, int limit, Callback<std::vector<UpdatesLog>> done);
+    Future<std::vector<long>> getIrisAgentsAsync();
+    void getIrisAgentsAsync(Callback<std::vector<long>> done);
+
+    Future<std::optional<UserRegInfo>> checkUserRegAsync(long userId);
+    void checkUserRegAsync(long userId, Callback<std::optional<UserRegInfo>> done);
+    Future<std::optional<UserSpamInfo>> checkUserSpamAsync(long userId);
+    void checkUserSpamAsync(long userId, Callback<std::optional<UserSpamInfo>> done);
+    Future<std::optional<UserActivityInfo>> checkUserActivityAsync(long userId);
+    void checkUserActivityAsync(long userId, Callback<std::optional<UserActivityInfo>> done);
+    Future<std::optional<UserStarsInfo>> checkUserStarsAsync(long userId);
+    void checkUserStarsAsync(long userId, Callback<std::optional<UserStarsInfo>> done);
+    Future<std::optional<UserPocketInfo>> checkUserPocketAsync(long userId);
+    void checkUserPocketAsync(long userId, Callback<std::optional<UserPocketInfo>> done);
+
+    Future<std::optional<BuyTradesResponse>> buyTradeAsync(double price, int volume);
+    void buyTradeAsync(double price, int volume, Callback<std::optional<BuyTradesResponse>> done);
+    Future<std::optional<SellTradesResponse>> sellTradeAsync(double price, int volume);
+    void sellTradeAsync(double price, int volume, Callback<std::optional<SellTradesResponse>> done);
+    Future<std::optional<OrdersResponse>> getOrdersTradeAsync();
+    void getOrdersTradeAsync(Callback<std::optional<OrdersResponse>> done);
+    Future<std::optional<CancelTradesResponse>> cancelPriceTradeAsync(double price);
+    void cancelPriceTradeAsync(double price, Callback<std::optional<CancelTradesResponse>> done);
+    Future<std::optional<CancelTradesResponse>> cancelAllTradeAsync();
+    void cancelAllTradeAsync(Callback<std::optional<CancelTradesResponse>> done);
+    Future<std::optional<CancelTradesResponse>> cancelPartTradeAsync(int id, int volume);
+    void cancelPartTradeAsync(int id, int volume, Callback<std::optional<CancelTradesResponse>> done);
+
+    // Non-throwing variants: the value, or an Error with its class, HTTP
+    // status, curl code and the Iris APIError. Invalid arguments come back
+    // as INVALID_ARGUMENT, and a give the server rejects as API. Nothing is
+    // thrown or formatted on the failure path, which keeps 429 storms cheap.
+    Result<Response> tryGiveSweets(int count, long userId, const std::string& comment = "",
+                                   bool withoutDonateScore = true);
+    Result<Response> tryGiveGold(int count, long userId, const std::string& comment = "",
+                                 bool withoutDonateScore = true);
+    Result<Response> tryGiveDonateScore(int count, long userId, const std::string& comment = "");
+
+    Result<BalanceData> tryGetBalance();
+    Result<std::vector<HistoryData>> tryGetSweetsHistory(int offset = 0);
+    Result<std::vector<HistoryData>> tryGetGoldHistory(int offset = 0);
+    Result<std::vector<HistoryData>> tryGetDonateScoreHistory(int offset = 0);
+
+    // Async counterparts of the gives and history reads above, keeping the
+    // Error.
+    Future<Result<Response>> tryGiveSweetsAsync(int count, long userId, const std::string& comment = "",
+                                                bool withoutDonateScore = true);
+    void tryGiveSweetsAsync(int count, long userId, const std::string& comment, bool withoutDonateScore,
+                            Callback<Result<Response>> done);
+    Future<Result<Response>> tryGiveGoldAsync(int count, long userId, const std::string& comment = "",
+                                              bool withoutDonateScore = true);
+    void tryGiveGoldAsync(int count, long userId, const std::string& comment, bool withoutDonateScore,
+                          Callback<Result<Response>> done);
+    Future<Result<Response>> tryGiveDonateScoreAsync(int count, long userId, const std::string& comment = "");
+    void tryGiveDonateScoreAsync(int count, long userId, const std::string& comment,
+                                 Callback<Result<Response>> done);
+    Future<Result<std::vector<HistoryData>>> tryGetSweetsHistoryAsync(int offset = 0);
+    void tryGetSweetsHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done);
+    Future<Result<std::vector<HistoryData>>> tryGetGoldHistoryAsync(int offset = 0);
+    void tryGetGoldHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done);
+    Future<Result<std::vector<HistoryData>>> tryGetDonateScoreHistoryAsync(int offset = 0);
+    void tryGetDonateScoreHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done);
+
+    Result<Response> tryEnablePocket(bool enable = true);
+    Result<Response> tryEnableAllPocket(bool enable = true);
+    Result<Response> tryAllowUserPocket(long userId, bool enable);
+
+    Result<std::vector<UpdatesLog>> tryGetUpdates(long offset = 0, int limit = 0);
+    Result<std::vector<long>> tryGetIrisAgents();
+
+    Result<UserRegInfo> tryCheckUserReg(long userId);
+    Result<UserSpamInfo> tryCheckUserSpam(long userId);
+    Result<UserActivityInfo> tryCheckUserActivity(long userId);
+    Result<UserStarsInfo> tryCheckUserStars(long userId);
+    Result<UserPocketInfo> tryCheckUserPocket(long userId);
+
+    Result<BuyTradesResponse> tryBuyTrade(double price, int volume);
+    Result<SellTradesResponse> trySellTrade(double price, int volume);
+    Result<OrdersResponse> tryGetOrdersTrade();
+    Result<CancelTradesResponse> tryCancelPriceTrade(double price);
+    Result<CancelTradesResponse> tryCancelAllTrade();
+    Result<CancelTradesResponse> tryCancelPartTrade(int id, int volume);
+
+    // Streamed history and update pages: records are decoded while the page
+    // is still arriving and passed to `onRecord` in order, so a big page is
+    // never held whole. Returns the number of records; failures come back as
+    // from try* calls, and records passed before one stay delivered. Reads
+    // are not retried or hedged once records have been passed. An exception
+    // from `onRecord` aborts the transfer and is rethrown.
+    Result<size_t> streamSweetsHistory(int offset, const RecordSink<HistoryData>& onRecord);
+    Result<size_t> streamGoldHistory(int offset, const RecordSink<HistoryData>& onRecord);
+    Result<size_t> streamDonateScoreHistory(int offset, const RecordSink<HistoryData>& onRecord);
+    Result<size_t> streamUpdates(long offset, int limit, const RecordSink<UpdatesLog>& onRecord);
+
+    // The batch calls below block until every item finished, so they must
+    // not be made from an async callback, which runs on the loop thread.
+    //
+    // Bulk payouts. Every item is validated before anything is sent; at most
+    // `options.concurrency` transfers are in flight at a time. Results are in
+    // item order; `error` says why an item failed and `errorCode` carries the
+    // Iris APIError code of a rejected one.
+    std::vector<PayoutResult> giveSweetsBatch(const std::vector<PayoutItem>& items,
+                                              const BatchOptions& options = {});
+    std::vector<PayoutResult> giveGoldBatch(const std::vector<PayoutItem>& items,
+                                            const BatchOptions& options = {});
+    std::vector<PayoutResult> giveDonateScoreBatch(const std::vector<PayoutItem>& items,
+                                                   const BatchOptions& options = {});
+
+    // Price ladders. Levels are validated before anything is sent and placed
+    // with at most `concurrency` orders in flight; prices go out through
+    // appendQueryValue like every other call.
+    LadderResult placeLadder(const std::vector<LadderLevel>& levels, size_t concurrency = 64);
+    // cancelPriceTrade for every price, concurrently.
+    CancelLadderResult cancelLadder(const std::vector<double>& prices, size_t concurrency = 64);
+    // Cancels `prices` and places `levels` in one concurrent wave. Only levels
+    // at a price being cancelled wait for that cancel, so a fully shifted
+    // ladder reprices in a single round trip.
+    ReplaceLadderResult replaceLadder(const std::vector<double>& prices,
+                                      const std::vector<LadderLevel>& levels,
+                                      size_t concurrency = 64);
+
+    // Bulk screening: fetches every requested kind for every user with at most
+    // `concurrency` lookups in flight. Rows are in `userIds` order.
+    std::vector<UserInfoRow> checkUsers(const std::vector<long>& userIds,
+                                        UserInfoField fields,
+                                        size_t concurrency = 64);
+
 private:
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp);
-    std::string makeRequest(const std::string& method, 
-                          const std::vector<std::pair<std::string, std::string>>& params = {}, 
-                          bool isPost = false);
-    std::string buildUrl(const std::string& method) const;
+    // One generic path per mode for every endpoint: bind `values` to the
+    // descriptor's keys, send, decode with its decoder. tryCall and
+    // tryCallAsync report failures as an Error; call and callAsync map them
+    // to an empty result
+    // (std::nullopt / empty vector).
+    template <typename E, typename... Values>
+    EndpointResult<E> tryCall(const E& endpoint, const Values&... values);
+    template <typename E, typename... Values>
+    typename E::result_type call(const E& endpoint, const Values&... values);
+    template <typename E, typename... Values>
+    Result<size_t> streamCall(const E& endpoint, const RecordSink<typename E::result_type::value_type>& onRecord,
+                              const Values&... values);
+    template <typename E, typename... Values>
+    void tryCallAsync(const E& endpoint, Callback<EndpointResult<E>> done, const Values&... values);
+    template <typename E, typename... Values>
+    void callAsync(const E& endpoint, Callback<typename E::result_type> done,
+                   const Values&... values);
+    // Sends the request already built in the lease's context, through the
+    // scheduler and read policy when set. Failures are left in the response.
+    void perform(ConnectionPool::Lease& lease, const EndpointRoute& route);
+    // Async counterpart: queues with the scheduler (if any), then hands the
+    // request to transmit().
+    void send(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+              int attempt = 0, std::chrono::milliseconds delay = {});
+    // Submits to the engine with the read policy's plan. Throttled requests
+    // are queued again; failed idempotent ones are retried after a backoff.
+    void transmit(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+                  int attempt, std::chrono::milliseconds delay);
+    // send() for a retry, counted in pending_ until its callback returns so
+    // the destructor waits for it too.
+    void resend(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+                int attempt, std::chrono::milliseconds delay);
+    const std::string& urlPrefix(EndpointId id) const {
+        return urlPrefixes_[static_cast<size_t>(id)];
+    }
+    AsyncEngine& engine();
+
+    using WindowedStart = std::function<void(size_t index, std::function<void()> done)>;
+    // Runs `start` for every index with at most `window` unfinished and
+    // blocks until all called `done`, which may happen synchronously. Never
+    // call it from an async completion: it would wait on the loop thread that
+    // has to deliver its own completions.
+    static void runWindowed(size_t count, size_t window, WindowedStart start);
+    static std::vector<PayoutResult> runPayoutBatch(
+        const std::vector<PayoutItem>& items, size_t concurrency,
+        const std::function<void(const PayoutItem&, Callback<Result<Response>>)>& give);
+
+    static void validateTransfer(int count, const std::string& comment);
+    static void validatePrice(double price);
+    // Non-throwing checks behind the validators: the reason, or null.
+    static const char* transferError(int count, const std::string& comment);
+    static const char* priceError(double price);
     
     long botId_;
     std::string irisToken_;
     std::string baseUrl_;
-    CURL* curl_;
+    std::array<std::string, kEndpointCount> urlPrefixes_;
+    std::shared_ptr<ConnectionPool> pool_;
+    std::shared_ptr<RequestScheduler> scheduler_;
+    std::shared_ptr<ReadPolicy> readPolicy_;
+    std::shared_ptr<Metrics> metrics_;
+    std::shared_ptr<Transport> transport_;
+    std::shared_ptr<AsyncEngine> engine_;
+    std::once_flag engineOnce_;
+    // Async calls and retries whose callback has not returned yet.
+    std::atomic<size_t> pending_{0};
+    // Set when destruction starts; completions stop re-sending.
+    std::atomic<bool> closing_{false};
     static constexpr const char* IRIS_API_VERSION = "0.3";
 };
 
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "models.hpp"
+
+namespace iris {
+
+// Decodes a response body straight into a model with a single SAX pass, so no
+// intermediate nlohmann::json DOM is built. Available for every struct in
+// models.hpp, std::vector of HistoryData / UpdatesLog / long, and
+// std::optional of any of those. Unknown keys are ignored; a malformed body,
+// a type mismatch or a missing non-optional field returns false and sets
+// `error`. `out` is unspecified after a failure.
+template <typename T>
+bool tryDecodeJson(std::string_view body, T& out, std::string& error);
+
+// Decodes the result of an endpoint call. For an optional result the body
+// must hold the model: a null body is a failed call, not an empty result.
+template <typename T>
+struct ResultDecoder {
+    static bool tryDecode(std::string_view body, T& out, std::string& error) {
+        return tryDecodeJson<T>(body, out, error);
+    }
+};
+
+template <typename T>
+struct ResultDecoder<std::optional<T>> {
+    static bool tryDecode(std::string_view body, std::optional<T>& out, std::string& error) {
+        out.emplace();
+        if (!tryDecodeJson<T>(body, *out, error)) {
+            out.reset();
+            return false;
+        }
+        return true;
+    }
+};
+
+template <typename T>
+bool tryDecodeResult(std::string_view body, T& out, std::string& error) {
+    return ResultDecoder<T>::tryDecode(body, out, error);
+}
+
+// Decodes a JSON array of HistoryData or UpdatesLog incrementally: feed()
+// takes the body in chunks as they come off the wire and hands the elements
+// completed by a chunk to the sink before it returns. The elements of one
+// chunk are decoded in a single pass, which keeps the per-record cost at
+// that of tryDecodeJson(); only the element cut by the chunk boundary is
+// carried over. A body that is not an array (e.g. an error object) is kept
+// whole in rejected().
+template <typename T>
+class ArrayStreamDecoder {
+public:
+    using Sink = std::function<void(T&& record)>;
+
+    explicit ArrayStreamDecoder(Sink sink) : sink_(std::move(sink)) {}
+
+    // False once the input is malformed, an element does not decode or the
+    // sink threw; the rest of the body is then ignored.
+    bool feed(std::string_view chunk);
+    // Checks that the array was closed. False with error() set otherwise.
+    bool finish();
+
+    bool failed() const { return state_ == State::FAILED; }
+    size_t count() const { return count_; }
+    const std::string& error() const { return error_; }
+    const std::string& rejected() const { return rejected_; }
+    // What the sink threw, if it did.
+    std::exception_ptr exception() const { return exception_; }
+    // Time spent decoding elements so far, the sink not included.
+    std::chrono::steady_clock::duration decodeTime() const { return decodeTime_; }
+
+private:
+    // FIRST follows '[', NEXT a comma, AFTER an element.
+    enum class State { START, FIRST, NEXT, AFTER, ELEMENT, DONE, REJECTED, FAILED };
+
+    bool scan(std::string_view chunk);
+    // Decodes the elements collected in batch_ and passes them on.
+    bool flush();
+    bool fail(std::string error);
+
+    Sink sink_;
+    State state_ = State::START;
+    // Element scanner: container depth and string state, kept across chunks.
+    size_t depth_ = 0;
+    bool inString_ = false;
+    bool escaped_ = false;
+    // Head of an element cut by a chunk boundary.
+    std::string partial_;
+    // Elements completed by the current chunk, as a JSON array.
+    std::string batch_;
+    std::vector<T> records_;
+    std::string rejected_;
+    std::string error_;
+    std::exception_ptr exception_;
+    size_t count_ = 0;
+    std::chrono::steady_clock::duration decodeTime_{};
+};
+
+// pocket/sweets/give answers are decoded leniently: a missing "result" reads
+// as 0 and an error object may omit its code or description.
+bool tryDecodeGiveResponse(std::string_view body, std::optional<Response>& out, std::string& error);
+
+} // namespace iris
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "endpoints.hpp"
+#include "http.hpp"
+
+namespace iris {
+
+// Why a request failed, as far as the client can tell.
+enum class ErrorClass : size_t {
+    NONE,
+    TIMEOUT,
+    TRANSPORT,   // DNS, connect, TLS and other curl errors
+    THROTTLED,   // HTTP 429
+    HTTP_4XX,
+    HTTP_5XX,
+    DECODE,      // the body did not parse into the endpoint's result
+    COUNT
+};
+
+inline constexpr size_t kErrorClassCount = static_cast<size_t>(ErrorClass::COUNT);
+
+ErrorClass classifyError(const HttpResponse& response);
+std::string_view errorClassName(ErrorClass error);
+
+// Curl transfer phases, see HttpTimings.
+enum class TransferPhase : size_t {
+    NAMELOOKUP,
+    CONNECT,
+    APPCONNECT,
+    STARTTRANSFER,
+    COUNT
+};
+
+inline constexpr size_t kTransferPhaseCount = static_cast<size_t>(TransferPhase::COUNT);
+
+std::string_view transferPhaseName(TransferPhase phase);
+
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;  // microseconds
+    uint64_t max = 0;
+    // Indexed like LatencyHistogram buckets.
+    std::vector<uint64_t> buckets;
+
+    // Smallest value (microseconds, to the histogram's precision) that at
+    // least fraction `p` of the samples do not exceed; 0 when empty.
+    uint64_t percentile(double p) const;
+    double mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0; }
+};
+
+// Lock-free log-linear histogram of microsecond values in the style of
+// HdrHistogram: exact below 32us, then 16 buckets per power of two (about 6%
+// relative error) up to 2^36us. record() is a handful of relaxed atomic adds,
+// so any number of threads may record while another takes snapshots.
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBuckets = 16;
+    static constexpr size_t kBucketCount = 528;
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << 36) - 1;
+
+    void record(uint64_t micros);
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t micros);
+    // Inclusive value range of a bucket.
+    static uint64_t bucketLow(size_t index);
+    static uint64_t bucketHigh(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+struct EndpointMetricsSnapshot {
+    EndpointId id;
+    std::string_view path;
+    uint64_t requests = 0;
+    uint64_t bytesReceived = 0;
+    // Indexed by ErrorClass; NONE counts successful requests.
+    std::array<uint64_t, kErrorClassCount> outcomes{};
+    // As seen by the caller: scheduler wait, retries and hedges included.
+    HistogramSnapshot latency;
+    // Of the last attempt, indexed by TransferPhase.
+    std::array<HistogramSnapshot, kTransferPhaseCount> phases;
+    HistogramSnapshot decode;
+};
+
+// Per-endpoint request instrumentation. Attach one to any number of clients
+// with IrisApi::setMetrics(); recording never blocks.
+class Metrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // One finished request: `latency` end to end, the rest from the response.
+    void recordRequest(EndpointId id, const HttpResponse& response, Clock::duration latency);
+    void recordDecode(EndpointId id, Clock::duration elapsed, bool ok);
+
+    EndpointMetricsSnapshot snapshot(EndpointId id) const;
+    // Endpoints that have seen at least one request, in EndpointId order.
+    std::vector<EndpointMetricsSnapshot> snapshot() const;
+    // Prometheus text exposition format (version 0.0.4).
+    std::string prometheus() const;
+
+private:
+    struct Endpoint {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> bytesReceived{0};
+        std::array<std::atomic<uint64_t>, kErrorClassCount> outcomes{};
+        LatencyHistogram latency;
+        std::array<LatencyHistogram, kTransferPhaseCount> phases;
+        LatencyHistogram decode;
+    };
+
+    std::array<Endpoint, kEndpointCount> endpoints_;
+};
+
+} // namespace iris
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "iris_api.hpp"
+
+namespace iris {
+
+struct PriceLevel {
+    double price;
+    int volume;
+    size_t orders;
+};
+
+// Difference found by OrderBook::reconcile() between the mirror and
+// trade/my_orders. Orders missing from the server were filled (or cancelled
+// elsewhere); unknown ones were placed outside this mirror.
+struct OrderBookDrift {
+    size_t missing = 0;
+    size_t unknown = 0;
+    size_t changed = 0;
+
+    bool empty() const { return missing == 0 && unknown == 0 && changed == 0; }
+};
+
+struct OrderBookOptions {
+    // Age after which reconcileIfStale() refreshes from trade/my_orders.
+    std::chrono::milliseconds reconcileInterval{std::chrono::seconds(30)};
+};
+
+// Local mirror of this bot's open trade orders, indexed by id and by price
+// level. The trade calls below forward to IrisApi and fold their responses
+// into the mirror: the resting part of a buy or sell (`new_order`) is added,
+// cancelled orders are removed. Fills by other traders are only seen by
+// reconcile(), so long-running loops should call reconcileIfStale() once per
+// tick. Responses from async calls can be folded in with the apply* methods.
+// Thread-safe; reconcile() should not overlap trade calls, or their effect
+// may be overwritten until the next reconcile.
+class OrderBook {
+public:
+    explicit OrderBook(IrisApi& api, const OrderBookOptions& options = {});
+
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
+
+    std::optional<BuyTradesResponse> buy(double price, int volume);
+    std::optional<SellTradesResponse> sell(double price, int volume);
+    std::optional<CancelTradesResponse> cancelPrice(double price);
+    std::optional<CancelTradesResponse> cancelAll();
+    std::optional<CancelTradesResponse> cancelPart(int id, int volume);
+
+    // IrisApi ladder calls, folded into the mirror.
+    LadderResult placeLadder(const std::vector<LadderLevel>& levels, size_t concurrency = 64);
+    CancelLadderResult cancelLadder(const std::vector<double>& prices, size_t concurrency = 64);
+    ReplaceLadderResult replaceLadder(const std::vector<double>& prices,
+                                      const std::vector<LadderLevel>& levels,
+                                      size_t concurrency = 64);
+    // Replaces the whole book: cancels every price level in the mirror and
+    // places `levels`.
+    ReplaceLadderResult reprice(const std::vector<LadderLevel>& levels, size_t concurrency = 64);
+
+    // Replaces the mirror with trade/my_orders. Returns nullopt, leaving the
+    // mirror untouched, when the request fails.
+    std::optional<OrderBookDrift> reconcile();
+    // reconcile() when the last successful one is older than the interval.
+    std::optional<OrderBookDrift> reconcileIfStale();
+
+    void applyBuy(const BuyTradesResponse& response, double price);
+    void applySell(const SellTradesResponse& response, double price);
+    // For cancelPrice and cancelAll: drops every listed order.
+    void applyCancel(const CancelTradesResponse& response);
+    // For cancelPart: takes the cancelled volume off order `id`.
+    void applyCancelPart(int id, const CancelTradesResponse& response);
+    void applyLadder(const LadderResult& result);
+    OrderBookDrift applyOrders(const OrdersResponse& orders);
+
+    std::optional<BookOrder> order(int id) const;
+    // Our volume resting at exactly `price`; O(log n).
+    int volumeAt(OrderSide side, double price) const;
+    // Highest buy or lowest sell price we have resting.
+    std::optional<double> bestPrice(OrderSide side) const;
+    int totalVolume(OrderSide side) const;
+    // Best price first.
+    std::vector<PriceLevel> levels(OrderSide side) const;
+    std::vector<BookOrder> orders(OrderSide side) const;
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Level {
+        int volume = 0;
+        size_t orders = 0;
+    };
+    using Levels = std::map<double, Level>;
+
+    Levels& levelsFor(OrderSide side) { return side == OrderSide::BUY ? bids_ : asks_; }
+    const Levels& levelsFor(OrderSide side) const { return side == OrderSide::BUY ? bids_ : asks_; }
+
+    // Callers hold mutex_.
+    void insert(const BookOrder& order);
+    void erase(int id);
+    void resize(int id, int volume);
+
+    IrisApi& api_;
+    OrderBookOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, BookOrder> byId_;
+    Levels bids_;
+    Levels asks_;
+    int totals_[2] = {0, 0};
+    std::optional<Clock::time_point> reconciled_;
+};
+
+} // namespace iris
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "endpoints.hpp"
+#include "http.hpp"
+
+namespace iris {
+
+struct ReadPolicyOptions {
+    // Recent successful latencies kept per endpoint, and how many are needed
+    // before percentiles replace the defaults below.
+    size_t window = 256;
+    size_t minSamples = 20;
+
+    // Send a duplicate on a second connection once the first has run past
+    // this percentile of recent latencies; the first answer wins.
+    bool hedge = true;
+    double hedgePercentile = 0.95;
+    std::chrono::milliseconds minHedgeDelay{20};
+
+    // Per-attempt timeout: the chosen percentile times the multiplier,
+    // clamped to [minTimeout, maxTimeout]. maxTimeout applies until enough
+    // samples exist.
+    double timeoutPercentile = 0.99;
+    double timeoutMultiplier = 3;
+    std::chrono::milliseconds minTimeout{std::chrono::seconds(1)};
+    std::chrono::milliseconds maxTimeout{std::chrono::seconds(30)};
+
+    // Attempts in total, including the first. Network errors, timeouts and
+    // 5xx responses are retried after a jittered exponential pause.
+    int maxAttempts = 3;
+    std::chrono::milliseconds initialBackoff{50};
+    std::chrono::milliseconds maxBackoff{std::chrono::seconds(2)};
+};
+
+struct ReadPlan {
+    std::chrono::milliseconds timeout;
+    // Zero when no hedge should be sent.
+    std::chrono::milliseconds hedgeAfter;
+};
+
+struct ReadPolicyStats {
+    uint64_t hedges = 0;
+    uint64_t hedgeWins = 0;
+    uint64_t retries = 0;
+};
+
+// Tail-latency policy for idempotent endpoints (EndpointRoute::idempotent):
+// latency-derived timeouts, hedged duplicates and retries. IrisApi never
+// applies it to give*, pocket settings or trade orders. Thread-safe; one
+// policy can serve several clients.
+class ReadPolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ReadPolicy(const ReadPolicyOptions& options = {});
+
+    ReadPolicy(const ReadPolicy&) = delete;
+    ReadPolicy& operator=(const ReadPolicy&) = delete;
+
+    ReadPlan plan(EndpointId id);
+    void record(EndpointId id, Clock::duration latency);
+    // Jittered pause before retry number `attempt + 1`.
+    std::chrono::milliseconds backoff(int attempt);
+    static bool shouldRetry(const HttpResponse& response);
+
+    void countHedge(bool won);
+    void countRetry();
+
+    const ReadPolicyOptions& options() const { return options_; }
+    ReadPolicyStats stats() const;
+
+private:
+    struct alignas(64) Window {
+        std::mutex mutex;
+        std::vector<uint32_t> samples;  // microseconds, ring buffer
+        size_t next = 0;
+        size_t sinceSorted = 0;
+        ReadPlan plan;
+    };
+
+    // Callers hold window.mutex.
+    void updatePlan(Window& window);
+
+    ReadPolicyOptions options_;
+    std::array<Window, kEndpointCount> windows_;
+    std::mutex jitterMutex_;
+    std::minstd_rand jitter_;
+    std::atomic<uint64_t> hedges_{0};
+    std::atomic<uint64_t> hedgeWins_{0};
+    std::atomic<uint64_t> retries_{0};
+};
+
+} // namespace iris
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "column_store.hpp"
+#include "models.hpp"
+#include "record_view.hpp"
+
+namespace iris {
+
+class IrisApi;
+enum class Currency;
+
+// TypeDictionary mirrored into a one-column ColumnStore, so type codes stay
+// stable across reopen.
+class PersistentTypeDictionary {
+public:
+    explicit PersistentTypeDictionary(const std::string& directory);
+
+    uint8_t intern(std::string_view name);
+    const TypeDictionary& dictionary() const { return dictionary_; }
+
+private:
+    ColumnStore store_;
+    TypeDictionary dictionary_;
+};
+
+// Local, append-only copy of one pocket history, stored column-wise in
+// `directory` (see ColumnStore). Records are kept oldest first.
+class HistoryStore {
+public:
+    HistoryStore(const std::string& directory, Currency currency);
+
+    size_t size() const { return store_.size(); }
+    HistoryData record(size_t index) const;
+
+    const int64_t* userIds() const { return store_.column<int64_t>(kUserId); }
+    const int32_t* amounts() const { return store_.column<int32_t>(kAmount); }
+    const int64_t* timestamps() const { return store_.column<int64_t>(kTimestamp); }
+    const uint8_t* typeCodes() const { return store_.column<uint8_t>(kType); }
+    std::string_view type(size_t index) const { return types_.dictionary().name(typeCodes()[index]); }
+    std::optional<std::string_view> comment(size_t index) const;
+
+    // Columns for the aggregation kernels, straight from the mapping.
+    // Invalidated by the next append or sync.
+    RecordView view() const;
+    const TypeDictionary& types() const { return types_.dictionary(); }
+
+    // Timestamp of the newest stored record, 0 when empty.
+    long lastTimestamp() const { return static_cast<long>(store_.cursor()); }
+
+    // Appends records newer than the stored ones; `records` oldest first.
+    void append(const std::vector<HistoryData>& records);
+
+    // Downloads only what is newer than lastTimestamp() and appends it.
+    // Iris serves history newest first, so the scan stops at the first
+    // older record; records sharing the boundary second are de-duplicated.
+    // Returns the number of records added. If any page fails, nothing is
+    // stored and IrisApiException is thrown with the cause.
+    size_t sync(IrisApi& api);
+    void flush() { store_.flush(); }
+
+private:
+    enum Column : size_t { kUserId, kAmount, kTimestamp, kType, kComment };
+
+    Currency currency_;
+    ColumnStore store_;
+    PersistentTypeDictionary types_;
+};
+
+// Local, append-only copy of the getUpdates log, ordered by update_id.
+class UpdatesStore {
+public:
+    explicit UpdatesStore(const std::string& directory);
+
+    size_t size() const { return store_.size(); }
+    UpdatesLog record(size_t index) const;
+
+    const int64_t* updateIds() const { return store_.column<int64_t>(kUpdateId); }
+    const int64_t* userIds() const { return store_.column<int64_t>(kUserId); }
+    const int32_t* amounts() const { return store_.column<int32_t>(kAmount); }
+    const int64_t* timestamps() const { return store_.column<int64_t>(kTimestamp); }
+    const uint8_t* typeCodes() const { return store_.column<uint8_t>(kType); }
+    std::string_view type(size_t index) const { return types_.dictionary().name(typeCodes()[index]); }
+    std::optional<std::string_view> comment(size_t index) const;
+
+    RecordView view() const;
+    const TypeDictionary& types() const { return types_.dictionary(); }
+
+    // update_id of the newest stored record, -1 when empty.
+    long lastUpdateId() const { return size() ? static_cast<long>(store_.cursor()) : -1; }
+
+    // Appends the records whose update_id is above lastUpdateId().
+    void append(const std::vector<UpdatesLog>& records);
+
+    // Polls getUpdates from lastUpdateId() + 1 until an empty page and
+    // appends everything received. Returns the number of records added.
+    size_t sync(IrisApi& api, int limit = 0);
+    void flush() { store_.flush(); }
+
+private:
+    enum Column : size_t { kUpdateId, kUserId, kAmount, kTimestamp, kType, kComment };
+
+    ColumnStore store_;
+    PersistentTypeDictionary types_;
+};
+
+} // namespace iris
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "models.hpp"
+
+namespace iris {
+
+// Interns record `type` strings ("give", "sweets_log", ...) to one-byte codes
+// in first-seen order.
+class TypeDictionary {
+public:
+    static constexpr size_t kMaxTypes = 256;
+
+    // Throws std::length_error once kMaxTypes distinct names are in use.
+    uint8_t intern(std::string_view name);
+    std::optional<uint8_t> find(std::string_view name) const;
+    std::string_view name(uint8_t code) const { return names_[code]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::deque<std::string> names_;
+    std::unordered_map<std::string, uint8_t> codes_;
+};
+
+// Structure-of-arrays view over history or update records: one contiguous
+// array per aggregated field, `type` as TypeDictionary codes. Non-owning;
+// see RecordTable, HistoryStore::view() and UpdatesStore::view().
+struct RecordView {
+    const int64_t* userIds = nullptr;
+    const int32_t* amounts = nullptr;
+    const int64_t* timestamps = nullptr;
+    const uint8_t* types = nullptr;
+    size_t size = 0;
+};
+
+// In-memory columns built from decoded records.
+class RecordTable {
+public:
+    RecordTable() = default;
+    explicit RecordTable(const std::vector<HistoryData>& records);
+    explicit RecordTable(const std::vector<UpdatesLog>& records);
+
+    void reserve(size_t records);
+    void append(const HistoryData& record);
+    void append(const UpdatesLog& record);
+    void append(int64_t userId, int32_t amount, int64_t timestamp, uint8_t type);
+
+    size_t size() const { return amounts_.size(); }
+    TypeDictionary& types() { return types_; }
+    const TypeDictionary& types() const { return types_; }
+    // Invalidated by the next append.
+    RecordView view() const;
+
+private:
+    std::vector<int64_t> userIds_;
+    std::vector<int32_t> amounts_;
+    std::vector<int64_t> timestamps_;
+    std::vector<uint8_t> typeCodes_;
+    TypeDictionary types_;
+};
+
+} // namespace iris
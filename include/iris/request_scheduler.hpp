@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include "endpoints.hpp"
+#include "http.hpp"
+
+namespace iris {
+
+struct SchedulerOptions {
+    // Shared token bucket: sustained requests per second and burst size.
+    double ratePerSecond = 20;
+    double burst = 20;
+    // Optional per-class caps in requests per second; 0 leaves the class
+    // limited by the shared bucket only. Indexed by RequestClass.
+    std::array<double, kRequestClassCount> classRates{};
+    // Fair-queuing weights, indexed by RequestClass. A backlogged class gets
+    // a share of the grants proportional to its weight; ties go to the
+    // higher-priority class.
+    std::array<double, kRequestClassCount> weights = {{8, 4, 2, 1}};
+    size_t maxInFlight = 64;
+    // After a 429 or 5xx nothing is granted for a jittered, doubling pause
+    // (or the server's Retry-After, if longer).
+    std::chrono::milliseconds initialBackoff{250};
+    std::chrono::milliseconds maxBackoff{std::chrono::seconds(8)};
+    // A 429 means the request was not processed, so it is queued again up to
+    // this many times.
+    int throttleRetries = 2;
+};
+
+// Per-owner limits inside a shared scheduler; see RequestScheduler::setBudget().
+struct OwnerBudget {
+    // Own token bucket, drawn on top of the shared one; 0 leaves the owner
+    // limited by the shared bucket only.
+    double ratePerSecond = 0;
+    double burst = 1;
+    // Share of the grants against other backlogged owners.
+    double weight = 1;
+};
+
+struct OwnerStats {
+    uint64_t granted = 0;
+    size_t queued = 0;
+};
+
+struct SchedulerStats {
+    std::array<uint64_t, kRequestClassCount> granted{};
+    std::array<size_t, kRequestClassCount> queued{};
+    uint64_t throttled = 0;
+    uint64_t serverErrors = 0;
+};
+
+// Client-side admission control in front of the transport. Each request
+// waits in its class queue until a token is available in the shared bucket
+// (and its class bucket), fewer than maxInFlight requests are outstanding
+// and no backoff is in force. Queues are served by self-clocked weighted
+// fair queuing, so trade calls keep flowing while history scans soak up
+// what is left. One scheduler can be shared by several IrisApi instances
+// that draw on the same Iris limits; see IrisApi::setScheduler(). Within a
+// class, requests of different owners (clients) are served by the same kind
+// of fair queuing over owner weights, so one busy bot cannot starve the
+// others, and an owner may have a budget of its own.
+class RequestScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Called with true once the request may go out, or with false when it
+    // was dropped (see cancel()).
+    using Grant = std::function<void(bool granted)>;
+
+    explicit RequestScheduler(const SchedulerOptions& options = {});
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // Blocks until the calling thread may send a request of `cls`. Returns
+    // false when the request was dropped instead (stop() or cancel(owner));
+    // no slot is taken then, so the caller must neither send nor release().
+    bool acquire(RequestClass cls, const void* owner = nullptr);
+    // Queues `grant`; it runs on the scheduler thread and must not block.
+    // `owner` identifies the client for fairness, budgets and cancel().
+    void submit(RequestClass cls, Grant grant, const void* owner = nullptr);
+    // Reports the outcome of a granted request. Returns true when it was
+    // throttled (HTTP 429) and may be sent again.
+    bool release(const HttpResponse& response);
+    // Drops queued entries submitted with `owner`, calling them with false,
+    // and forgets its budget.
+    void cancel(const void* owner);
+
+    // Sets or replaces the budget of `owner`; takes effect for queued
+    // requests too.
+    void setBudget(const void* owner, const OwnerBudget& budget);
+    OwnerStats ownerStats(const void* owner) const;
+
+    const SchedulerOptions& options() const { return options_; }
+    SchedulerStats stats() const;
+
+private:
+    struct Entry {
+        Grant grant;
+        const void* owner;
+    };
+    struct Bucket {
+        double tokens;
+        double rate;
+        double capacity;
+    };
+    struct Owner {
+        Bucket bucket{0, 0, 0};
+        double weight = 1;
+        double finish = 0;
+        OwnerStats stats;
+    };
+    // FIFO per owner; empty owner queues are erased.
+    struct ClassQueue {
+        std::unordered_map<const void*, std::deque<Entry>> byOwner;
+        size_t size = 0;
+    };
+
+    void run();
+    // Callers hold mutex_.
+    void refill(Clock::time_point now);
+    int pickClass(const void*& owner) const;
+    bool pickOwner(const ClassQueue& queue, const void*& owner) const;
+    bool ownerReady(const void* owner) const;
+    std::optional<Clock::time_point> nextRefill(Clock::time_point now) const;
+
+    SchedulerOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable granted_;
+    std::array<ClassQueue, kRequestClassCount> queues_;
+    std::unordered_map<const void*, Owner> owners_;
+    Bucket shared_;
+    std::array<Bucket, kRequestClassCount> classBuckets_;
+    std::array<double, kRequestClassCount> finish_{};
+    double virtualTime_ = 0;
+    double ownerTime_ = 0;
+    Clock::time_point refilled_;
+    Clock::time_point pausedUntil_;
+    std::chrono::milliseconds backoff_;
+    std::minstd_rand jitter_;
+    size_t inFlight_ = 0;
+    SchedulerStats stats_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace iris
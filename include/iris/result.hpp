@@ -0,0 +1,159 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <curl/curl.h>
+#include "endpoints.hpp"
+#include "exceptions.hpp"
+#include "http.hpp"
+#include "metrics.hpp"
+#include "models.hpp"
+
+namespace iris {
+
+// Why a try* call failed. The transport classes match ErrorClass.
+enum class ErrorCode {
+    TIMEOUT,
+    TRANSPORT,          // DNS, connect, TLS and other curl errors
+    THROTTLED,          // HTTP 429
+    HTTP_4XX,
+    HTTP_5XX,
+    API,                // Iris answered with an error object
+    DECODE,             // the body did not parse into the endpoint's result
+    INVALID_ARGUMENT    // rejected before sending
+};
+
+std::string_view errorCodeName(ErrorCode code);
+
+struct Error {
+    explicit Error(ErrorCode code, long httpCode = 0) : code(code), httpCode(httpCode) {}
+
+    ErrorCode code;
+    long httpCode = 0;
+    CURLcode curlCode = CURLE_OK;
+    // Seconds, from a 429 or 503 answer.
+    long retryAfter = 0;
+    // The error object of the body, when it carries one.
+    std::optional<APIError> apiError;
+    // Curl's error text, the decode error or the rejected argument.
+    std::string detail;
+
+    // Human-readable summary; built on demand so failures cost no
+    // formatting unless someone looks.
+    std::string message() const;
+};
+
+// Value or Error, in the spirit of std::expected. Never throws on its own
+// except from value(), which turns an error into IrisApiException for code
+// that prefers exceptions after all.
+template <typename T>
+class Result {
+public:
+    Result(T value) : state_(std::in_place_index<0>, std::move(value)) {}
+    Result(Error error) : state_(std::in_place_index<1>, std::move(error)) {}
+
+    bool ok() const { return state_.index() == 0; }
+    explicit operator bool() const { return ok(); }
+
+    // Unchecked access, like std::optional.
+    T& operator*() & { return *std::get_if<0>(&state_); }
+    const T& operator*() const& { return *std::get_if<0>(&state_); }
+    T&& operator*() && { return std::move(*std::get_if<0>(&state_)); }
+    T* operator->() { return std::get_if<0>(&state_); }
+    const T* operator->() const { return std::get_if<0>(&state_); }
+
+    T& value() & {
+        check();
+        return **this;
+    }
+    const T& value() const& {
+        check();
+        return **this;
+    }
+    T&& value() && {
+        check();
+        return std::move(**this);
+    }
+
+    template <typename U>
+    T value_or(U&& fallback) const& {
+        return ok() ? **this : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    // Only valid when !ok().
+    const Error& error() const { return *std::get_if<1>(&state_); }
+
+private:
+    void check() const {
+        if (!ok()) {
+            throw IrisApiException(error().message());
+        }
+    }
+
+    std::variant<T, Error> state_;
+};
+
+// Error for a transfer that failed or did not answer 200. The body, if any,
+// is searched for an Iris error object.
+Error responseError(const HttpResponse& response);
+// Iris error object in `body`, if it holds one; never throws.
+std::optional<APIError> findApiError(std::string_view body);
+// A give the server answered with an error object failed, for try* callers.
+Result<Response> rejectApiError(Result<Response> result);
+Error invalidArgument(const char* reason);
+
+// Optional endpoint results unwrap: a Result already says whether there is
+// a value.
+template <typename T>
+struct ResultValue {
+    using type = T;
+};
+
+template <typename T>
+struct ResultValue<std::optional<T>> {
+    using type = T;
+};
+
+template <typename E>
+using EndpointResult = Result<typename ResultValue<typename E::result_type>::type>;
+
+// Turns a finished exchange into the endpoint's Result without throwing,
+// timing the decode into `metrics` when one is set.
+template <typename E>
+EndpointResult<E> decodeResponse(const E& endpoint, Metrics* metrics, const HttpResponse& response) {
+    if (response.curlCode != CURLE_OK || response.httpCode != 200) {
+        return responseError(response);
+    }
+
+    typename E::result_type decoded{};
+    std::string error;
+    Metrics::Clock::time_point started{};
+    if (metrics) {
+        started = Metrics::Clock::now();
+    }
+    bool ok = endpoint.tryDecode(response.body, decoded, error);
+    if (metrics) {
+        metrics->recordDecode(E::id, Metrics::Clock::now() - started, ok);
+    }
+    if (!ok) {
+        Error failure(ErrorCode::DECODE, response.httpCode);
+        failure.apiError = findApiError(response.body);
+        if (failure.apiError) {
+            failure.code = ErrorCode::API;
+        }
+        failure.detail = std::move(error);
+        return failure;
+    }
+
+    if constexpr (std::is_same_v<typename E::result_type, typename ResultValue<typename E::result_type>::type>) {
+        return EndpointResult<E>(std::move(decoded));
+    } else {
+        return std::move(*decoded);
+    }
+}
+
+} // namespace iris
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "connection_pool.hpp"
+#include "http.hpp"
+
+namespace iris {
+
+class AsyncEngine;
+
+// What IrisApi sends requests through when one is set with
+// IrisApi::setTransport(). Without one, IrisApi drives libcurl itself: the
+// same transfers as CurlTransport, plus the hedging and per-attempt
+// timeouts of ReadPolicy. Scheduling, retries and metrics sit above the
+// transport and apply either way.
+class Transport {
+public:
+    using Completion = std::function<void(HttpResponse)>;
+
+    virtual ~Transport() = default;
+
+    // Blocking exchange; overwrites every field of `response`.
+    virtual void perform(const HttpRequest& request, HttpResponse& response) = 0;
+    // Asynchronous exchange. `done` may run on any thread, but not inside
+    // submit(), and must not block.
+    virtual void submit(HttpRequest request, Completion done) = 0;
+};
+
+// libcurl over a connection pool, with an AsyncEngine for submit().
+class CurlTransport : public Transport {
+public:
+    explicit CurlTransport(std::shared_ptr<ConnectionPool> pool = std::make_shared<ConnectionPool>());
+    ~CurlTransport() override;
+
+    void perform(const HttpRequest& request, HttpResponse& response) override;
+    void submit(HttpRequest request, Completion done) override;
+
+private:
+    std::shared_ptr<ConnectionPool> pool_;
+    std::once_flag engineOnce_;
+    std::unique_ptr<AsyncEngine> engine_;
+};
+
+// Forwards to `inner` and appends every exchange to a recording file that
+// ReplayTransport can serve. URLs are stored relative to `baseUrl`, which
+// keeps the bot token out of the file; pass the client's IrisApi::baseUrl().
+// It is required (std::invalid_argument if empty), and exchanges with a URL
+// outside it are forwarded but not recorded. Bodies are stored as received,
+// error texts are not.
+//
+// File layout: the magic "IRISREC1", then per exchange a flags byte (bit 0:
+// POST) and LEB128 varints for curl code, HTTP status and Retry-After,
+// followed by the URL and the body, each as a varint length plus bytes.
+class RecordingTransport : public Transport {
+public:
+    RecordingTransport(std::shared_ptr<Transport> inner, const std::string& path, std::string baseUrl);
+    ~RecordingTransport() override;
+
+    void perform(const HttpRequest& request, HttpResponse& response) override;
+    void submit(HttpRequest request, Completion done) override;
+
+    size_t recorded() const;
+    void flush();
+
+private:
+    void write(const HttpRequest& request, const HttpResponse& response);
+
+    std::shared_ptr<Transport> inner_;
+    std::string baseUrl_;
+    mutable std::mutex mutex_;
+    std::ofstream out_;
+    std::string buffer_;
+    size_t recorded_ = 0;
+};
+
+struct ReplayOptions {
+    // When a URL was never recorded, answer with the recordings of the same
+    // path (query ignored), so requests with fresh parameters still get
+    // realistic responses.
+    bool matchPath = true;
+    // Once every recording of a URL was served, start over from the first;
+    // otherwise further requests miss.
+    bool loop = true;
+};
+
+struct ReplayStats {
+    uint64_t served = 0;
+    uint64_t pathMatches = 0;
+    uint64_t misses = 0;
+};
+
+// Serves a recording from memory. Each URL (relative to `baseUrl`, as
+// recorded) gets its recorded responses back in order. `baseUrl` is the
+// replaying client's IrisApi::baseUrl() and is required, like the
+// recorder's (std::invalid_argument if empty): without it no request would
+// match. Misses are answered with HTTP 404. Async completions run on one
+// worker thread.
+class ReplayTransport : public Transport {
+public:
+    ReplayTransport(const std::string& path, std::string baseUrl, const ReplayOptions& options = {});
+    ~ReplayTransport() override;
+
+    ReplayTransport(const ReplayTransport&) = delete;
+    ReplayTransport& operator=(const ReplayTransport&) = delete;
+
+    void perform(const HttpRequest& request, HttpResponse& response) override;
+    void submit(HttpRequest request, Completion done) override;
+
+    size_t size() const { return records_.size(); }
+    ReplayStats stats() const;
+
+private:
+    struct Record {
+        CURLcode curlCode;
+        long httpCode;
+        long retryAfter;
+        std::string_view body;
+    };
+    struct Cursor {
+        std::vector<size_t> records;
+        size_t next = 0;
+    };
+    struct Job {
+        HttpRequest request;
+        Completion done;
+    };
+
+    void load(const std::string& path);
+    const Record* pick(std::string_view url);
+    void run();
+
+    std::string baseUrl_;
+    ReplayOptions options_;
+    std::string data_;
+    std::vector<Record> records_;
+    std::unordered_map<std::string_view, Cursor> byUrl_;
+    std::unordered_map<std::string_view, Cursor> byPath_;
+    mutable std::mutex mutex_;
+    ReplayStats stats_;
+
+    std::mutex queueMutex_;
+    std::condition_variable wake_;
+    std::deque<Job> queue_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+} // namespace iris
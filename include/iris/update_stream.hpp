@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "models.hpp"
+#include "ring_buffer.hpp"
+
+namespace iris {
+
+class IrisApi;
+
+struct UpdateStreamOptions {
+    long offset = 0;
+    int limit = 0;
+    size_t capacity = 1024;
+    std::chrono::milliseconds idleDelay{1000};
+};
+
+// Continuous getUpdates consumer. A background poller keeps one request in
+// flight while the previous batch is being queued, advances the offset past
+// each update_id as it is queued, and blocks when the queue is full.
+class UpdateStream {
+public:
+    explicit UpdateStream(IrisApi& api, UpdateStreamOptions options = {});
+    ~UpdateStream();
+
+    UpdateStream(const UpdateStream&) = delete;
+    UpdateStream& operator=(const UpdateStream&) = delete;
+
+    bool tryPop(UpdatesLog& update);
+    // Waits up to `timeout`; returns false on timeout or after stop().
+    bool pop(UpdatesLog& update, std::chrono::milliseconds timeout);
+
+    void stop();
+    bool running() const { return !stopping_.load(std::memory_order_acquire); }
+    // Just past the last update_id queued: the next poll starts here, and a
+    // stream restarted from it after stop() misses nothing.
+    long offset() const { return offset_.load(std::memory_order_acquire); }
+    size_t queued() const { return queue_.size(); }
+
+private:
+    void run();
+    bool deliver(UpdatesLog update);
+    void idle(std::chrono::milliseconds delay);
+
+    IrisApi& api_;
+    UpdateStreamOptions options_;
+    RingBuffer<UpdatesLog> queue_;
+    std::atomic<long> offset_;
+    std::atomic<bool> stopping_;
+    std::atomic<int> waiters_;
+    std::atomic<bool> producerWaiting_;
+    std::mutex waitMutex_;
+    std::condition_variable readable_;
+    std::condition_variable writable_;
+    std::thread poller_;
+};
+
+} // namespace iris
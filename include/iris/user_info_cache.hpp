@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "models.hpp"
+
+namespace iris {
+
+class IrisApi;
+
+struct UserInfoCacheOptions {
+    // How long a successful answer is served from memory. A zero TTL turns
+    // caching off for that type; concurrent lookups are still coalesced.
+    std::chrono::milliseconds regTtl{std::chrono::minutes(10)};
+    std::chrono::milliseconds spamTtl{std::chrono::minutes(1)};
+    std::chrono::milliseconds activityTtl{std::chrono::minutes(1)};
+    std::chrono::milliseconds starsTtl{std::chrono::minutes(5)};
+    std::chrono::milliseconds pocketTtl{std::chrono::minutes(1)};
+    size_t shards = 16;
+    // Per info type; expired entries are swept first when a shard is full.
+    size_t maxEntries = 65536;
+};
+
+struct UserInfoCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Lookups that waited for a request another thread already had in flight.
+    uint64_t coalesced = 0;
+};
+
+// Read-through cache in front of the IrisApi::checkUser* lookups. Entries
+// are keyed by (user, info type) and spread over independently locked
+// shards. Only one request per key is in flight at a time: concurrent misses
+// wait for it and share its answer. Failed lookups are not cached.
+class UserInfoCache {
+public:
+    explicit UserInfoCache(IrisApi& api, const UserInfoCacheOptions& options = {});
+
+    UserInfoCache(const UserInfoCache&) = delete;
+    UserInfoCache& operator=(const UserInfoCache&) = delete;
+
+    std::optional<UserRegInfo> checkUserReg(long userId);
+    std::optional<UserSpamInfo> checkUserSpam(long userId);
+    std::optional<UserActivityInfo> checkUserActivity(long userId);
+    std::optional<UserStarsInfo> checkUserStars(long userId);
+    std::optional<UserPocketInfo> checkUserPocket(long userId);
+
+    // Drops every cached answer for `userId`, e.g. after allowUserPocket().
+    void invalidate(long userId);
+    void clear();
+
+    UserInfoCacheStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <typename T>
+    struct Entry {
+        std::shared_future<std::optional<T>> value;
+        Clock::time_point expires;
+        // The loader that owns a pending entry; null once the entry is ready.
+        const void* loader = nullptr;
+    };
+
+    template <typename T>
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<long, Entry<T>> entries;
+    };
+
+    template <typename T>
+    struct Table {
+        Table(std::chrono::milliseconds ttl, size_t shardCount, size_t maxEntries);
+
+        Shard<T>& shardFor(long userId);
+        void makeRoom(Shard<T>& shard, Clock::time_point now);
+
+        std::chrono::milliseconds ttl;
+        size_t maxPerShard;
+        std::vector<Shard<T>> shards;
+    };
+
+    template <typename T>
+    std::optional<T> lookup(Table<T>& table, long userId,
+                            std::optional<T> (IrisApi::*fetch)(long));
+
+    IrisApi& api_;
+    Table<UserRegInfo> reg_;
+    Table<UserSpamInfo> spam_;
+    Table<UserActivityInfo> activity_;
+    Table<UserStarsInfo> stars_;
+    Table<UserPocketInfo> pocket_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> coalesced_;
+};
+
+} // namespace iris
@@ -0,0 +1,449 @@
+#include "iris/aggregate.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IRIS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define IRIS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IRIS_TARGET(isa)
+#endif
+#endif
+
+namespace iris {
+
+namespace {
+
+// Rows per mask block in the group-by kernels; the mask stays in L1.
+constexpr size_t kBlockRows = 4096;
+
+SimdLevel detectSimdLevel() {
+#if defined(IRIS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (osAvx && maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? SimdLevel::AVX2 : sse42 ? SimdLevel::SSE42 : SimdLevel::SCALAR;
+#elif defined(IRIS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return SimdLevel::SSE42;
+    }
+    return SimdLevel::SCALAR;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+std::atomic<SimdLevel>& selectedLevel() {
+    static std::atomic<SimdLevel> level{supportedSimdLevel()};
+    return level;
+}
+
+// RecordFilter flattened for the kernels.
+struct Bounds {
+    int64_t from;
+    int64_t to;
+    int64_t user;
+    uint8_t type;
+    bool anyUser;
+    bool anyType;
+    bool all;
+};
+
+Bounds makeBounds(const RecordFilter& filter) {
+    Bounds b;
+    b.from = filter.fromTimestamp;
+    b.to = filter.toTimestamp;
+    b.user = filter.userId.value_or(0);
+    b.type = filter.type.value_or(0);
+    b.anyUser = !filter.userId;
+    b.anyType = !filter.type;
+    b.all = b.anyUser && b.anyType && b.from == std::numeric_limits<int64_t>::min()
+        && b.to == std::numeric_limits<int64_t>::max();
+    return b;
+}
+
+inline bool matches(const RecordView& view, const Bounds& b, size_t i) {
+    int64_t ts = view.timestamps[i];
+    return ts >= b.from && ts < b.to
+        && (b.anyType || view.types[i] == b.type)
+        && (b.anyUser || view.userIds[i] == b.user);
+}
+
+Totals totalScalar(const RecordView& view, const Bounds& b, size_t begin) {
+    Totals totals;
+    for (size_t i = begin; i < view.size; ++i) {
+        bool hit = matches(view, b, i);
+        totals.amount += hit ? view.amounts[i] : 0;
+        totals.count += hit;
+    }
+    return totals;
+}
+
+void matchScalar(const RecordView& view, const Bounds& b, size_t begin, size_t end,
+                 uint8_t* mask) {
+    for (size_t i = begin; i < end; ++i) {
+        mask[i - begin] = matches(view, b, i);
+    }
+}
+
+#ifdef IRIS_X86
+
+// Byte j set to 1 when bit j of the index is set.
+struct NibbleBytes {
+    uint32_t bytes[16];
+    constexpr NibbleBytes() : bytes() {
+        for (uint32_t bits = 0; bits < 16; ++bits) {
+            for (uint32_t j = 0; j < 4; ++j) {
+                bytes[bits] |= ((bits >> j) & 1u) << (8 * j);
+            }
+        }
+    }
+};
+constexpr NibbleBytes kNibbleBytes;
+
+// All-ones in every 64-bit lane holding a matching row.
+template <bool CheckUser>
+IRIS_TARGET("avx2")
+inline __m256i matchAvx2(const RecordView& view, size_t i, __m256i from, __m256i to,
+                         __m256i type, __m256i anyType, __m256i user) {
+    __m256i ts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(view.timestamps + i));
+    __m256i hit = _mm256_andnot_si256(_mm256_cmpgt_epi64(from, ts), _mm256_cmpgt_epi64(to, ts));
+
+    int32_t rawTypes;
+    std::memcpy(&rawTypes, view.types + i, sizeof(rawTypes));
+    __m256i types = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(rawTypes));
+    hit = _mm256_and_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi64(types, type), anyType));
+
+    if (CheckUser) {
+        __m256i users = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(view.userIds + i));
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi64(users, user));
+    }
+    return hit;
+}
+
+template <bool CheckUser>
+IRIS_TARGET("avx2")
+Totals totalAvx2(const RecordView& view, const Bounds& b) {
+    // ts >= from is computed as !(from > ts), ts < to as (to > ts).
+    const __m256i from = _mm256_set1_epi64x(b.from);
+    const __m256i to = _mm256_set1_epi64x(b.to);
+    const __m256i type = _mm256_set1_epi64x(b.type);
+    const __m256i anyType = _mm256_set1_epi64x(b.anyType ? -1 : 0);
+    const __m256i user = _mm256_set1_epi64x(b.user);
+
+    __m256i sum = _mm256_setzero_si256();
+    __m256i count = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= view.size; i += 4) {
+        __m256i hit = matchAvx2<CheckUser>(view, i, from, to, type, anyType, user);
+        __m256i amounts = _mm256_cvtepi32_epi64(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(view.amounts + i)));
+        sum = _mm256_add_epi64(sum, _mm256_and_si256(amounts, hit));
+        count = _mm256_sub_epi64(count, hit);
+    }
+
+    alignas(32) int64_t sums[4];
+    alignas(32) int64_t counts[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sums), sum);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(counts), count);
+
+    Totals totals = totalScalar(view, b, i);
+    for (int lane = 0; lane < 4; ++lane) {
+        totals.amount += sums[lane];
+        totals.count += static_cast<size_t>(counts[lane]);
+    }
+    return totals;
+}
+
+template <bool CheckUser>
+IRIS_TARGET("avx2")
+void matchAvx2Block(const RecordView& view, const Bounds& b, size_t begin, size_t end,
+                    uint8_t* mask) {
+    const __m256i from = _mm256_set1_epi64x(b.from);
+    const __m256i to = _mm256_set1_epi64x(b.to);
+    const __m256i type = _mm256_set1_epi64x(b.type);
+    const __m256i anyType = _mm256_set1_epi64x(b.anyType ? -1 : 0);
+    const __m256i user = _mm256_set1_epi64x(b.user);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256i hit = matchAvx2<CheckUser>(view, i, from, to, type, anyType, user);
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(hit));
+        std::memcpy(mask + (i - begin), &kNibbleBytes.bytes[bits], 4);
+    }
+    matchScalar(view, b, i, end, mask + (i - begin));
+}
+
+template <bool CheckUser>
+IRIS_TARGET("sse4.2")
+inline __m128i matchSse42(const RecordView& view, size_t i, __m128i from, __m128i to,
+                          __m128i type, __m128i anyType, __m128i user) {
+    __m128i ts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(view.timestamps + i));
+    __m128i hit = _mm_andnot_si128(_mm_cmpgt_epi64(from, ts), _mm_cmpgt_epi64(to, ts));
+
+    uint16_t rawTypes;
+    std::memcpy(&rawTypes, view.types + i, sizeof(rawTypes));
+    __m128i types = _mm_cvtepu8_epi64(_mm_cvtsi32_si128(rawTypes));
+    hit = _mm_and_si128(hit, _mm_or_si128(_mm_cmpeq_epi64(types, type), anyType));
+
+    if (CheckUser) {
+        __m128i users = _mm_loadu_si128(reinterpret_cast<const __m128i*>(view.userIds + i));
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi64(users, user));
+    }
+    return hit;
+}
+
+template <bool CheckUser>
+IRIS_TARGET("sse4.2")
+Totals totalSse42(const RecordView& view, const Bounds& b) {
+    const __m128i from = _mm_set1_epi64x(b.from);
+    const __m128i to = _mm_set1_epi64x(b.to);
+    const __m128i type = _mm_set1_epi64x(b.type);
+    const __m128i anyType = _mm_set1_epi64x(b.anyType ? -1 : 0);
+    const __m128i user = _mm_set1_epi64x(b.user);
+
+    __m128i sum = _mm_setzero_si128();
+    __m128i count = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= view.size; i += 2) {
+        __m128i hit = matchSse42<CheckUser>(view, i, from, to, type, anyType, user);
+        __m128i amounts = _mm_cvtepi32_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(view.amounts + i)));
+        sum = _mm_add_epi64(sum, _mm_and_si128(amounts, hit));
+        count = _mm_sub_epi64(count, hit);
+    }
+
+    alignas(16) int64_t sums[2];
+    alignas(16) int64_t counts[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(counts), count);
+
+    Totals totals = totalScalar(view, b, i);
+    for (int lane = 0; lane < 2; ++lane) {
+        totals.amount += sums[lane];
+        totals.count += static_cast<size_t>(counts[lane]);
+    }
+    return totals;
+}
+
+template <bool CheckUser>
+IRIS_TARGET("sse4.2")
+void matchSse42Block(const RecordView& view, const Bounds& b, size_t begin, size_t end,
+                     uint8_t* mask) {
+    const __m128i from = _mm_set1_epi64x(b.from);
+    const __m128i to = _mm_set1_epi64x(b.to);
+    const __m128i type = _mm_set1_epi64x(b.type);
+    const __m128i anyType = _mm_set1_epi64x(b.anyType ? -1 : 0);
+    const __m128i user = _mm_set1_epi64x(b.user);
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128i hit = matchSse42<CheckUser>(view, i, from, to, type, anyType, user);
+        int bits = _mm_movemask_pd(_mm_castsi128_pd(hit));
+        mask[i - begin] = static_cast<uint8_t>(bits & 1);
+        mask[i - begin + 1] = static_cast<uint8_t>(bits >> 1);
+    }
+    matchScalar(view, b, i, end, mask + (i - begin));
+}
+
+#endif // IRIS_X86
+
+// Writes 1 to mask[i - begin] for every matching row in [begin, end).
+void matchBlock(const RecordView& view, const Bounds& b, size_t begin, size_t end,
+                uint8_t* mask) {
+    if (b.all) {
+        std::memset(mask, 1, end - begin);
+        return;
+    }
+    switch (simdLevel()) {
+#ifdef IRIS_X86
+    case SimdLevel::AVX2:
+        return b.anyUser ? matchAvx2Block<false>(view, b, begin, end, mask)
+                         : matchAvx2Block<true>(view, b, begin, end, mask);
+    case SimdLevel::SSE42:
+        return b.anyUser ? matchSse42Block<false>(view, b, begin, end, mask)
+                         : matchSse42Block<true>(view, b, begin, end, mask);
+#endif
+    default:
+        return matchScalar(view, b, begin, end, mask);
+    }
+}
+
+// Calls fn(row) for every matching row, in order.
+template <typename Fn>
+void forEachMatch(const RecordView& view, const RecordFilter& filter, Fn&& fn) {
+    Bounds b = makeBounds(filter);
+    if (b.all) {
+        for (size_t i = 0; i < view.size; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    uint8_t mask[kBlockRows];
+    for (size_t begin = 0; begin < view.size; begin += kBlockRows) {
+        size_t end = std::min(view.size, begin + kBlockRows);
+        matchBlock(view, b, begin, end, mask);
+        for (size_t i = begin; i < end; ++i) {
+            if (mask[i - begin]) {
+                fn(i);
+            }
+        }
+    }
+}
+
+int64_t bucketStart(int64_t timestamp, int64_t width) {
+    int64_t bucket = timestamp / width;
+    if (timestamp % width < 0) {
+        --bucket;
+    }
+    return bucket * width;
+}
+
+bool largerTotal(const UserTotal& a, const UserTotal& b) {
+    if (a.totals.amount != b.totals.amount) {
+        return a.totals.amount > b.totals.amount;
+    }
+    return a.userId < b.userId;
+}
+
+} // namespace
+
+SimdLevel supportedSimdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+SimdLevel simdLevel() {
+    return selectedLevel().load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    selectedLevel().store(std::min(level, supportedSimdLevel()), std::memory_order_relaxed);
+}
+
+Totals total(const RecordView& view, const RecordFilter& filter) {
+    Bounds b = makeBounds(filter);
+    switch (simdLevel()) {
+#ifdef IRIS_X86
+    case SimdLevel::AVX2:
+        return b.anyUser ? totalAvx2<false>(view, b) : totalAvx2<true>(view, b);
+    case SimdLevel::SSE42:
+        return b.anyUser ? totalSse42<false>(view, b) : totalSse42<true>(view, b);
+#endif
+    default:
+        return totalScalar(view, b, 0);
+    }
+}
+
+void filterRows(const RecordView& view, const RecordFilter& filter, std::vector<uint32_t>& rows) {
+    if (view.size > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many rows for 32-bit row indices");
+    }
+    rows.clear();
+    forEachMatch(view, filter, [&](size_t i) { rows.push_back(static_cast<uint32_t>(i)); });
+}
+
+std::array<Totals, TypeDictionary::kMaxTypes> totalsByType(const RecordView& view,
+                                                           const RecordFilter& filter) {
+    std::array<Totals, TypeDictionary::kMaxTypes> totals{};
+    Bounds b = makeBounds(filter);
+    uint8_t mask[kBlockRows];
+    for (size_t begin = 0; begin < view.size; begin += kBlockRows) {
+        size_t end = std::min(view.size, begin + kBlockRows);
+        matchBlock(view, b, begin, end, mask);
+        // Branch-free scatter: a rejected row adds zero to its slot.
+        for (size_t i = begin; i < end; ++i) {
+            uint8_t hit = mask[i - begin];
+            Totals& slot = totals[view.types[i]];
+            slot.amount += hit * static_cast<int64_t>(view.amounts[i]);
+            slot.count += hit;
+        }
+    }
+    return totals;
+}
+
+std::vector<TimeBucket> totalsByTime(const RecordView& view, int64_t bucketSeconds,
+                                     const RecordFilter& filter) {
+    if (bucketSeconds <= 0) {
+        throw std::invalid_argument("Bucket width must be positive");
+    }
+
+    std::vector<TimeBucket> buckets;
+    std::unordered_map<int64_t, size_t> index;
+    size_t current = 0;
+    int64_t currentStart = 0;
+    bool haveCurrent = false;
+
+    forEachMatch(view, filter, [&](size_t i) {
+        int64_t ts = view.timestamps[i];
+        // Unsigned distance also catches ts before currentStart.
+        if (!haveCurrent || static_cast<uint64_t>(ts) - static_cast<uint64_t>(currentStart)
+                >= static_cast<uint64_t>(bucketSeconds)) {
+            currentStart = bucketStart(ts, bucketSeconds);
+            auto inserted = index.try_emplace(currentStart, buckets.size());
+            if (inserted.second) {
+                buckets.push_back({currentStart, {}});
+            }
+            current = inserted.first->second;
+            haveCurrent = true;
+        }
+        buckets[current].totals.amount += view.amounts[i];
+        ++buckets[current].totals.count;
+    });
+
+    std::sort(buckets.begin(), buckets.end(), [](const TimeBucket& a, const TimeBucket& b) {
+        return a.start < b.start;
+    });
+    return buckets;
+}
+
+std::vector<UserTotal> totalsByUser(const RecordView& view, const RecordFilter& filter) {
+    std::vector<UserTotal> users;
+    std::unordered_map<int64_t, size_t> index;
+
+    forEachMatch(view, filter, [&](size_t i) {
+        int64_t userId = view.userIds[i];
+        auto inserted = index.try_emplace(userId, users.size());
+        if (inserted.second) {
+            users.push_back({userId, {}});
+        }
+        Totals& totals = users[inserted.first->second].totals;
+        totals.amount += view.amounts[i];
+        ++totals.count;
+    });
+
+    std::sort(users.begin(), users.end(), [](const UserTotal& a, const UserTotal& b) {
+        return a.userId < b.userId;
+    });
+    return users;
+}
+
+std::vector<UserTotal> topUsers(const RecordView& view, size_t n, const RecordFilter& filter) {
+    std::vector<UserTotal> users = totalsByUser(view, filter);
+    n = std::min(n, users.size());
+    std::partial_sort(users.begin(), users.begin() + n, users.end(), largerTotal);
+    users.resize(n);
+    return users;
+}
+
+} // namespace iris
@@ -0,0 +1,323 @@
+#include "iris/async_engine.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace iris {
+
+struct AsyncEngine::Transfer {
+    RequestContext context;
+    // Empty on the copy of a hedged request that does not own the caller.
+    Completion done;
+    TransferOptions options;
+    Clock::time_point startAt;
+    Clock::time_point hedgeAt = Clock::time_point::max();
+    // The other copy of a hedged request while both are running.
+    Transfer* twin = nullptr;
+    bool isHedge = false;
+    bool hedged = false;
+};
+
+namespace {
+
+// Upper bound on how long the loop sleeps in curl_multi_poll.
+constexpr int kMaxPollMs = 1000;
+
+void complete(AsyncEngine::Completion& done, HttpResponse response) {
+    try {
+        done(std::move(response));
+    } catch (...) {
+        // A throwing completion must not take the event loop down.
+    }
+}
+
+// Answers a transfer that will never run.
+template <typename Transfer>
+void cancel(Transfer& transfer) {
+    transfer.context.response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+    transfer.context.response.error = "Async engine stopped";
+    complete(transfer.done, std::move(transfer.context.response));
+}
+
+// Moves the caller's completion to `to` if `from` holds it.
+template <typename Transfer>
+void adopt(Transfer& to, Transfer& from) {
+    if (!to.done) {
+        to.done = std::move(from.done);
+        to.options.onHedge = std::move(from.options.onHedge);
+    }
+}
+
+} // namespace
+
+AsyncEngine::AsyncEngine(CURLSH* share)
+    : multi_(curl_multi_init())
+    , share_(share)
+    , postHeaders_(nullptr)
+    , stopping_(false)
+    , inFlight_(0) {
+    if (!multi_) {
+        throw std::runtime_error("Failed to initialize CURL multi handle");
+    }
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    postHeaders_ = curl_slist_append(nullptr, "Content-Type: application/x-www-form-urlencoded");
+
+    thread_ = std::thread(&AsyncEngine::run, this);
+}
+
+AsyncEngine::~AsyncEngine() {
+    stopping_ = true;
+    if (thread_.get_id() == std::this_thread::get_id()) {
+        // Destroyed by a completion, which is still on the loop's stack: the
+        // thread cannot join itself, so it is detached and told to return
+        // without touching the engine, and what it held is cancelled here.
+        *destroyed_ = true;
+        thread_.detach();
+        cancelAll();
+    } else {
+        curl_multi_wakeup(multi_);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    for (CURL* handle : idle_) {
+        curl_easy_cleanup(handle);
+    }
+    curl_slist_free_all(postHeaders_);
+    curl_multi_cleanup(multi_);
+}
+
+void AsyncEngine::submit(HttpRequest request, Completion done, TransferOptions options) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->context.request = std::move(request);
+    transfer->done = std::move(done);
+    transfer->options = std::move(options);
+    transfer->startAt = Clock::now() + transfer->options.delay;
+
+    {
+        // Checked under the lock so that the transfer is either drained by
+        // cancelAll() or answered here, never left in pending_.
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_) {
+            inFlight_.fetch_add(1, std::memory_order_relaxed);
+            pending_.push_back(std::move(transfer));
+        }
+    }
+    if (transfer) {
+        cancel(*transfer);
+        return;
+    }
+    curl_multi_wakeup(multi_);
+}
+
+void AsyncEngine::start(std::unique_ptr<Transfer> transfer) {
+    CURL* handle = nullptr;
+    if (!idle_.empty()) {
+        handle = idle_.back();
+        idle_.pop_back();
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+    }
+
+    if (!handle) {
+        if (transfer->isHedge) {
+            transfer->twin->twin = nullptr;
+            return;
+        }
+        transfer->context.response.curlCode = CURLE_FAILED_INIT;
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        complete(transfer->done, std::move(transfer->context.response));
+        return;
+    }
+
+    if (share_) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+    }
+    transfer->context.curl = handle;
+    setupEasyHandle(transfer->context, postHeaders_);
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+
+    const TransferOptions& options = transfer->options;
+    if (options.timeout.count() > 0) {
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(options.timeout.count()));
+    }
+    if (transfer->isHedge) {
+        // The point of a hedge is to avoid whatever stalls the first
+        // connection, so it must not be multiplexed onto it.
+        curl_easy_setopt(handle, CURLOPT_FRESH_CONNECT, 1L);
+    } else {
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        if (options.hedgeAfter.count() > 0) {
+            transfer->hedgeAt = Clock::now() + options.hedgeAfter;
+        }
+    }
+
+    curl_multi_add_handle(multi_, handle);
+    active_.emplace(handle, std::move(transfer));
+}
+
+void AsyncEngine::finish(CURL* handle, CURLcode code) {
+    curl_multi_remove_handle(multi_, handle);
+
+    auto it = active_.find(handle);
+    if (it == active_.end()) {
+        curl_easy_cleanup(handle);
+        return;
+    }
+    std::unique_ptr<Transfer> transfer = std::move(it->second);
+    active_.erase(it);
+
+    HttpResponse& response = transfer->context.response;
+    response.curlCode = code;
+    readResponseInfo(handle, response);
+    if (code != CURLE_OK && transfer->context.errbuf[0]) {
+        response.error = transfer->context.errbuf;
+    }
+    idle_.push_back(handle);
+
+    if (Transfer* other = transfer->twin) {
+        other->twin = nullptr;
+        if (code != CURLE_OK || response.httpCode >= 500) {
+            // Let the other copy answer instead.
+            adopt(*other, *transfer);
+            return;
+        }
+        adopt(*transfer, *other);
+        abandon(other);
+    }
+
+    if (transfer->hedged && transfer->options.onHedge) {
+        transfer->options.onHedge(transfer->isHedge);
+    }
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    complete(transfer->done, std::move(response));
+}
+
+void AsyncEngine::abandon(Transfer* transfer) {
+    CURL* handle = transfer->context.curl;
+    curl_multi_remove_handle(multi_, handle);
+    idle_.push_back(handle);
+    active_.erase(handle);
+}
+
+int AsyncEngine::runTimers() {
+    bool* destroyed = destroyed_;
+    Clock::time_point now = Clock::now();
+    Clock::time_point next = now + std::chrono::milliseconds(kMaxPollMs);
+
+    for (size_t i = 0; i < delayed_.size();) {
+        if (delayed_[i]->startAt <= now) {
+            std::unique_ptr<Transfer> transfer = std::move(delayed_[i]);
+            delayed_[i] = std::move(delayed_.back());
+            delayed_.pop_back();
+            start(std::move(transfer));
+            if (*destroyed) {
+                return 0;
+            }
+        } else {
+            next = std::min(next, delayed_[i]->startAt);
+            ++i;
+        }
+    }
+
+    std::vector<Transfer*> due;
+    for (auto& entry : active_) {
+        Transfer* transfer = entry.second.get();
+        if (transfer->hedgeAt <= now) {
+            due.push_back(transfer);
+        } else {
+            next = std::min(next, transfer->hedgeAt);
+        }
+    }
+    for (Transfer* original : due) {
+        original->hedgeAt = Clock::time_point::max();
+        auto hedge = std::make_unique<Transfer>();
+        hedge->context.request = original->context.request;
+        hedge->options.timeout = original->options.timeout;
+        hedge->isHedge = true;
+        hedge->hedged = original->hedged = true;
+        hedge->twin = original;
+        original->twin = hedge.get();
+        start(std::move(hedge));
+    }
+
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+    return static_cast<int>(std::max<int64_t>(wait + 1, 0));
+}
+
+void AsyncEngine::run() {
+    bool destroyed = false;
+    destroyed_ = &destroyed;
+    while (!stopping_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch_.swap(pending_);
+        }
+        Clock::time_point now = Clock::now();
+        while (!batch_.empty()) {
+            std::unique_ptr<Transfer> transfer = std::move(batch_.front());
+            batch_.pop_front();
+            if (transfer->startAt > now) {
+                delayed_.push_back(std::move(transfer));
+                continue;
+            }
+            start(std::move(transfer));
+            if (destroyed) {
+                return;
+            }
+        }
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &queued)) {
+            if (msg->msg == CURLMSG_DONE) {
+                finish(msg->easy_handle, msg->data.result);
+                if (destroyed) {
+                    return;
+                }
+            }
+        }
+
+        int timeout = runTimers();
+        if (destroyed) {
+            return;
+        }
+        curl_multi_poll(multi_, nullptr, 0, timeout, nullptr);
+    }
+    cancelAll();
+}
+
+void AsyncEngine::cancelAll() {
+    std::deque<std::unique_ptr<Transfer>> orphaned;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        orphaned.swap(pending_);
+    }
+    for (auto& transfer : batch_) {
+        orphaned.push_back(std::move(transfer));
+    }
+    batch_.clear();
+    for (auto& transfer : delayed_) {
+        orphaned.push_back(std::move(transfer));
+    }
+    delayed_.clear();
+    for (auto& entry : active_) {
+        curl_multi_remove_handle(multi_, entry.first);
+        idle_.push_back(entry.first);
+        orphaned.push_back(std::move(entry.second));
+    }
+    active_.clear();
+
+    for (auto& transfer : orphaned) {
+        if (!transfer->done) {
+            continue;  // the other copy of a hedged request owns the caller
+        }
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        cancel(*transfer);
+    }
+}
+
+} // namespace iris
@@ -0,0 +1,223 @@
+#include "iris/balance_ledger.hpp"
+#include <cmath>
+
+namespace iris {
+
+namespace {
+
+std::optional<std::pair<Currency, double>> defaultUpdateRule(const UpdatesLog& update) {
+    if (update.type == "sweets_log") {
+        return std::make_pair(Currency::SWEETS, static_cast<double>(update.amount));
+    }
+    if (update.type == "gold_log") {
+        return std::make_pair(Currency::GOLD, static_cast<double>(update.amount));
+    }
+    if (update.type == "donate_score_log") {
+        return std::make_pair(Currency::DONATE_SCORE, static_cast<double>(update.amount));
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+BalanceLedger::BalanceLedger(IrisApi& api, const BalanceLedgerOptions& options)
+    : api_(api)
+    , options_(options) {
+    if (!options_.updateRule) {
+        options_.updateRule = defaultUpdateRule;
+    }
+}
+
+std::optional<Response> BalanceLedger::giveSweets(int count, long userId, const std::string& comment,
+                                                  bool withoutDonateScore) {
+    auto response = api_.giveSweets(count, userId, comment, withoutDonateScore);
+    if (response) {
+        applyGive(Currency::SWEETS, count, *response);
+    }
+    return response;
+}
+
+std::optional<Response> BalanceLedger::giveGold(int count, long userId, const std::string& comment,
+                                                bool withoutDonateScore) {
+    auto response = api_.giveGold(count, userId, comment, withoutDonateScore);
+    if (response) {
+        applyGive(Currency::GOLD, count, *response);
+    }
+    return response;
+}
+
+std::optional<Response> BalanceLedger::giveDonateScore(int count, long userId, const std::string& comment) {
+    auto response = api_.giveDonateScore(count, userId, comment);
+    if (response) {
+        applyGive(Currency::DONATE_SCORE, count, *response);
+    }
+    return response;
+}
+
+std::optional<BalanceDrift> BalanceLedger::reconcile() {
+    uint64_t events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events = events_;
+    }
+    auto balance = api_.getBalance();
+    if (!balance) {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_ != events && seeded()) {
+        ++stats_.skipped;
+        return std::nullopt;
+    }
+    BalanceDrift drift;
+    if (seeded()) {
+        drift.gold = balance->gold - gold();
+        drift.sweets = balance->sweets - sweets();
+        drift.donateScore = balance->donate_score - donateScore();
+        if (std::abs(drift.sweets) < options_.sweetsTolerance) {
+            drift.sweets = 0;
+        }
+    }
+    ++stats_.reconciles;
+    if (!drift.empty()) {
+        ++stats_.drifts;
+    }
+
+    beginWrite();
+    gold_.store(balance->gold, std::memory_order_relaxed);
+    sweets_.store(balance->sweets, std::memory_order_relaxed);
+    donateScore_.store(balance->donate_score, std::memory_order_relaxed);
+    endWrite();
+    seeded_.store(true, std::memory_order_release);
+    reconciled_ = Clock::now();
+    return drift;
+}
+
+std::optional<BalanceDrift> BalanceLedger::reconcileIfStale() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reconciled_ && Clock::now() - *reconciled_ < options_.reconcileInterval) {
+            return BalanceDrift{};
+        }
+    }
+    return reconcile();
+}
+
+void BalanceLedger::applyGive(Currency currency, int count, const Response& response) {
+    if (response.error) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    beginWrite();
+    add(currency, -count);
+    endWrite();
+}
+
+void BalanceLedger::applyBuy(const BuyTradesResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    beginWrite();
+    add(Currency::GOLD, response.done_volume);
+    add(Currency::SWEETS, -response.sweets_spent);
+    endWrite();
+}
+
+void BalanceLedger::applySell(const SellTradesResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    beginWrite();
+    add(Currency::GOLD, -response.done_volume);
+    add(Currency::SWEETS, response.sweets_earned);
+    endWrite();
+}
+
+void BalanceLedger::applyUpdate(const UpdatesLog& update) {
+    auto movement = options_.updateRule(update);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lastUpdate_ && update.update_id <= *lastUpdate_) {
+        ++stats_.duplicates;
+        return;
+    }
+    lastUpdate_ = update.update_id;
+    if (!movement) {
+        return;
+    }
+    beginWrite();
+    add(movement->first, movement->second);
+    endWrite();
+}
+
+void BalanceLedger::applyBalance(const BalanceData& balance) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    beginWrite();
+    gold_.store(balance.gold, std::memory_order_relaxed);
+    sweets_.store(balance.sweets, std::memory_order_relaxed);
+    donateScore_.store(balance.donate_score, std::memory_order_relaxed);
+    ++events_;
+    endWrite();
+    seeded_.store(true, std::memory_order_release);
+}
+
+double BalanceLedger::balance(Currency currency) const {
+    switch (currency) {
+        case Currency::GOLD:
+            return gold();
+        case Currency::DONATE_SCORE:
+            return donateScore();
+        case Currency::SWEETS:
+        default:
+            return sweets();
+    }
+}
+
+BalanceData BalanceLedger::snapshot() const {
+    BalanceData balance{};
+    for (;;) {
+        uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        balance.gold = gold_.load(std::memory_order_relaxed);
+        balance.sweets = sweets_.load(std::memory_order_relaxed);
+        balance.donate_score = donateScore_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            return balance;
+        }
+    }
+}
+
+BalanceLedgerStats BalanceLedger::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void BalanceLedger::add(Currency currency, double amount) {
+    switch (currency) {
+        case Currency::GOLD:
+            gold_.store(gold_.load(std::memory_order_relaxed) + static_cast<int>(std::lround(amount)),
+                        std::memory_order_relaxed);
+            break;
+        case Currency::DONATE_SCORE:
+            donateScore_.store(donateScore_.load(std::memory_order_relaxed)
+                                   + static_cast<int>(std::lround(amount)),
+                               std::memory_order_relaxed);
+            break;
+        case Currency::SWEETS:
+        default:
+            sweets_.store(sweets_.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            break;
+    }
+    ++events_;
+    ++stats_.applied;
+}
+
+void BalanceLedger::beginWrite() {
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BalanceLedger::endWrite() {
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+} // namespace iris
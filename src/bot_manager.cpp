@@ -0,0 +1,83 @@
+#include "iris/bot_manager.hpp"
+#include "iris/async_engine.hpp"
+#include <stdexcept>
+
+namespace iris {
+
+BotManager::BotManager(const BotManagerOptions& options)
+    : options_(options)
+    , pool_(std::make_shared<ConnectionPool>())
+    , scheduler_(std::make_shared<RequestScheduler>(options.scheduler))
+    , engine_(std::make_shared<AsyncEngine>(pool_->share())) {
+}
+
+BotManager::~BotManager() = default;
+
+std::shared_ptr<IrisApi> BotManager::addBot(long botId, const std::string& irisToken, const OwnerBudget& budget,
+                                            const std::string& baseUrl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bots_.count(botId)) {
+        throw std::invalid_argument("Bot " + std::to_string(botId) + " is already hosted");
+    }
+    auto api = std::make_shared<IrisApi>(botId, irisToken, pool_, baseUrl);
+    api->setScheduler(scheduler_);
+    api->setEngine(engine_);
+    api->setReadPolicy(options_.readPolicy);
+    api->setMetrics(options_.metrics);
+    scheduler_->setBudget(api.get(), budget);
+    bots_.emplace(botId, api);
+    return api;
+}
+
+bool BotManager::removeBot(long botId) {
+    std::shared_ptr<IrisApi> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = bots_.find(botId);
+        if (it == bots_.end()) {
+            return false;
+        }
+        removed = std::move(it->second);
+        bots_.erase(it);
+    }
+    // Its queued requests would otherwise keep drawing on the shared budget
+    // while a caller still holds the client, and its own budget would stay.
+    scheduler_->cancel(removed.get());
+    // Destroyed here, if this was the last reference, outside the lock:
+    // it waits for its pending async calls.
+    removed.reset();
+    return true;
+}
+
+bool BotManager::setBudget(long botId, const OwnerBudget& budget) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = bots_.find(botId);
+    if (it == bots_.end()) {
+        return false;
+    }
+    scheduler_->setBudget(it->second.get(), budget);
+    return true;
+}
+
+std::shared_ptr<IrisApi> BotManager::bot(long botId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = bots_.find(botId);
+    return it == bots_.end() ? nullptr : it->second;
+}
+
+std::vector<long> BotManager::botIds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<long> ids;
+    ids.reserve(bots_.size());
+    for (const auto& [id, api] : bots_) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+size_t BotManager::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bots_.size();
+}
+
+} // namespace iris
@@ -0,0 +1,150 @@
+#include "iris/column_store.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace iris {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'R', 'I', 'S', 'C', 'O', 'L', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMaxColumns = 16;
+constexpr size_t kMinRows = 1024;
+constexpr size_t kMinHeap = 64 * 1024;
+
+std::string prepareDirectory(const std::string& directory) {
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+} // namespace
+
+struct ColumnStore::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t count;
+    uint64_t heapSize;
+    int64_t cursor;
+    uint32_t columnCount;
+    uint32_t widths[kMaxColumns];
+};
+
+ColumnStore::ColumnStore(const std::string& directory, uint32_t kind,
+                         std::vector<ColumnSpec> columns)
+    : specs_(std::move(columns))
+    , header_(prepareDirectory(directory) + "/header")
+    , heap_(directory + "/strings.heap")
+    , heapUsed_(0) {
+    if (specs_.empty() || specs_.size() > kMaxColumns) {
+        throw std::invalid_argument("Column store needs 1 to 16 columns");
+    }
+
+    if (header_.size() == 0) {
+        header_.resize(sizeof(Header));
+        Header& h = header();
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.kind = kind;
+        h.columnCount = static_cast<uint32_t>(specs_.size());
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            h.widths[i] = specs_[i].width;
+        }
+    }
+
+    bool compatible = header_.size() >= sizeof(Header);
+    if (compatible) {
+        const Header& h = header();
+        compatible = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion
+            && h.kind == kind && h.columnCount == specs_.size();
+        for (size_t i = 0; compatible && i < specs_.size(); ++i) {
+            compatible = h.widths[i] == specs_[i].width;
+        }
+    }
+    if (!compatible) {
+        throw std::runtime_error("Not a compatible column store: " + directory);
+    }
+
+    // Files grow ahead of the published count, so they may be larger than
+    // the header says but never smaller.
+    const Header& h = header();
+    columns_.reserve(specs_.size());
+    for (const ColumnSpec& spec : specs_) {
+        std::string path = directory + "/" + spec.name + ".col";
+        columns_.emplace_back(path);
+        if (columns_.back().size() / spec.width < h.count) {
+            throw std::runtime_error("Column store file is truncated: " + path);
+        }
+    }
+    if (heap_.size() < h.heapSize) {
+        throw std::runtime_error("Column store file is truncated: " + directory + "/strings.heap");
+    }
+    heapUsed_ = h.heapSize;
+}
+
+ColumnStore::Header& ColumnStore::header() const {
+    return *reinterpret_cast<Header*>(header_.data());
+}
+
+size_t ColumnStore::size() const {
+    return static_cast<size_t>(header().count);
+}
+
+int64_t ColumnStore::cursor() const {
+    return header().cursor;
+}
+
+void ColumnStore::reserve(size_t records) {
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        MappedFile& file = columns_[i];
+        size_t width = specs_[i].width;
+        size_t rows = file.size() / width;
+        if (rows < records) {
+            file.resize(std::max({records, rows * 2, kMinRows}) * width);
+        }
+    }
+}
+
+void ColumnStore::reserveHeap(size_t bytes) {
+    if (heap_.size() < bytes) {
+        heap_.resize(std::max({bytes, heap_.size() * 2, kMinHeap}));
+    }
+}
+
+StringRef ColumnStore::appendString(std::string_view value) {
+    reserveHeap(heapUsed_ + value.size());
+    if (!value.empty()) {
+        std::memcpy(heap_.data() + heapUsed_, value.data(), value.size());
+    }
+    StringRef ref{heapUsed_, static_cast<uint32_t>(value.size()), 1};
+    heapUsed_ += value.size();
+    return ref;
+}
+
+std::string_view ColumnStore::string(const StringRef& ref) const {
+    if (!ref.present || ref.length == 0) {
+        return {};
+    }
+    return std::string_view(heap_.data() + ref.offset, ref.length);
+}
+
+void ColumnStore::publish(size_t count, int64_t cursor) {
+    Header& h = header();
+    h.heapSize = heapUsed_;
+    h.cursor = cursor;
+    std::atomic_thread_fence(std::memory_order_release);
+    h.count = count;
+}
+
+void ColumnStore::flush() {
+    for (MappedFile& column : columns_) {
+        column.flush();
+    }
+    heap_.flush();
+    header_.flush();
+}
+
+} // namespace iris
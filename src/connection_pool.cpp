@@ -0,0 +1,76 @@
+#include "iris/connection_pool.hpp"
+#include <stdexcept>
+
+namespace iris {
+
+ConnectionPool::ConnectionPool()
+    : share_(nullptr)
+    , postHeaders_(nullptr) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    share_ = curl_share_init();
+    if (!share_) {
+        curl_global_cleanup();
+        throw std::runtime_error("Failed to initialize CURL share handle");
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &ConnectionPool::lockShared);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &ConnectionPool::unlockShared);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    postHeaders_ = curl_slist_append(nullptr, "Content-Type: application/x-www-form-urlencoded");
+}
+
+ConnectionPool::~ConnectionPool() {
+    for (auto& context : contexts_) {
+        curl_easy_cleanup(context->curl);
+    }
+    curl_slist_free_all(postHeaders_);
+    curl_share_cleanup(share_);
+    curl_global_cleanup();
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    RequestContext* context = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            context = idle_.back();
+            idle_.pop_back();
+        }
+    }
+
+    if (context) {
+        curl_easy_reset(context->curl);
+    } else {
+        auto created = std::make_unique<RequestContext>();
+        created->curl = curl_easy_init();
+        if (!created->curl) {
+            throw std::runtime_error("Failed to initialize CURL");
+        }
+        context = created.get();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        contexts_.push_back(std::move(created));
+        idle_.reserve(contexts_.size());
+    }
+    context->clear();
+    curl_easy_setopt(context->curl, CURLOPT_SHARE, share_);
+    return Lease(this, context);
+}
+
+void ConnectionPool::release(RequestContext* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(context);
+}
+
+void ConnectionPool::lockShared(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<ConnectionPool*>(userptr)->shareLocks_[data].lock();
+}
+
+void ConnectionPool::unlockShared(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<ConnectionPool*>(userptr)->shareLocks_[data].unlock();
+}
+
+} // namespace iris
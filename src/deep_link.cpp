@@ -0,0 +1,148 @@
+#include "iris/deep_link.hpp"
+#include "iris/iris_api.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+namespace iris {
+
+namespace {
+
+constexpr std::string_view kLinkPrefix = "https://t.me/iris_black_bot?start=";
+constexpr std::string_view kPermissionsPrefix = "https://t.me/iris_black_bot?start=request_rights_";
+constexpr size_t kMaxComment = 128;
+// Digits of a long, with sign.
+constexpr size_t kMaxNumber = 20;
+
+constexpr std::array<bool, 256> makeCommentTable() {
+    std::array<bool, 256> table{};
+    for (unsigned char c = '0'; c <= '9'; ++c) table[c] = true;
+    for (unsigned char c = 'a'; c <= 'z'; ++c) table[c] = true;
+    for (unsigned char c = 'A'; c <= 'Z'; ++c) table[c] = true;
+    table['_'] = true;
+    return table;
+}
+
+constexpr std::array<bool, 256> kCommentChars = makeCommentTable();
+
+std::string_view transferKind(Currency currency) {
+    switch (currency) {
+        case Currency::GOLD:
+            return "givegold_bot";
+        case Currency::DONATE_SCORE:
+            return "givedonate_score_bot";
+        case Currency::SWEETS:
+        default:
+            return "give_bot";
+    }
+}
+
+std::string_view permissionName(BotPermission permission) {
+    switch (permission) {
+        case BotPermission::REG:
+            return "reg";
+        case BotPermission::ACTIVITY:
+            return "activity";
+        case BotPermission::SPAM:
+            return "spam";
+        case BotPermission::STARS:
+            return "stars";
+        case BotPermission::POCKET:
+        default:
+            return "pocket";
+    }
+}
+
+template <typename Integer>
+std::string_view formatNumber(char (&digits)[kMaxNumber], Integer value) {
+    return std::string_view(digits, static_cast<size_t>(std::to_chars(digits, digits + kMaxNumber, value).ptr - digits));
+}
+
+char* writeText(char* out, std::string_view text) {
+    return std::copy(text.begin(), text.end(), out);
+}
+
+// Writes one transfer link at `out`, which must have room for it.
+char* writeDeepLink(char* out, std::string_view bot, Currency currency, int count, std::string_view comment) {
+    out = writeText(out, kLinkPrefix);
+    out = writeText(out, transferKind(currency));
+    out = writeText(out, bot);
+    *out++ = '_';
+    char digits[kMaxNumber];
+    out = writeText(out, formatNumber(digits, count));
+    if (!comment.empty()) {
+        *out++ = '_';
+        out = writeText(out, comment);
+    }
+    return out;
+}
+
+size_t deepLinkLength(size_t botLength, Currency currency, int count, std::string_view comment) {
+    char digits[kMaxNumber];
+    size_t length = kLinkPrefix.size() + transferKind(currency).size() + botLength + 1
+        + formatNumber(digits, count).size();
+    return comment.empty() ? length : length + 1 + comment.size();
+}
+
+} // namespace
+
+const char* deepLinkError(int count, std::string_view comment) {
+    if (count <= 0) {
+        return "Count must be positive";
+    }
+    if (comment.size() > kMaxComment) {
+        return "Comment must not exceed 128 characters";
+    }
+    for (char c : comment) {
+        if (!kCommentChars[static_cast<unsigned char>(c)]) {
+            return "Comment can only contain letters, numbers and underscore";
+        }
+    }
+    return nullptr;
+}
+
+void appendDeepLink(std::string& out, long botId, Currency currency, int count, std::string_view comment) {
+    char bot[kMaxNumber];
+    std::string_view botText = formatNumber(bot, botId);
+    size_t start = out.size();
+    out.resize(start + deepLinkLength(botText.size(), currency, count, comment));
+    writeDeepLink(out.data() + start, botText, currency, count, comment);
+}
+
+void appendBotPermissionsDeepLink(std::string& out, long botId, const std::vector<BotPermission>& permissions) {
+    char bot[kMaxNumber];
+    out.append(kPermissionsPrefix);
+    out.append(formatNumber(bot, botId));
+    for (BotPermission permission : permissions) {
+        out.push_back('_');
+        out.append(permissionName(permission));
+    }
+}
+
+DeepLinks makeDeepLinks(long botId, const std::vector<DeepLinkItem>& items) {
+    char bot[kMaxNumber];
+    std::string_view botText = formatNumber(bot, botId);
+
+    DeepLinks links;
+    links.offsets_.resize(items.size() + 1);
+    size_t total = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const DeepLinkItem& item = items[i];
+        if (const char* reason = deepLinkError(item.count, item.comment)) {
+            throw std::invalid_argument("Deep link " + std::to_string(i) + ": " + reason);
+        }
+        links.offsets_[i] = total;
+        total += deepLinkLength(botText.size(), item.currency, item.count, item.comment);
+    }
+    links.offsets_[items.size()] = total;
+
+    links.buffer_.reset(new char[total]);
+    char* out = links.buffer_.get();
+    for (const DeepLinkItem& item : items) {
+        out = writeDeepLink(out, botText, item.currency, item.count, item.comment);
+    }
+    return links;
+}
+
+} // namespace iris
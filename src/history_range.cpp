@@ -0,0 +1,80 @@
+#include "iris/history_range.hpp"
+#include "iris/iris_api.hpp"
+#include <algorithm>
+
+namespace iris {
+
+HistoryRange::HistoryRange(IrisApi& api, Currency currency, HistoryRangeOptions options)
+    : api_(api)
+    , currency_(currency)
+    , options_(std::move(options))
+    , pageOffset_(options_.offset)
+    , nextOffset_(options_.offset) {
+}
+
+HistoryRange::iterator HistoryRange::begin() {
+    if (!started_) {
+        started_ = true;
+        prefetch_ = fetch(nextOffset_);
+        if (nextPage()) {
+            checkStop();
+        }
+    }
+    return iterator(this);
+}
+
+void HistoryRange::advance() {
+    if (done_) {
+        return;
+    }
+    if (++index_ == page_.size() && !nextPage()) {
+        return;
+    }
+    checkStop();
+}
+
+bool HistoryRange::nextPage() {
+    Result<std::vector<HistoryData>> page = prefetch_.get();
+    index_ = 0;
+    pageOffset_ = nextOffset_;
+
+    if (!page) {
+        error_ = page.error();
+        page_.clear();
+        done_ = true;
+        return false;
+    }
+    page_ = std::move(*page);
+    if (page_.empty()) {
+        done_ = true;
+        return false;
+    }
+
+    ++pagesFetched_;
+    pageSize_ = std::max(pageSize_, page_.size());
+    nextOffset_ = pageOffset_ + static_cast<int>(page_.size());
+    prefetch_ = fetch(nextOffset_);
+    return true;
+}
+
+void HistoryRange::checkStop() {
+    if (options_.stopWhen && options_.stopWhen(page_[index_])) {
+        done_ = true;
+        // The prefetched page is dropped; its request still completes.
+        prefetch_ = {};
+    }
+}
+
+Future<Result<std::vector<HistoryData>>> HistoryRange::fetch(int offset) {
+    switch (currency_) {
+        case Currency::GOLD:
+            return api_.tryGetGoldHistoryAsync(offset);
+        case Currency::DONATE_SCORE:
+            return api_.tryGetDonateScoreHistoryAsync(offset);
+        case Currency::SWEETS:
+        default:
+            return api_.tryGetSweetsHistoryAsync(offset);
+    }
+}
+
+} // namespace iris
@@ -0,0 +1,185 @@
+#include "iris/http.hpp"
+#include <charconv>
+#include <limits>
+
+namespace iris {
+
+namespace {
+
+constexpr curl_off_t kMaxPresize = 16 * 1024 * 1024;
+
+size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    auto* context = static_cast<RequestContext*>(userp);
+    std::string& body = context->response.body;
+
+    // Error and redirect bodies are still collected for the caller.
+    if (context->bodySink && context->bodyStatus == 200) {
+        std::string_view chunk(static_cast<char*>(contents), size * nmemb);
+        return context->bodySink(chunk) ? size * nmemb : 0;
+    }
+
+    if (body.empty()) {
+        curl_off_t length = -1;
+        if (curl_easy_getinfo(context->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK
+            && length > 0 && length <= kMaxPresize) {
+            body.reserve(static_cast<size_t>(length));
+        }
+    }
+
+    body.append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// Only installed for streamed transfers: notes the status once the headers
+// of each response (redirects and 1xx included) are complete, so the write
+// callback does not query it for every chunk.
+size_t headerCallback(char* line, size_t size, size_t nmemb, void* userp) {
+    auto* context = static_cast<RequestContext*>(userp);
+    size_t length = size * nmemb;
+    if (length > 0 && length <= 2 && (line[0] == '\r' || line[0] == '\n')) {
+        curl_easy_getinfo(context->curl, CURLINFO_RESPONSE_CODE, &context->bodyStatus);
+    } else if (length >= 5 && std::string_view(line, 5) == "HTTP/") {
+        context->bodyStatus = 0;
+    }
+    return length;
+}
+
+bool isUnreserved(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+template <typename... Args>
+void appendChars(std::string& out, Args... args) {
+    // Large enough for any double in fixed notation.
+    char buffer[std::numeric_limits<double>::max_exponent10 + 32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), args...);
+    out.append(buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+} // namespace
+
+void appendEscaped(std::string& out, std::string_view value) {
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    for (char ch : value) {
+        auto c = static_cast<unsigned char>(ch);
+        if (isUnreserved(c)) {
+            out.push_back(ch);
+        } else {
+            out.push_back('%');
+            out.push_back(kHex[c >> 4]);
+            out.push_back(kHex[c & 0x0F]);
+        }
+    }
+}
+
+void appendQueryValue(std::string& out, std::string_view value) {
+    appendEscaped(out, value);
+}
+
+void appendQueryValue(std::string& out, int value) {
+    appendChars(out, value);
+}
+
+void appendQueryValue(std::string& out, long value) {
+    appendChars(out, value);
+}
+
+void appendQueryValue(std::string& out, double value) {
+    appendChars(out, value, std::chars_format::fixed, 6);
+}
+
+void appendQueryValue(std::string& out, bool value) {
+    out.append(value ? "true" : "false");
+}
+
+void setupEasyHandle(RequestContext& context, curl_slist* postHeaders) {
+    CURL* curl = context.curl;
+    curl_easy_setopt(curl, CURLOPT_URL, context.request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context);
+    context.bodyStatus = 0;
+    if (context.bodySink) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &context);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, nullptr);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+    }
+    // Offers every encoding this libcurl was built with (gzip, and brotli
+    // or zstd when available); bodies reach the write callback decoded.
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+
+    if (context.request.isPost) {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, postHeaders);
+    }
+
+    context.errbuf[0] = 0;
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, context.errbuf);
+}
+
+void readResponseInfo(CURL* curl, HttpResponse& response) {
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.httpCode);
+#if LIBCURL_VERSION_NUM >= 0x074200
+    curl_off_t retryAfter = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter) == CURLE_OK) {
+        response.retryAfter = static_cast<long>(retryAfter);
+    }
+#endif
+
+    HttpTimings& timings = response.timings;
+#if LIBCURL_VERSION_NUM >= 0x073d00
+    auto get = [curl](CURLINFO info, int64_t& out) {
+        curl_off_t value = 0;
+        if (curl_easy_getinfo(curl, info, &value) == CURLE_OK) {
+            out = static_cast<int64_t>(value);
+        }
+    };
+    get(CURLINFO_NAMELOOKUP_TIME_T, timings.namelookup);
+    get(CURLINFO_CONNECT_TIME_T, timings.connect);
+    get(CURLINFO_APPCONNECT_TIME_T, timings.appconnect);
+    get(CURLINFO_STARTTRANSFER_TIME_T, timings.starttransfer);
+    get(CURLINFO_TOTAL_TIME_T, timings.total);
+    get(CURLINFO_SIZE_DOWNLOAD_T, timings.bytes);
+#else
+    auto get = [curl](CURLINFO info, int64_t& out, double scale) {
+        double value = 0;
+        if (curl_easy_getinfo(curl, info, &value) == CURLE_OK) {
+            out = static_cast<int64_t>(value * scale);
+        }
+    };
+    get(CURLINFO_NAMELOOKUP_TIME, timings.namelookup, 1e6);
+    get(CURLINFO_CONNECT_TIME, timings.connect, 1e6);
+    get(CURLINFO_APPCONNECT_TIME, timings.appconnect, 1e6);
+    get(CURLINFO_STARTTRANSFER_TIME, timings.starttransfer, 1e6);
+    get(CURLINFO_TOTAL_TIME, timings.total, 1e6);
+    get(CURLINFO_SIZE_DOWNLOAD, timings.bytes, 1);
+#endif
+}
+
+void prepareTransfer(RequestContext& context, curl_slist* postHeaders, std::chrono::milliseconds timeout) {
+    setupEasyHandle(context, postHeaders);
+    context.response.body.clear();
+    context.response.error.clear();
+    context.response.retryAfter = 0;
+    if (timeout.count() > 0) {
+        curl_easy_setopt(context.curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+    }
+}
+
+void finishTransfer(RequestContext& context, CURLcode code) {
+    HttpResponse& response = context.response;
+    response.curlCode = code;
+    if (code != CURLE_OK) {
+        response.error = context.errbuf;
+    }
+    readResponseInfo(context.curl, response);
+}
+
+} // namespace iris
@@ -1,15 +1,24 @@
 #include "iris/iris_api.hpp"
+#include "iris/async_engine.hpp"
+#include "iris/connection_pool.hpp"
+#include "iris/deep_link.hpp"
+#include "iris/http.hpp"
 #include <sstream>
 #include <stdexcept>
-#include <regex>
 #include <iostream>
+#include <thread>
 
 namespace iris {
 
 IrisApi::IrisApi(long botId, const std::string& irisToken, const std::string& baseUrl)
+    : IrisApi(botId, irisToken, std::make_shared<ConnectionPool>(), baseUrl) {
+}
+
+IrisApi::IrisApi(long botId, const std::string& irisToken,
+                 std::shared_ptr<ConnectionPool> pool, const std::string& baseUrl)
     : botId_(botId)
     , irisToken_(irisToken)
-    , curl_(nullptr) {
+    , pool_(std::move(pool)) {
     
     if (baseUrl.empty()) {
         std::stringstream ss;
@@ -20,522 +29,548 @@ IrisApi::IrisApi(long botId, const std::string& irisToken, const std::string& ba
         baseUrl_ = baseUrl;
     }
 
-    curl_ = curl_easy_init();
-    if (!curl_) {
-        throw std::runtime_error("Failed to initialize CURL");
+    if (!pool_) {
+        throw std::invalid_argument("Connection pool must not be null");
     }
-}
 
-IrisApi::~IrisApi() {
-    if (curl_) {
-        curl_easy_cleanup(curl_);
+    for (const EndpointRoute& route : kEndpointRoutes) {
+        std::string& prefix = urlPrefixes_[static_cast<size_t>(route.id)];
+        prefix.reserve(baseUrl_.size() + 1 + route.path.size());
+        prefix.append(baseUrl_).append("/").append(route.path);
     }
 }
 
-size_t IrisApi::WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
+IrisApi::~IrisApi() {
+    closing_.store(true, std::memory_order_release);
+    if (scheduler_) {
+        scheduler_->cancel(this);
+    }
+    // A shared engine, a transport or the scheduler thread outlives this
+    // client, and its pending completions and grants still point here. No
+    // retry is sent from now on, so only attempts already out are waited for.
+    if (engine_.use_count() > 1 || transport_ || scheduler_) {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    engine_.reset();
 }
 
-std::string IrisApi::makeRequest(const std::string& method, 
-                               const std::vector<std::pair<std::string, std::string>>& params,
-                               bool isPost) {
-    if (!curl_) {
-        throw std::runtime_error("CURL not initialized");
-    }
+namespace {
 
-    std::string url = buildUrl(method);
-    std::string postData;
-    
-    if (!params.empty()) {
-        url += "?";
-        for (size_t i = 0; i < params.size(); ++i) {
-            if (i > 0) url += "&";
-            char* escaped_key = curl_easy_escape(curl_, params[i].first.c_str(), 0);
-            char* escaped_value = curl_easy_escape(curl_, params[i].second.c_str(), 0);
-            url += std::string(escaped_key) + "=" + std::string(escaped_value);
-            curl_free(escaped_key);
-            curl_free(escaped_value);
-        }
-    }
+using Clock = ReadPolicy::Clock;
 
+struct MultiHandle {
+    CURLM* multi = curl_multi_init();
+    ~MultiHandle() { curl_multi_cleanup(multi); }
+};
 
+// Runs the leased transfer and, once it is slower than plan.hedgeAfter, a
+// copy on a second pooled connection. Whichever copy answers first without
+// a transport error or 5xx leaves its response in the lease.
+void performHedged(ConnectionPool& pool, RequestContext& context, const ReadPlan& plan, ReadPolicy& policy) {
+    thread_local MultiHandle holder;
+    CURLM* multi = holder.multi;
 
-    curl_easy_reset(curl_);
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 1L);
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, 2L);
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 30L);
-    
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
+    std::optional<ConnectionPool::Lease> hedge;
+    Clock::time_point hedgeAt = Clock::now() + plan.hedgeAfter;
+    curl_multi_add_handle(multi, context.curl);
+    int pending = 1;
 
-    if (isPost) {
-        curl_easy_setopt(curl_, CURLOPT_POST, 1L);
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, ""); 
-    }
+    RequestContext* winner = nullptr;
+    while (!winner) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
 
-    char errbuf[CURL_ERROR_SIZE];
-    curl_easy_setopt(curl_, CURLOPT_ERRORBUFFER, errbuf);
-    errbuf[0] = 0;
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            RequestContext& done = msg->easy_handle == context.curl ? context : hedge->context();
+            curl_multi_remove_handle(multi, done.curl);
+            --pending;
+            finishTransfer(done, msg->data.result);
+            if (!ReadPolicy::shouldRetry(done.response) || pending == 0) {
+                winner = &done;
+                break;
+            }
+        }
+        if (winner) {
+            break;
+        }
 
-    struct curl_slist* headers = nullptr;
-    if (isPost) {
-        headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
+        int waitMs = 1000;
+        if (!hedge) {
+            Clock::time_point now = Clock::now();
+            if (now >= hedgeAt) {
+                hedge.emplace(pool.acquire());
+                RequestContext& copy = hedge->context();
+                copy.request = context.request;
+                prepareTransfer(copy, pool.postHeaders(), plan.timeout);
+                curl_easy_setopt(copy.curl, CURLOPT_FRESH_CONNECT, 1L);
+                curl_multi_add_handle(multi, copy.curl);
+                ++pending;
+                continue;
+            }
+            auto untilHedge = std::chrono::duration_cast<std::chrono::milliseconds>(hedgeAt - now).count();
+            waitMs = static_cast<int>(std::min<int64_t>(untilHedge + 1, waitMs));
+        }
+        curl_multi_poll(multi, nullptr, 0, waitMs, nullptr);
     }
 
-    CURLcode res = curl_easy_perform(curl_);
-    
-    if (headers) {
-        curl_slist_free_all(headers);
+    if (!hedge) {
+        return;
     }
-
-    if (res != CURLE_OK) {
-        std::string error = errbuf[0] ? errbuf : curl_easy_strerror(res);
-        throw NetworkException("CURL error (" + std::to_string(res) + "): " + error);
+    // Drop the loser, if it is still running.
+    if (pending > 0) {
+        RequestContext& loser = winner == &context ? hedge->context() : context;
+        curl_multi_remove_handle(multi, loser.curl);
     }
+    bool hedgeWon = winner != &context;
+    if (hedgeWon) {
+        std::swap(context.response, hedge->context().response);
+    }
+    policy.countHedge(hedgeWon);
+}
 
-    long http_code = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_code);
-    
-
+} // namespace
+
+void IrisApi::perform(ConnectionPool::Lease& lease, const EndpointRoute& route) {
+    RequestContext& context = lease.context();
+    context.request.isPost = route.isPost;
+    HttpResponse& response = context.response;
+    RequestScheduler* scheduler = scheduler_.get();
+    ReadPolicy* policy = route.idempotent ? readPolicy_.get() : nullptr;
+    Clock::time_point requested = Clock::now();
+
+    for (int attempt = 0;; ++attempt) {
+        if (scheduler && !scheduler->acquire(route.requestClass, this)) {
+            response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+            response.httpCode = 0;
+            response.retryAfter = 0;
+            response.timings = {};
+            response.body.clear();
+            response.error = "Request dropped by the scheduler";
+            break;
+        }
+        Clock::time_point started = Clock::now();
+        ReadPlan plan{};
+        if (policy) {
+            plan = policy->plan(route.id);
+        }
+        if (transport_) {
+            transport_->perform(context.request, response);
+        } else {
+            prepareTransfer(context, pool_->postHeaders(), plan.timeout);
+            // A hedge copy would not stream into the same sink.
+            if (plan.hedgeAfter.count() > 0 && !context.bodySink) {
+                performHedged(*pool_, context, plan, *policy);
+            } else {
+                finishTransfer(context, curl_easy_perform(context.curl));
+            }
+        }
 
-    if (http_code != 200) {
-        std::string error_msg = "HTTP error " + std::to_string(http_code);
-        if (!response.empty()) {
-            try {
-                auto json = nlohmann::json::parse(response);
-                if (json.contains("error")) {
-                    error_msg += ": " + json["error"].get<std::string>();
-                } else if (json.contains("description")) {
-                    error_msg += ": " + json["description"].get<std::string>();
-                }
-            } catch (...) {
-                error_msg += ": " + response;
+        if (scheduler && scheduler->release(response) && attempt < scheduler->options().throttleRetries) {
+            continue;
+        }
+        if (policy) {
+            // A streamed body cut short has already passed records on.
+            bool streamed = context.bodySink && response.httpCode == 200;
+            if (ReadPolicy::shouldRetry(response) && !streamed && attempt + 1 < policy->options().maxAttempts) {
+                policy->countRetry();
+                std::this_thread::sleep_for(policy->backoff(attempt));
+                continue;
+            }
+            if (response.curlCode == CURLE_OK && response.httpCode < 400) {
+                policy->record(route.id, Clock::now() - started);
             }
         }
-        throw ApiResponseException(error_msg);
+        break;
     }
 
-    return response;
-}
-
-std::string IrisApi::buildUrl(const std::string& method) const {
-    return baseUrl_ + "/" + method;
+    if (metrics_) {
+        metrics_->recordRequest(route.id, response, Clock::now() - requested);
+    }
 }
 
-
-std::optional<Response> IrisApi::giveSweets(int count, long userId, 
-                                          const std::string& comment,
-                                          bool withoutDonateScore) {
-    if (count <= 0) {
-        throw std::invalid_argument("Count must be positive");
-    }
-    if (!comment.empty() && comment.length() > 128) {
-        throw std::invalid_argument("Comment must not exceed 128 characters");
+template <typename E, typename... Values>
+EndpointResult<E> IrisApi::tryCall(const E& endpoint, const Values&... values) {
+    try {
+        auto lease = pool_->acquire();
+        buildEndpointUrl(lease.context().request.url, urlPrefix(E::id), endpoint, values...);
+        perform(lease, E::route());
+        return decodeResponse(endpoint, metrics_.get(), lease.context().response);
+    } catch (const std::exception& e) {
+        // Only setup failures (curl init, allocation) get here.
+        Error error(ErrorCode::TRANSPORT);
+        error.curlCode = CURLE_FAILED_INIT;
+        error.detail = e.what();
+        return error;
     }
+}
 
-    std::vector<std::pair<std::string, std::string>> params;
-    params.emplace_back("sweets", std::to_string(count));
-    params.emplace_back("user_id", std::to_string(userId));
-    params.emplace_back("without_donate_score", withoutDonateScore ? "true" : "false");
-    if (!comment.empty()) {
-        params.emplace_back("comment", comment);
+template <typename E, typename... Values>
+typename E::result_type IrisApi::call(const E& endpoint, const Values&... values) {
+    auto result = tryCall(endpoint, values...);
+    if (!result) {
+#ifdef DEBUG_OUTPUT
+        std::cerr << "Request to " << E::route().path << " failed: " << result.error().message() << std::endl;
+#endif
+        return {};
     }
+    return std::move(*result);
+}
 
+template <typename E, typename... Values>
+Result<size_t> IrisApi::streamCall(const E& endpoint, const RecordSink<typename E::result_type::value_type>& onRecord,
+                                   const Values&... values) {
+    ArrayStreamDecoder<typename E::result_type::value_type> decoder(onRecord);
+    std::optional<Error> failure;
     try {
-        auto response = makeRequest("pocket/sweets/give", params, true);
-
-        auto json = nlohmann::json::parse(response);
-        Response result;
-        
-        if (json.contains("error")) {
-            result.error = APIError{
-                json["error"].contains("code") ? json["error"]["code"].get<int>() : 0,
-                json["error"].contains("description") ? 
-                    json["error"]["description"].get<std::string>() : "Unknown error"
-            };
-            result.result = 0;
-        } else {
-            result.result = json.contains("result") ? json["result"].get<int>() : 0;
+        auto lease = pool_->acquire();
+        RequestContext& context = lease.context();
+        buildEndpointUrl(context.request.url, urlPrefix(E::id), endpoint, values...);
+        context.bodySink = [&decoder](std::string_view chunk) { return decoder.feed(chunk); };
+        perform(lease, E::route());
+        context.bodySink = nullptr;
+
+        // A custom transport hands the body over whole.
+        const HttpResponse& response = context.response;
+        if (transport_ && response.httpCode == 200) {
+            decoder.feed(response.body);
+        }
+        bool decodeFailed = false;
+        if (!decoder.failed() && (response.curlCode != CURLE_OK || response.httpCode != 200)) {
+            failure = responseError(response);
+        } else if (!decoder.finish()) {
+            decodeFailed = true;
+            failure.emplace(ErrorCode::DECODE, response.httpCode);
+            failure->apiError = findApiError(decoder.rejected());
+            if (failure->apiError) {
+                failure->code = ErrorCode::API;
+            }
+            failure->detail = decoder.error();
+        }
+        if (metrics_ && response.httpCode == 200) {
+            // A transfer the decoder aborted was already counted as DECODE
+            // by recordRequest(); only a completed one is moved over here.
+            bool aborted = response.curlCode == CURLE_WRITE_ERROR;
+            metrics_->recordDecode(E::id, decoder.decodeTime(), !decodeFailed || aborted);
         }
-        
-        return result;
-    } catch (const nlohmann::json::parse_error& e) {
-#ifdef DEBUG_OUTPUT
-        std::cerr << "JSON parse error: " << e.what() << std::endl;
-#endif
-        return std::nullopt;
     } catch (const std::exception& e) {
-
-        return std::nullopt;
+        failure.emplace(ErrorCode::TRANSPORT);
+        failure->curlCode = CURLE_FAILED_INIT;
+        failure->detail = e.what();
+    }
+    if (decoder.exception()) {
+        std::rethrow_exception(decoder.exception());
     }
+    if (failure) {
+        return std::move(*failure);
+    }
+    return decoder.count();
 }
 
-std::optional<BalanceData> IrisApi::getBalance() {
-    try {
-        auto response = makeRequest("pocket/balance");
-        return nlohmann::json::parse(response).get<BalanceData>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+AsyncEngine& IrisApi::engine() {
+    std::call_once(engineOnce_, [this] {
+        if (!engine_) {
+            engine_ = std::make_shared<AsyncEngine>(pool_->share());
+        }
+    });
+    return *engine_;
 }
 
-std::optional<Response> IrisApi::giveGold(int count, long userId,
-                                        const std::string& comment,
-                                        bool withoutDonateScore) {
+const char* IrisApi::transferError(int count, const std::string& comment) {
     if (count <= 0) {
-        throw std::invalid_argument("Count must be positive");
+        return "Count must be positive";
     }
     if (!comment.empty() && comment.length() > 128) {
-        throw std::invalid_argument("Comment must not exceed 128 characters");
+        return "Comment must not exceed 128 characters";
     }
+    return nullptr;
+}
 
-    std::vector<std::pair<std::string, std::string>> params = {
-        {"gold", std::to_string(count)},
-        {"user_id", std::to_string(userId)},
-        {"without_donate_score", withoutDonateScore ? "true" : "false"}
-    };
-    if (!comment.empty()) {
-        params.emplace_back("comment", comment);
+const char* IrisApi::priceError(double price) {
+    if (price < 0.01 || price > 1000000.0) {
+        return "Price must be between 0.01 and 1,000,000";
     }
+    return nullptr;
+}
 
-    try {
-        auto response = makeRequest("pocket/gold/give", params, true);
-        return nlohmann::json::parse(response).get<Response>();
-    } catch (const std::exception&) {
-        return std::nullopt;
+void IrisApi::validateTransfer(int count, const std::string& comment) {
+    if (const char* reason = transferError(count, comment)) {
+        throw std::invalid_argument(reason);
     }
 }
 
-std::optional<Response> IrisApi::giveDonateScore(int count, long userId,
-                                               const std::string& comment) {
-    if (count <= 0) {
-        throw std::invalid_argument("Count must be positive");
-    }
-    if (!comment.empty() && comment.length() > 128) {
-        throw std::invalid_argument("Comment must not exceed 128 characters");
+void IrisApi::validatePrice(double price) {
+    if (const char* reason = priceError(price)) {
+        throw std::invalid_argument(reason);
     }
+}
 
-    std::vector<std::pair<std::string, std::string>> params = {
-        {"amount", std::to_string(count)},
-        {"user_id", std::to_string(userId)}
-    };
-    if (!comment.empty()) {
-        params.emplace_back("comment", comment);
-    }
+std::optional<Response> IrisApi::giveSweets(int count, long userId, 
+                                          const std::string& comment,
+                                          bool withoutDonateScore) {
+    validateTransfer(count, comment);
+    return call(endpoints::kGiveSweets, count, userId, withoutDonateScore,
+                optionalParam<std::string_view>(comment, !comment.empty()));
+}
 
-    try {
-        auto response = makeRequest("pocket/donate_score/give", params, true);
-        return nlohmann::json::parse(response).get<Response>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+std::optional<BalanceData> IrisApi::getBalance() {
+    return call(endpoints::kBalance);
+}
+
+std::optional<Response> IrisApi::giveGold(int count, long userId,
+                                        const std::string& comment,
+                                        bool withoutDonateScore) {
+    validateTransfer(count, comment);
+    return call(endpoints::kGiveGold, count, userId, withoutDonateScore,
+                optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+std::optional<Response> IrisApi::giveDonateScore(int count, long userId,
+                                               const std::string& comment) {
+    validateTransfer(count, comment);
+    return call(endpoints::kGiveDonateScore, count, userId,
+                optionalParam<std::string_view>(comment, !comment.empty()));
 }
 
 std::vector<HistoryData> IrisApi::getSweetsHistory(int offset) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params;
-        if (offset > 0) {
-            params.emplace_back("offset", std::to_string(offset));
-        }
-        auto response = makeRequest("pocket/sweets/history", params);
-        return nlohmann::json::parse(response).get<std::vector<HistoryData>>();
-    } catch (const std::exception&) {
-        return {};
-    }
+    return call(endpoints::kSweetsHistory, optionalParam(offset, offset > 0));
 }
 
 std::vector<HistoryData> IrisApi::getGoldHistory(int offset) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params;
-        if (offset > 0) {
-            params.emplace_back("offset", std::to_string(offset));
-        }
-        auto response = makeRequest("pocket/gold/history", params);
-        return nlohmann::json::parse(response).get<std::vector<HistoryData>>();
-    } catch (const std::exception&) {
-        return {};
-    }
+    return call(endpoints::kGoldHistory, optionalParam(offset, offset > 0));
 }
 
 std::vector<HistoryData> IrisApi::getDonateScoreHistory(int offset) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params;
-        if (offset > 0) {
-            params.emplace_back("offset", std::to_string(offset));
-        }
-        auto response = makeRequest("pocket/donate_score/history", params);
-        return nlohmann::json::parse(response).get<std::vector<HistoryData>>();
-    } catch (const std::exception&) {
-        return {};
-    }
+    return call(endpoints::kDonateScoreHistory, optionalParam(offset, offset > 0));
 }
 
 std::optional<Response> IrisApi::enablePocket(bool enable) {
-    try {
-        auto response = makeRequest(enable ? "pocket/enable" : "pocket/disable", {}, true);
-        return nlohmann::json::parse(response).get<Response>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return enable ? call(endpoints::kPocketEnable) : call(endpoints::kPocketDisable);
 }
 
 std::optional<Response> IrisApi::enableAllPocket(bool enable) {
-    try {
-        auto response = makeRequest(enable ? "pocket/allow_all" : "pocket/deny_all", {}, true);
-        return nlohmann::json::parse(response).get<Response>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return enable ? call(endpoints::kPocketAllowAll) : call(endpoints::kPocketDenyAll);
 }
 
 std::optional<Response> IrisApi::allowUserPocket(long userId, bool enable) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest(enable ? "pocket/allow_user" : "pocket/deny_user", params, true);
-        return nlohmann::json::parse(response).get<Response>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return enable ? call(endpoints::kPocketAllowUser, userId)
+                  : call(endpoints::kPocketDenyUser, userId);
 }
 
-std::vector<UpdatesLog> IrisApi::getUpdates(int offset, int limit) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params;
-        if (offset > 0) params.emplace_back("offset", std::to_string(offset));
-        if (limit > 0) params.emplace_back("limit", std::to_string(limit));
-        
-        auto response = makeRequest("getUpdates", params, true);
-        return nlohmann::json::parse(response).get<std::vector<UpdatesLog>>();
-    } catch (const std::exception&) {
-        return {};
-    }
+std::vector<UpdatesLog> IrisApi::getUpdates(long offset, int limit) {
+    return call(endpoints::kGetUpdates, optionalParam(offset, offset > 0),
+                optionalParam(limit, limit > 0));
 }
 
 std::vector<long> IrisApi::getIrisAgents() {
-    try {
-        auto response = makeRequest("iris_agents");
-        return nlohmann::json::parse(response).get<std::vector<long>>();
-    } catch (const std::exception&) {
-        return {};
-    }
+    return call(endpoints::kIrisAgents);
 }
 
 std::optional<UserRegInfo> IrisApi::checkUserReg(long userId) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest("user_info/reg", params, true);
-        return nlohmann::json::parse(response).get<UserRegInfo>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kUserReg, userId);
 }
 
 std::optional<UserSpamInfo> IrisApi::checkUserSpam(long userId) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest("user_info/spam", params, true);
-        return nlohmann::json::parse(response).get<UserSpamInfo>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kUserSpam, userId);
 }
 
 std::optional<UserActivityInfo> IrisApi::checkUserActivity(long userId) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest("user_info/activity", params, true);
-        return nlohmann::json::parse(response).get<UserActivityInfo>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kUserActivity, userId);
 }
 
 std::optional<UserStarsInfo> IrisApi::checkUserStars(long userId) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest("user_info/stars", params, true);
-        return nlohmann::json::parse(response).get<UserStarsInfo>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kUserStars, userId);
 }
 
 std::optional<UserPocketInfo> IrisApi::checkUserPocket(long userId) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"user_id", std::to_string(userId)}
-        };
-        auto response = makeRequest("user_info/pocket", params, true);
-        return nlohmann::json::parse(response).get<UserPocketInfo>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kUserPocket, userId);
 }
 
 std::optional<BuyTradesResponse> IrisApi::buyTrade(double price, int volume) {
-    if (price < 0.01 || price > 1000000.0) {
-        throw std::invalid_argument("Price must be between 0.01 and 1,000,000");
-    }
-
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"price", std::to_string(price)},
-            {"volume", std::to_string(volume)}
-        };
-        auto response = makeRequest("trade/buy", params);
-        return nlohmann::json::parse(response).get<BuyTradesResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    validatePrice(price);
+    return call(endpoints::kTradeBuy, price, volume);
 }
 
 std::optional<SellTradesResponse> IrisApi::sellTrade(double price, int volume) {
-    if (price < 0.01 || price > 1000000.0) {
-        throw std::invalid_argument("Price must be between 0.01 and 1,000,000");
-    }
-
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"price", std::to_string(price)},
-            {"volume", std::to_string(volume)}
-        };
-        auto response = makeRequest("trade/sell", params);
-        return nlohmann::json::parse(response).get<SellTradesResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    validatePrice(price);
+    return call(endpoints::kTradeSell, price, volume);
 }
 
 std::optional<OrdersResponse> IrisApi::getOrdersTrade() {
-    try {
-        auto response = makeRequest("trade/my_orders");
-        return nlohmann::json::parse(response).get<OrdersResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
-    }
+    return call(endpoints::kTradeMyOrders);
 }
 
 std::optional<CancelTradesResponse> IrisApi::cancelPriceTrade(double price) {
-    if (price < 0.01 || price > 1000000.0) {
-        throw std::invalid_argument("Price must be between 0.01 and 1,000,000");
-    }
+    validatePrice(price);
+    return call(endpoints::kTradeCancelPrice, price);
+}
 
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"price", std::to_string(price)}
-        };
-        auto response = makeRequest("trade/cancel_price", params);
-        return nlohmann::json::parse(response).get<CancelTradesResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
+std::optional<CancelTradesResponse> IrisApi::cancelAllTrade() {
+    return call(endpoints::kTradeCancelAll);
+}
+
+std::optional<CancelTradesResponse> IrisApi::cancelPartTrade(int id, int volume) {
+    return call(endpoints::kTradeCancelPart, id, volume);
+}
+
+Result<Response> IrisApi::tryGiveSweets(int count, long userId, const std::string& comment,
+                                        bool withoutDonateScore) {
+    if (const char* reason = transferError(count, comment)) {
+        return invalidArgument(reason);
     }
+    return rejectApiError(tryCall(endpoints::kGiveSweets, count, userId, withoutDonateScore,
+                                  optionalParam<std::string_view>(comment, !comment.empty())));
 }
 
-std::optional<CancelTradesResponse> IrisApi::cancelAllTrade() {
-    try {
-        auto response = makeRequest("trade/cancel_all");
-        return nlohmann::json::parse(response).get<CancelTradesResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
+Result<Response> IrisApi::tryGiveGold(int count, long userId, const std::string& comment,
+                                      bool withoutDonateScore) {
+    if (const char* reason = transferError(count, comment)) {
+        return invalidArgument(reason);
     }
+    return rejectApiError(tryCall(endpoints::kGiveGold, count, userId, withoutDonateScore,
+                                  optionalParam<std::string_view>(comment, !comment.empty())));
 }
 
-std::optional<CancelTradesResponse> IrisApi::cancelPartTrade(int id, int volume) {
-    try {
-        std::vector<std::pair<std::string, std::string>> params = {
-            {"id", std::to_string(id)},
-            {"volume", std::to_string(volume)}
-        };
-        auto response = makeRequest("trade/cancel_part", params);
-        return nlohmann::json::parse(response).get<CancelTradesResponse>();
-    } catch (const std::exception&) {
-        return std::nullopt;
+Result<Response> IrisApi::tryGiveDonateScore(int count, long userId, const std::string& comment) {
+    if (const char* reason = transferError(count, comment)) {
+        return invalidArgument(reason);
     }
+    return rejectApiError(tryCall(endpoints::kGiveDonateScore, count, userId,
+                                  optionalParam<std::string_view>(comment, !comment.empty())));
 }
 
-std::string IrisApi::generateDeepLink(Currency currency, int count,
-                                    const std::string& comment) {
-    if (count <= 0) {
-        throw std::invalid_argument("Count must be positive");
+Result<BalanceData> IrisApi::tryGetBalance() {
+    return tryCall(endpoints::kBalance);
+}
+
+Result<std::vector<HistoryData>> IrisApi::tryGetSweetsHistory(int offset) {
+    return tryCall(endpoints::kSweetsHistory, optionalParam(offset, offset > 0));
+}
+
+Result<std::vector<HistoryData>> IrisApi::tryGetGoldHistory(int offset) {
+    return tryCall(endpoints::kGoldHistory, optionalParam(offset, offset > 0));
+}
+
+Result<std::vector<HistoryData>> IrisApi::tryGetDonateScoreHistory(int offset) {
+    return tryCall(endpoints::kDonateScoreHistory, optionalParam(offset, offset > 0));
+}
+
+Result<Response> IrisApi::tryEnablePocket(bool enable) {
+    return rejectApiError(enable ? tryCall(endpoints::kPocketEnable) : tryCall(endpoints::kPocketDisable));
+}
+
+Result<Response> IrisApi::tryEnableAllPocket(bool enable) {
+    return rejectApiError(enable ? tryCall(endpoints::kPocketAllowAll) : tryCall(endpoints::kPocketDenyAll));
+}
+
+Result<Response> IrisApi::tryAllowUserPocket(long userId, bool enable) {
+    return rejectApiError(enable ? tryCall(endpoints::kPocketAllowUser, userId)
+                                 : tryCall(endpoints::kPocketDenyUser, userId));
+}
+
+Result<std::vector<UpdatesLog>> IrisApi::tryGetUpdates(long offset, int limit) {
+    return tryCall(endpoints::kGetUpdates, optionalParam(offset, offset > 0),
+                   optionalParam(limit, limit > 0));
+}
+
+Result<size_t> IrisApi::streamSweetsHistory(int offset, const RecordSink<HistoryData>& onRecord) {
+    return streamCall(endpoints::kSweetsHistory, onRecord, optionalParam(offset, offset > 0));
+}
+
+Result<size_t> IrisApi::streamGoldHistory(int offset, const RecordSink<HistoryData>& onRecord) {
+    return streamCall(endpoints::kGoldHistory, onRecord, optionalParam(offset, offset > 0));
+}
+
+Result<size_t> IrisApi::streamDonateScoreHistory(int offset, const RecordSink<HistoryData>& onRecord) {
+    return streamCall(endpoints::kDonateScoreHistory, onRecord, optionalParam(offset, offset > 0));
+}
+
+Result<size_t> IrisApi::streamUpdates(long offset, int limit, const RecordSink<UpdatesLog>& onRecord) {
+    return streamCall(endpoints::kGetUpdates, onRecord, optionalParam(offset, offset > 0),
+                      optionalParam(limit, limit > 0));
+}
+
+Result<std::vector<long>> IrisApi::tryGetIrisAgents() {
+    return tryCall(endpoints::kIrisAgents);
+}
+
+Result<UserRegInfo> IrisApi::tryCheckUserReg(long userId) {
+    return tryCall(endpoints::kUserReg, userId);
+}
+
+Result<UserSpamInfo> IrisApi::tryCheckUserSpam(long userId) {
+    return tryCall(endpoints::kUserSpam, userId);
+}
+
+Result<UserActivityInfo> IrisApi::tryCheckUserActivity(long userId) {
+    return tryCall(endpoints::kUserActivity, userId);
+}
+
+Result<UserStarsInfo> IrisApi::tryCheckUserStars(long userId) {
+    return tryCall(endpoints::kUserStars, userId);
+}
+
+Result<UserPocketInfo> IrisApi::tryCheckUserPocket(long userId) {
+    return tryCall(endpoints::kUserPocket, userId);
+}
+
+Result<BuyTradesResponse> IrisApi::tryBuyTrade(double price, int volume) {
+    if (const char* reason = priceError(price)) {
+        return invalidArgument(reason);
     }
+    return tryCall(endpoints::kTradeBuy, price, volume);
+}
 
-    if (!comment.empty()) {
-        if (comment.length() > 128) {
-            throw std::invalid_argument("Comment must not exceed 128 characters");
-        }
-        
-        static const std::regex pattern("^[a-zA-Z0-9_]+$");
-        if (!std::regex_match(comment, pattern)) {
-            throw std::invalid_argument("Comment can only contain letters, numbers and underscore");
-        }
+Result<SellTradesResponse> IrisApi::trySellTrade(double price, int volume) {
+    if (const char* reason = priceError(price)) {
+        return invalidArgument(reason);
     }
+    return tryCall(endpoints::kTradeSell, price, volume);
+}
 
-    std::stringstream url;
-    url << "https://t.me/iris_black_bot?start=";
-    
-    switch (currency) {
-        case Currency::GOLD:
-            url << "givegold_bot";
-            break;
-        case Currency::SWEETS:
-            url << "give_bot";
-            break;
-        case Currency::DONATE_SCORE:
-            url << "givedonate_score_bot";
-            break;
+Result<OrdersResponse> IrisApi::tryGetOrdersTrade() {
+    return tryCall(endpoints::kTradeMyOrders);
+}
+
+Result<CancelTradesResponse> IrisApi::tryCancelPriceTrade(double price) {
+    if (const char* reason = priceError(price)) {
+        return invalidArgument(reason);
     }
+    return tryCall(endpoints::kTradeCancelPrice, price);
+}
 
-    url << botId_ << "_" << count;
-    
-    if (!comment.empty()) {
-        url << "_" << comment;
+Result<CancelTradesResponse> IrisApi::tryCancelAllTrade() {
+    return tryCall(endpoints::kTradeCancelAll);
+}
+
+Result<CancelTradesResponse> IrisApi::tryCancelPartTrade(int id, int volume) {
+    return tryCall(endpoints::kTradeCancelPart, id, volume);
+}
+
+std::string IrisApi::generateDeepLink(Currency currency, int count,
+                                    const std::string& comment) {
+    if (const char* reason = deepLinkError(count, comment)) {
+        throw std::invalid_argument(reason);
     }
+    std::string url;
+    appendDeepLink(url, botId_, currency, count, comment);
+    return url;
+}
 
-    return url.str();
+DeepLinks IrisApi::generateDeepLinks(const std::vector<DeepLinkItem>& items) const {
+    return makeDeepLinks(botId_, items);
 }
 
 std::string IrisApi::generateBotPermissionsDeepLink(
     const std::vector<BotPermission>& permissions) {
-    std::stringstream url;
-    url << "https://t.me/iris_black_bot?start=request_rights_" << botId_;
-
-    for (const auto& permission : permissions) {
-        url << "_";
-        switch (permission) {
-            case BotPermission::REG:
-                url << "reg";
-                break;
-            case BotPermission::ACTIVITY:
-                url << "activity";
-                break;
-            case BotPermission::SPAM:
-                url << "spam";
-                break;
-            case BotPermission::STARS:
-                url << "stars";
-                break;
-            case BotPermission::POCKET:
-                url << "pocket";
-                break;
-        }
-    }
-
-    return url.str();
+    std::string url;
+    appendBotPermissionsDeepLink(url, botId_, permissions);
+    return url;
 }
 
 } // namespace iris
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include "iris/iris_api.hpp"
+#include "iris/async_engine.hpp"
+#include "iris/http.hpp"
+#include <iostream>
+
+namespace iris {
+
+namespace {
+
+// Marks an async call finished once its callback has returned.
+struct PendingCall {
+    std::atomic<size_t>& count;
+    ~PendingCall() { count.fetch_sub(1, std::memory_order_release); }
+};
+
+} // namespace
+
+template <typename E, typename... Values>
+void IrisApi::tryCallAsync(const E& endpoint, Callback<EndpointResult<E>> done, const Values&... values) {
+    HttpRequest request;
+    request.isPost = E::route().isPost;
+    buildEndpointUrl(request.url, urlPrefix(E::id), endpoint, values...);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    send(E::route(), std::move(request),
+         [&endpoint, done = std::move(done), metrics = metrics_, &pending = pending_,
+          requested = Metrics::Clock::now()](HttpResponse response) {
+        PendingCall finished{pending};
+        if (metrics) {
+            metrics->recordRequest(E::id, response, Metrics::Clock::now() - requested);
+        }
+        done(decodeResponse(endpoint, metrics.get(), response));
+    });
+}
+
+template <typename E, typename... Values>
+void IrisApi::callAsync(const E& endpoint, Callback<typename E::result_type> done,
+                        const Values&... values) {
+    using T = typename E::result_type;
+
+    tryCallAsync(endpoint, [done = std::move(done)](EndpointResult<E> result) {
+        if (!result) {
+#ifdef DEBUG_OUTPUT
+            std::cerr << "Async request to " << E::route().path << " failed: " << result.error().message() << std::endl;
+#endif
+            done(T{});
+            return;
+        }
+        done(T(std::move(*result)));
+    }, values...);
+}
+
+void IrisApi::send(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+                   int attempt, std::chrono::milliseconds delay) {
+    if (!scheduler_) {
+        transmit(route, std::move(request), std::move(done), attempt, delay);
+        return;
+    }
+
+    auto grant = [this, &route, request = std::move(request), done = std::move(done), attempt,
+                  delay](bool granted) mutable {
+        if (!granted) {
+            HttpResponse response;
+            response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+            response.error = "Request dropped by the scheduler";
+            done(std::move(response));
+            return;
+        }
+        transmit(route, std::move(request), std::move(done), attempt, delay);
+    };
+    scheduler_->submit(route.requestClass, std::move(grant), this);
+}
+
+void IrisApi::transmit(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+                       int attempt, std::chrono::milliseconds delay) {
+    std::shared_ptr<ReadPolicy> policy = route.idempotent ? readPolicy_ : nullptr;
+    if (!scheduler_ && !policy) {
+        if (transport_) {
+            transport_->submit(std::move(request), std::move(done));
+        } else {
+            engine().submit(std::move(request), std::move(done));
+        }
+        return;
+    }
+
+    TransferOptions options;
+    options.delay = delay;
+    if (policy) {
+        ReadPlan plan = policy->plan(route.id);
+        options.timeout = plan.timeout;
+        options.hedgeAfter = plan.hedgeAfter;
+        options.onHedge = [policy](bool won) { policy->countHedge(won); };
+    }
+    auto started = ReadPolicy::Clock::now() + delay;
+
+    HttpRequest copy = request;
+    AsyncEngine::Completion completion = [this, &route, scheduler = scheduler_, policy,
+                                          request = std::move(request), done = std::move(done), attempt,
+                                          started](HttpResponse response) mutable {
+        // Once the client is being destroyed, the last answer stands.
+        bool closing = closing_.load(std::memory_order_acquire);
+        if (scheduler && scheduler->release(response) && attempt < scheduler->options().throttleRetries
+            && !closing) {
+            resend(route, std::move(request), std::move(done), attempt + 1, {});
+            return;
+        }
+        if (policy) {
+            if (ReadPolicy::shouldRetry(response) && attempt + 1 < policy->options().maxAttempts && !closing) {
+                policy->countRetry();
+                resend(route, std::move(request), std::move(done), attempt + 1, policy->backoff(attempt));
+                return;
+            }
+            if (response.curlCode == CURLE_OK && response.httpCode < 400) {
+                policy->record(route.id, ReadPolicy::Clock::now() - started);
+            }
+        }
+        done(std::move(response));
+    };
+    if (transport_) {
+        // Hedging, per-attempt timeouts and retry backoff belong to the
+        // built-in curl path; a custom transport retries at once.
+        transport_->submit(std::move(copy), std::move(completion));
+    } else {
+        engine().submit(std::move(copy), std::move(completion), std::move(options));
+    }
+}
+
+void IrisApi::resend(const EndpointRoute& route, HttpRequest request, std::function<void(HttpResponse)> done,
+                     int attempt, std::chrono::milliseconds delay) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    send(route, std::move(request), [&pending = pending_, done = std::move(done)](HttpResponse response) {
+        PendingCall finished{pending};
+        done(std::move(response));
+    }, attempt, delay);
+}
+
+void IrisApi::giveSweetsAsync(int count, long userId, const std::string& comment,
+                              bool withoutDonateScore, Callback<std::optional<Response>> done) {
+    validateTransfer(count, comment);
+    callAsync(endpoints::kGiveSweets, std::move(done), count, userId, withoutDonateScore,
+              optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<std::optional<Response>> IrisApi::giveSweetsAsync(int count, long userId,
+                                                         const std::string& comment,
+                                                         bool withoutDonateScore) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        giveSweetsAsync(count, userId, comment, withoutDonateScore, std::move(done));
+    });
+}
+
+void IrisApi::giveGoldAsync(int count, long userId, const std::string& comment,
+                            bool withoutDonateScore, Callback<std::optional<Response>> done) {
+    validateTransfer(count, comment);
+    callAsync(endpoints::kGiveGold, std::move(done), count, userId, withoutDonateScore,
+              optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<std::optional<Response>> IrisApi::giveGoldAsync(int count, long userId,
+                                                       const std::string& comment,
+                                                       bool withoutDonateScore) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        giveGoldAsync(count, userId, comment, withoutDonateScore, std::move(done));
+    });
+}
+
+void IrisApi::giveDonateScoreAsync(int count, long userId, const std::string& comment,
+                                   Callback<std::optional<Response>> done) {
+    validateTransfer(count, comment);
+    callAsync(endpoints::kGiveDonateScore, std::move(done), count, userId,
+              optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<std::optional<Response>> IrisApi::giveDonateScoreAsync(int count, long userId,
+                                                              const std::string& comment) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        giveDonateScoreAsync(count, userId, comment, std::move(done));
+    });
+}
+
+void IrisApi::getBalanceAsync(Callback<std::optional<BalanceData>> done) {
+    callAsync(endpoints::kBalance, std::move(done));
+}
+
+Future<std::optional<BalanceData>> IrisApi::getBalanceAsync() {
+    return makeFuture<std::optional<BalanceData>>([&](auto done) {
+        getBalanceAsync(std::move(done));
+    });
+}
+
+void IrisApi::getSweetsHistoryAsync(int offset, Callback<std::vector<HistoryData>> done) {
+    callAsync(endpoints::kSweetsHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<std::vector<HistoryData>> IrisApi::getSweetsHistoryAsync(int offset) {
+    return makeFuture<std::vector<HistoryData>>([&](auto done) {
+        getSweetsHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::getGoldHistoryAsync(int offset, Callback<std::vector<HistoryData>> done) {
+    callAsync(endpoints::kGoldHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<std::vector<HistoryData>> IrisApi::getGoldHistoryAsync(int offset) {
+    return makeFuture<std::vector<HistoryData>>([&](auto done) {
+        getGoldHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::getDonateScoreHistoryAsync(int offset, Callback<std::vector<HistoryData>> done) {
+    callAsync(endpoints::kDonateScoreHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<std::vector<HistoryData>> IrisApi::getDonateScoreHistoryAsync(int offset) {
+    return makeFuture<std::vector<HistoryData>>([&](auto done) {
+        getDonateScoreHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::tryGiveSweetsAsync(int count, long userId, const std::string& comment,
+                                 bool withoutDonateScore, Callback<Result<Response>> done) {
+    if (const char* reason = transferError(count, comment)) {
+        done(invalidArgument(reason));
+        return;
+    }
+    tryCallAsync(endpoints::kGiveSweets, [done = std::move(done)](Result<Response> result) {
+        done(rejectApiError(std::move(result)));
+    }, count, userId, withoutDonateScore, optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<Result<Response>> IrisApi::tryGiveSweetsAsync(int count, long userId, const std::string& comment,
+                                                     bool withoutDonateScore) {
+    return makeFuture<Result<Response>>([&](auto done) {
+        tryGiveSweetsAsync(count, userId, comment, withoutDonateScore, std::move(done));
+    });
+}
+
+void IrisApi::tryGiveGoldAsync(int count, long userId, const std::string& comment,
+                               bool withoutDonateScore, Callback<Result<Response>> done) {
+    if (const char* reason = transferError(count, comment)) {
+        done(invalidArgument(reason));
+        return;
+    }
+    tryCallAsync(endpoints::kGiveGold, [done = std::move(done)](Result<Response> result) {
+        done(rejectApiError(std::move(result)));
+    }, count, userId, withoutDonateScore, optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<Result<Response>> IrisApi::tryGiveGoldAsync(int count, long userId, const std::string& comment,
+                                                   bool withoutDonateScore) {
+    return makeFuture<Result<Response>>([&](auto done) {
+        tryGiveGoldAsync(count, userId, comment, withoutDonateScore, std::move(done));
+    });
+}
+
+void IrisApi::tryGiveDonateScoreAsync(int count, long userId, const std::string& comment,
+                                      Callback<Result<Response>> done) {
+    if (const char* reason = transferError(count, comment)) {
+        done(invalidArgument(reason));
+        return;
+    }
+    tryCallAsync(endpoints::kGiveDonateScore, [done = std::move(done)](Result<Response> result) {
+        done(rejectApiError(std::move(result)));
+    }, count, userId, optionalParam<std::string_view>(comment, !comment.empty()));
+}
+
+Future<Result<Response>> IrisApi::tryGiveDonateScoreAsync(int count, long userId, const std::string& comment) {
+    return makeFuture<Result<Response>>([&](auto done) {
+        tryGiveDonateScoreAsync(count, userId, comment, std::move(done));
+    });
+}
+
+void IrisApi::tryGetSweetsHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done) {
+    tryCallAsync(endpoints::kSweetsHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<Result<std::vector<HistoryData>>> IrisApi::tryGetSweetsHistoryAsync(int offset) {
+    return makeFuture<Result<std::vector<HistoryData>>>([&](auto done) {
+        tryGetSweetsHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::tryGetGoldHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done) {
+    tryCallAsync(endpoints::kGoldHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<Result<std::vector<HistoryData>>> IrisApi::tryGetGoldHistoryAsync(int offset) {
+    return makeFuture<Result<std::vector<HistoryData>>>([&](auto done) {
+        tryGetGoldHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::tryGetDonateScoreHistoryAsync(int offset, Callback<Result<std::vector<HistoryData>>> done) {
+    tryCallAsync(endpoints::kDonateScoreHistory, std::move(done), optionalParam(offset, offset > 0));
+}
+
+Future<Result<std::vector<HistoryData>>> IrisApi::tryGetDonateScoreHistoryAsync(int offset) {
+    return makeFuture<Result<std::vector<HistoryData>>>([&](auto done) {
+        tryGetDonateScoreHistoryAsync(offset, std::move(done));
+    });
+}
+
+void IrisApi::enablePocketAsync(bool enable, Callback<std::optional<Response>> done) {
+    if (enable) {
+        callAsync(endpoints::kPocketEnable, std::move(done));
+    } else {
+        callAsync(endpoints::kPocketDisable, std::move(done));
+    }
+}
+
+Future<std::optional<Response>> IrisApi::enablePocketAsync(bool enable) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        enablePocketAsync(enable, std::move(done));
+    });
+}
+
+void IrisApi::enableAllPocketAsync(bool enable, Callback<std::optional<Response>> done) {
+    if (enable) {
+        callAsync(endpoints::kPocketAllowAll, std::move(done));
+    } else {
+        callAsync(endpoints::kPocketDenyAll, std::move(done));
+    }
+}
+
+Future<std::optional<Response>> IrisApi::enableAllPocketAsync(bool enable) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        enableAllPocketAsync(enable, std::move(done));
+    });
+}
+
+void IrisApi::allowUserPocketAsync(long userId, bool enable,
+                                   Callback<std::optional<Response>> done) {
+    if (enable) {
+        callAsync(endpoints::kPocketAllowUser, std::move(done), userId);
+    } else {
+        callAsync(endpoints::kPocketDenyUser, std::move(done), userId);
+    }
+}
+
+Future<std::optional<Response>> IrisApi::allowUserPocketAsync(long userId, bool enable) {
+    return makeFuture<std::optional<Response>>([&](auto done) {
+        allowUserPocketAsync(userId, enable, std::move(done));
+    });
+}
+
+void IrisApi::getUpdatesAsync(long offset, int limit, Callback<std::vector<UpdatesLog>> done) {
+    callAsync(endpoints::kGetUpdates, std::move(done), optionalParam(offset, offset > 0),
+              optionalParam(limit, limit > 0));
+}
+
+Future<std::vector<UpdatesLog>> IrisApi::getUpdatesAsync(long offset, int limit) {
+    return makeFuture<std::vector<UpdatesLog>>([&](auto done) {
+        getUpdatesAsync(offset, limit, std::move(done));
+    });
+}
+
+void IrisApi::getIrisAgentsAsync(Callback<std::vector<long>> done) {
+    callAsync(endpoints::kIrisAgents, std::move(done));
+}
+
+Future<std::vector<long>> IrisApi::getIrisAgentsAsync() {
+    return makeFuture<std::vector<long>>([&](auto done) {
+        getIrisAgentsAsync(std::move(done));
+    });
+}
+
+void IrisApi::checkUserRegAsync(long userId, Callback<std::optional<UserRegInfo>> done) {
+    callAsync(endpoints::kUserReg, std::move(done), userId);
+}
+
+Future<std::optional<UserRegInfo>> IrisApi::checkUserRegAsync(long userId) {
+    return makeFuture<std::optional<UserRegInfo>>([&](auto done) {
+        checkUserRegAsync(userId, std::move(done));
+    });
+}
+
+void IrisApi::checkUserSpamAsync(long userId, Callback<std::optional<UserSpamInfo>> done) {
+    callAsync(endpoints::kUserSpam, std::move(done), userId);
+}
+
+Future<std::optional<UserSpamInfo>> IrisApi::checkUserSpamAsync(long userId) {
+    return makeFuture<std::optional<UserSpamInfo>>([&](auto done) {
+        checkUserSpamAsync(userId, std::move(done));
+    });
+}
+
+void IrisApi::checkUserActivityAsync(long userId, Callback<std::optional<UserActivityInfo>> done) {
+    callAsync(endpoints::kUserActivity, std::move(done), userId);
+}
+
+Future<std::optional<UserActivityInfo>> IrisApi::checkUserActivityAsync(long userId) {
+    return makeFuture<std::optional<UserActivityInfo>>([&](auto done) {
+        checkUserActivityAsync(userId, std::move(done));
+    });
+}
+
+void IrisApi::checkUserStarsAsync(long userId, Callback<std::optional<UserStarsInfo>> done) {
+    callAsync(endpoints::kUserStars, std::move(done), userId);
+}
+
+Future<std::optional<UserStarsInfo>> IrisApi::checkUserStarsAsync(long userId) {
+    return makeFuture<std::optional<UserStarsInfo>>([&](auto done) {
+        checkUserStarsAsync(userId, std::move(done));
+    });
+}
+
+void IrisApi::checkUserPocketAsync(long userId, Callback<std::optional<UserPocketInfo>> done) {
+    callAsync(endpoints::kUserPocket, std::move(done), userId);
+}
+
+Future<std::optional<UserPocketInfo>> IrisApi::checkUserPocketAsync(long userId) {
+    return makeFuture<std::optional<UserPocketInfo>>([&](auto done) {
+        checkUserPocketAsync(userId, std::move(done));
+    });
+}
+
+void IrisApi::buyTradeAsync(double price, int volume,
+                            Callback<std::optional<BuyTradesResponse>> done) {
+    validatePrice(price);
+    callAsync(endpoints::kTradeBuy, std::move(done), price, volume);
+}
+
+Future<std::optional<BuyTradesResponse>> IrisApi::buyTradeAsync(double price, int volume) {
+    return makeFuture<std::optional<BuyTradesResponse>>([&](auto done) {
+        buyTradeAsync(price, volume, std::move(done));
+    });
+}
+
+void IrisApi::sellTradeAsync(double price, int volume,
+                             Callback<std::optional<SellTradesResponse>> done) {
+    validatePrice(price);
+    callAsync(endpoints::kTradeSell, std::move(done), price, volume);
+}
+
+Future<std::optional<SellTradesResponse>> IrisApi::sellTradeAsync(double price, int volume) {
+    return makeFuture<std::optional<SellTradesResponse>>([&](auto done) {
+        sellTradeAsync(price, volume, std::move(done));
+    });
+}
+
+void IrisApi::getOrdersTradeAsync(Callback<std::optional<OrdersResponse>> done) {
+    callAsync(endpoints::kTradeMyOrders, std::move(done));
+}
+
+Future<std::optional<OrdersResponse>> IrisApi::getOrdersTradeAsync() {
+    return makeFuture<std::optional<OrdersResponse>>([&](auto done) {
+        getOrdersTradeAsync(std::move(done));
+    });
+}
+
+void IrisApi::cancelPriceTradeAsync(double price,
+                                    Callback<std::optional<CancelTradesResponse>> done) {
+    validatePrice(price);
+    callAsync(endpoints::kTradeCancelPrice, std::move(done), price);
+}
+
+Future<std::optional<CancelTradesResponse>> IrisApi::cancelPriceTradeAsync(double price) {
+    return makeFuture<std::optional<CancelTradesResponse>>([&](auto done) {
+        cancelPriceTradeAsync(price, std::move(done));
+    });
+}
+
+void IrisApi::cancelAllTradeAsync(Callback<std::optional<CancelTradesResponse>> done) {
+    callAsync(endpoints::kTradeCancelAll, std::move(done));
+}
+
+Future<std::optional<CancelTradesResponse>> IrisApi::cancelAllTradeAsync() {
+    return makeFuture<std::optional<CancelTradesResponse>>([&](auto done) {
+        cancelAllTradeAsync(std::move(done));
+    });
+}
+
+void IrisApi::cancelPartTradeAsync(int id, int volume,
+                                   Callback<std::optional<CancelTradesResponse>> done) {
+    callAsync(endpoints::kTradeCancelPart, std::move(done), id, volume);
+}
+
+Future<std::optional<CancelTradesResponse>> IrisApi::cancelPartTradeAsync(int id, int volume) {
+    return makeFuture<std::optional<CancelTradesResponse>>([&](auto done) {
+        cancelPartTradeAsync(id, volume, std::move(done));
+    });
+}
+
+} // namespace iris
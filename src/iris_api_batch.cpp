@@ -0,0 +1,342 @@
+#include "iris/iris_api.hpp"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <stdexcept>
+
+namespace iris {
+
+namespace {
+
+// Items are started by whichever thread runs pump(); a completion that
+// arrives while a pump is running, synchronous ones included, only frees its
+// slot for that loop to reuse, so the stack never grows with the item count.
+struct WindowState {
+    std::function<void(size_t, std::function<void()>)> start;
+    size_t count = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t next = 0;
+    size_t remaining = 0;
+    size_t slots = 0;
+    bool pumping = false;
+};
+
+void onItemDone(const std::shared_ptr<WindowState>& state);
+
+void pump(const std::shared_ptr<WindowState>& state) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (state->pumping) {
+        return;
+    }
+    state->pumping = true;
+    while (state->slots > 0 && state->next < state->count) {
+        size_t index = state->next++;
+        --state->slots;
+        lock.unlock();
+        try {
+            state->start(index, [state] { onItemDone(state); });
+        } catch (const std::exception&) {
+            onItemDone(state);
+        }
+        lock.lock();
+    }
+    state->pumping = false;
+}
+
+void onItemDone(const std::shared_ptr<WindowState>& state) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        ++state->slots;
+        if (--state->remaining == 0) {
+            state->finished.notify_all();
+            return;
+        }
+    }
+    pump(state);
+}
+
+void validatePayouts(const std::vector<PayoutItem>& items,
+                     void (*validate)(int, const std::string&)) {
+    for (size_t i = 0; i < items.size(); ++i) {
+        try {
+            validate(items[i].count, items[i].comment);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Payout item " + std::to_string(i) + ": " + e.what());
+        }
+    }
+}
+
+void validateLadder(const std::vector<double>& prices, const std::vector<LadderLevel>& levels,
+                    void (*validate)(double)) {
+    for (size_t i = 0; i < prices.size(); ++i) {
+        try {
+            validate(prices[i]);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Cancel price " + std::to_string(i) + ": " + e.what());
+        }
+    }
+    for (size_t i = 0; i < levels.size(); ++i) {
+        try {
+            validate(levels[i].price);
+            if (levels[i].volume <= 0) {
+                throw std::invalid_argument("Volume must be positive");
+            }
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Ladder level " + std::to_string(i) + ": " + e.what());
+        }
+    }
+}
+
+// Prices travel with six decimals, so that is the precision they clash at.
+bool samePrice(double a, double b) {
+    return std::llround(a * 1e6) == std::llround(b * 1e6);
+}
+
+template <typename Order>
+std::optional<BookOrder> restingOrder(const std::optional<Order>& order, const LadderLevel& level) {
+    if (!order || !order->id || !order->volume || *order->volume <= 0) {
+        return std::nullopt;
+    }
+    return BookOrder{*order->id, level.side, order->price.value_or(level.price), *order->volume};
+}
+
+void placeLevel(IrisApi& api, const LadderLevel& level, LadderFill& fill,
+                const std::function<void()>& done) {
+    if (level.side == OrderSide::BUY) {
+        api.buyTradeAsync(level.price, level.volume,
+            [&fill, level, done](std::optional<BuyTradesResponse> response) {
+                if (response) {
+                    fill.success = true;
+                    fill.doneVolume = response->done_volume;
+                    fill.sweets = response->sweets_spent;
+                    fill.order = restingOrder(response->new_order, level);
+                }
+                done();
+            });
+    } else {
+        api.sellTradeAsync(level.price, level.volume,
+            [&fill, level, done](std::optional<SellTradesResponse> response) {
+                if (response) {
+                    fill.success = true;
+                    fill.doneVolume = response->done_volume;
+                    fill.sweets = response->sweets_earned;
+                    fill.order = restingOrder(response->new_order, level);
+                }
+                done();
+            });
+    }
+}
+
+LadderResult summarize(const std::vector<LadderLevel>& levels, std::vector<LadderFill> fills) {
+    LadderResult result;
+    for (size_t i = 0; i < fills.size(); ++i) {
+        const LadderFill& fill = fills[i];
+        if (!fill.success) {
+            ++result.failed;
+            continue;
+        }
+        if (levels[i].side == OrderSide::BUY) {
+            result.boughtVolume += fill.doneVolume;
+            result.sweetsSpent += fill.sweets;
+        } else {
+            result.soldVolume += fill.doneVolume;
+            result.sweetsEarned += fill.sweets;
+        }
+        if (fill.order) {
+            result.orders.push_back(*fill.order);
+        }
+    }
+    result.fills = std::move(fills);
+    return result;
+}
+
+CancelLadderResult merge(const std::vector<double>& prices,
+                         const std::vector<std::optional<CancelTradesResponse>>& responses) {
+    CancelLadderResult result;
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (!responses[i]) {
+            result.failedPrices.push_back(prices[i]);
+            continue;
+        }
+        const CancelTradesResponse& response = *responses[i];
+        result.cancelled.cancelled_orders.insert(result.cancelled.cancelled_orders.end(),
+                                                 response.cancelled_orders.begin(),
+                                                 response.cancelled_orders.end());
+        result.cancelled.cancelled_volume += response.cancelled_volume;
+    }
+    return result;
+}
+
+} // namespace
+
+void IrisApi::runWindowed(size_t count, size_t window, WindowedStart start) {
+    if (count == 0) {
+        return;
+    }
+
+    auto state = std::make_shared<WindowState>();
+    state->start = std::move(start);
+    state->count = count;
+    state->remaining = count;
+    state->slots = std::max<size_t>(window, 1);
+    pump(state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->remaining == 0; });
+}
+
+std::vector<PayoutResult> IrisApi::runPayoutBatch(
+    const std::vector<PayoutItem>& items, size_t concurrency,
+    const std::function<void(const PayoutItem&, Callback<Result<Response>>)>& give) {
+    std::vector<PayoutResult> results(items.size());
+
+    runWindowed(items.size(), concurrency, [&](size_t index, std::function<void()> done) {
+        give(items[index], [&results, index, done](Result<Response> response) {
+            PayoutResult& result = results[index];
+            if (response) {
+                result.response = std::move(*response);
+            } else {
+                if (response.error().apiError) {
+                    result.errorCode = response.error().apiError->code;
+                }
+                result.error = response.error();
+            }
+            done();
+        });
+    });
+
+    return results;
+}
+
+std::vector<PayoutResult> IrisApi::giveSweetsBatch(const std::vector<PayoutItem>& items,
+                                                   const BatchOptions& options) {
+    validatePayouts(items, &IrisApi::validateTransfer);
+    return runPayoutBatch(items, options.concurrency,
+        [&](const PayoutItem& item, Callback<Result<Response>> done) {
+            tryGiveSweetsAsync(item.count, item.userId, item.comment, options.withoutDonateScore,
+                               std::move(done));
+        });
+}
+
+std::vector<PayoutResult> IrisApi::giveGoldBatch(const std::vector<PayoutItem>& items,
+                                                 const BatchOptions& options) {
+    validatePayouts(items, &IrisApi::validateTransfer);
+    return runPayoutBatch(items, options.concurrency,
+        [&](const PayoutItem& item, Callback<Result<Response>> done) {
+            tryGiveGoldAsync(item.count, item.userId, item.comment, options.withoutDonateScore,
+                             std::move(done));
+        });
+}
+
+std::vector<PayoutResult> IrisApi::giveDonateScoreBatch(const std::vector<PayoutItem>& items,
+                                                        const BatchOptions& options) {
+    validatePayouts(items, &IrisApi::validateTransfer);
+    return runPayoutBatch(items, options.concurrency,
+        [&](const PayoutItem& item, Callback<Result<Response>> done) {
+            tryGiveDonateScoreAsync(item.count, item.userId, item.comment, std::move(done));
+        });
+}
+
+LadderResult IrisApi::placeLadder(const std::vector<LadderLevel>& levels, size_t concurrency) {
+    return replaceLadder({}, levels, concurrency).placed;
+}
+
+CancelLadderResult IrisApi::cancelLadder(const std::vector<double>& prices, size_t concurrency) {
+    return replaceLadder(prices, {}, concurrency).cancelled;
+}
+
+ReplaceLadderResult IrisApi::replaceLadder(const std::vector<double>& prices,
+                                           const std::vector<LadderLevel>& levels,
+                                           size_t concurrency) {
+    validateLadder(prices, levels, &IrisApi::validatePrice);
+
+    // Levels at a price being cancelled must not be cancelled with it.
+    std::vector<size_t> now;
+    std::vector<size_t> later;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        bool clashes = std::any_of(prices.begin(), prices.end(),
+                                   [&](double price) { return samePrice(price, levels[i].price); });
+        (clashes ? later : now).push_back(i);
+    }
+
+    std::vector<std::optional<CancelTradesResponse>> cancels(prices.size());
+    std::vector<LadderFill> fills(levels.size());
+
+    runWindowed(prices.size() + now.size(), concurrency,
+        [&](size_t index, std::function<void()> done) {
+            if (index < prices.size()) {
+                cancelPriceTradeAsync(prices[index],
+                    [&slot = cancels[index], done](std::optional<CancelTradesResponse> response) {
+                        slot = std::move(response);
+                        done();
+                    });
+            } else {
+                size_t level = now[index - prices.size()];
+                placeLevel(*this, levels[level], fills[level], done);
+            }
+        });
+    runWindowed(later.size(), concurrency, [&](size_t index, std::function<void()> done) {
+        size_t level = later[index];
+        placeLevel(*this, levels[level], fills[level], done);
+    });
+
+    ReplaceLadderResult result;
+    result.cancelled = merge(prices, cancels);
+    result.placed = summarize(levels, std::move(fills));
+    return result;
+}
+
+std::vector<UserInfoRow> IrisApi::checkUsers(const std::vector<long>& userIds,
+                                             UserInfoField fields, size_t concurrency) {
+    std::vector<UserInfoRow> rows(userIds.size());
+    for (size_t i = 0; i < userIds.size(); ++i) {
+        rows[i].userId = userIds[i];
+    }
+
+    std::vector<UserInfoField> kinds;
+    for (auto kind : {UserInfoField::REG, UserInfoField::SPAM, UserInfoField::ACTIVITY,
+                      UserInfoField::STARS, UserInfoField::POCKET}) {
+        if (hasField(fields, kind)) {
+            kinds.push_back(kind);
+        }
+    }
+    if (kinds.empty()) {
+        return rows;
+    }
+
+    // Each request writes its own field of its own row, so completions on
+    // whatever thread never touch the same memory and need no locking.
+    runWindowed(rows.size() * kinds.size(), concurrency,
+        [&](size_t index, std::function<void()> done) {
+            UserInfoRow& row = rows[index / kinds.size()];
+            auto store = [done](auto& slot) {
+                return [&slot, done](auto value) {
+                    slot = std::move(value);
+                    done();
+                };
+            };
+
+            switch (kinds[index % kinds.size()]) {
+                case UserInfoField::REG:
+                    checkUserRegAsync(row.userId, store(row.reg));
+                    break;
+                case UserInfoField::SPAM:
+                    checkUserSpamAsync(row.userId, store(row.spam));
+                    break;
+                case UserInfoField::ACTIVITY:
+                    checkUserActivityAsync(row.userId, store(row.activity));
+                    break;
+                case UserInfoField::STARS:
+                    checkUserStarsAsync(row.userId, store(row.stars));
+                    break;
+                default:
+                    checkUserPocketAsync(row.userId, store(row.pocket));
+                    break;
+            }
+        });
+
+    return rows;
+}
+
+} // namespace iris
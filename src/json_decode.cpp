@@ -0,0 +1,700 @@
+#include "iris/json_decode.hpp"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace iris {
+
+namespace {
+
+struct Frame;
+
+// How a JSON value is stored into a C++ slot of one particular type. Each
+// handler returns false when the JSON type does not fit the slot.
+struct ValueOps {
+    bool (*null)(void* slot);
+    bool (*boolean)(void* slot, bool value);
+    bool (*integer)(void* slot, std::int64_t value);
+    bool (*real)(void* slot, double value);
+    bool (*string)(void* slot, std::string& value);
+    bool (*object)(void* slot, Frame& frame);
+    bool (*array)(void* slot, Frame& frame);
+};
+
+struct FieldDesc {
+    const char* name;
+    void* (*slot)(void* object);
+    const ValueOps* ops;
+    bool required;
+};
+
+struct ObjectDesc {
+    const FieldDesc* fields;
+    size_t count;
+};
+
+struct Frame {
+    void* target = nullptr;
+    const ObjectDesc* object = nullptr;
+    const FieldDesc* field = nullptr;
+    void* (*append)(void* vector) = nullptr;
+    const ValueOps* element = nullptr;
+    std::uint64_t seen = 0;
+};
+
+bool rejectNull(void*) { return false; }
+bool rejectBool(void*, bool) { return false; }
+bool rejectInteger(void*, std::int64_t) { return false; }
+bool rejectReal(void*, double) { return false; }
+bool rejectString(void*, std::string&) { return false; }
+bool rejectContainer(void*, Frame&) { return false; }
+
+template <typename T>
+struct Model;
+
+template <typename T, typename = void>
+struct Ops {
+    static bool object(void* slot, Frame& frame) {
+        frame.target = slot;
+        frame.object = &Model<T>::desc;
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &rejectBool, &rejectInteger, &rejectReal, &rejectString,
+        &object, &rejectContainer
+    };
+};
+
+template <typename T>
+struct Ops<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+    static bool integer(void* slot, std::int64_t value) {
+        *static_cast<T*>(slot) = static_cast<T>(value);
+        return true;
+    }
+    static bool real(void* slot, double value) {
+        *static_cast<T*>(slot) = static_cast<T>(value);
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &rejectBool, &integer, &real, &rejectString,
+        &rejectContainer, &rejectContainer
+    };
+};
+
+template <>
+struct Ops<double> {
+    static bool integer(void* slot, std::int64_t value) {
+        *static_cast<double*>(slot) = static_cast<double>(value);
+        return true;
+    }
+    static bool real(void* slot, double value) {
+        *static_cast<double*>(slot) = value;
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &rejectBool, &integer, &real, &rejectString,
+        &rejectContainer, &rejectContainer
+    };
+};
+
+template <>
+struct Ops<bool> {
+    static bool boolean(void* slot, bool value) {
+        *static_cast<bool*>(slot) = value;
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &boolean, &rejectInteger, &rejectReal, &rejectString,
+        &rejectContainer, &rejectContainer
+    };
+};
+
+template <>
+struct Ops<std::string> {
+    static bool string(void* slot, std::string& value) {
+        // Copy rather than steal: the lexer keeps its buffer capacity.
+        static_cast<std::string*>(slot)->assign(value);
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &rejectBool, &rejectInteger, &rejectReal, &string,
+        &rejectContainer, &rejectContainer
+    };
+};
+
+template <typename T>
+struct Ops<std::optional<T>> {
+    static T* engage(void* slot) {
+        return &static_cast<std::optional<T>*>(slot)->emplace();
+    }
+
+    static bool null(void* slot) {
+        static_cast<std::optional<T>*>(slot)->reset();
+        return true;
+    }
+    static bool boolean(void* slot, bool value) { return Ops<T>::table.boolean(engage(slot), value); }
+    static bool integer(void* slot, std::int64_t value) { return Ops<T>::table.integer(engage(slot), value); }
+    static bool real(void* slot, double value) { return Ops<T>::table.real(engage(slot), value); }
+    static bool string(void* slot, std::string& value) { return Ops<T>::table.string(engage(slot), value); }
+    static bool object(void* slot, Frame& frame) { return Ops<T>::table.object(engage(slot), frame); }
+    static bool array(void* slot, Frame& frame) { return Ops<T>::table.array(engage(slot), frame); }
+
+    static constexpr ValueOps table{&null, &boolean, &integer, &real, &string, &object, &array};
+};
+
+template <typename T>
+struct Ops<std::vector<T>> {
+    static void* append(void* vector) {
+        return &static_cast<std::vector<T>*>(vector)->emplace_back();
+    }
+
+    static bool array(void* slot, Frame& frame) {
+        static_cast<std::vector<T>*>(slot)->clear();
+        frame.target = slot;
+        frame.append = &append;
+        frame.element = &Ops<T>::table;
+        return true;
+    }
+
+    static constexpr ValueOps table{
+        &rejectNull, &rejectBool, &rejectInteger, &rejectReal, &rejectString,
+        &rejectContainer, &array
+    };
+};
+
+template <typename T>
+struct IsOptional : std::false_type {};
+
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T, typename M, M T::*Member>
+void* memberSlot(void* object) {
+    return &(static_cast<T*>(object)->*Member);
+}
+
+#define IRIS_FIELD(Type, member)                                                    \
+    FieldDesc{#member,                                                              \
+              &memberSlot<Type, decltype(Type::member), &Type::member>,             \
+              &Ops<decltype(Type::member)>::table,                                  \
+              !IsOptional<decltype(Type::member)>::value}
+
+#define IRIS_MODEL(Type, ...)                                                       \
+    template <>                                                                     \
+    struct Model<Type> {                                                            \
+        static constexpr FieldDesc fields[] = {__VA_ARGS__};                        \
+        static constexpr ObjectDesc desc{fields, sizeof(fields) / sizeof(fields[0])}; \
+    };
+
+IRIS_MODEL(APIError,
+    IRIS_FIELD(APIError, code),
+    IRIS_FIELD(APIError, description))
+
+IRIS_MODEL(Response,
+    IRIS_FIELD(Response, result),
+    IRIS_FIELD(Response, error))
+
+IRIS_MODEL(BalanceData,
+    IRIS_FIELD(BalanceData, gold),
+    IRIS_FIELD(BalanceData, sweets),
+    IRIS_FIELD(BalanceData, donate_score))
+
+IRIS_MODEL(HistoryData,
+    IRIS_FIELD(HistoryData, user_id),
+    IRIS_FIELD(HistoryData, type),
+    IRIS_FIELD(HistoryData, amount),
+    IRIS_FIELD(HistoryData, comment),
+    IRIS_FIELD(HistoryData, timestamp))
+
+IRIS_MODEL(UpdatesLog,
+    IRIS_FIELD(UpdatesLog, update_id),
+    IRIS_FIELD(UpdatesLog, type),
+    IRIS_FIELD(UpdatesLog, user_id),
+    IRIS_FIELD(UpdatesLog, amount),
+    IRIS_FIELD(UpdatesLog, comment),
+    IRIS_FIELD(UpdatesLog, timestamp))
+
+IRIS_MODEL(UserRegInfo,
+    IRIS_FIELD(UserRegInfo, timestamp))
+
+IRIS_MODEL(UserSpamInfo,
+    IRIS_FIELD(UserSpamInfo, spam),
+    IRIS_FIELD(UserSpamInfo, ignore),
+    IRIS_FIELD(UserSpamInfo, scam))
+
+IRIS_MODEL(UserActivityInfo,
+    IRIS_FIELD(UserActivityInfo, messages),
+    IRIS_FIELD(UserActivityInfo, characters),
+    IRIS_FIELD(UserActivityInfo, forwarded),
+    IRIS_FIELD(UserActivityInfo, replies),
+    IRIS_FIELD(UserActivityInfo, mentions))
+
+IRIS_MODEL(UserStarsInfo,
+    IRIS_FIELD(UserStarsInfo, stars),
+    IRIS_FIELD(UserStarsInfo, rank))
+
+IRIS_MODEL(UserPocketInfo,
+    IRIS_FIELD(UserPocketInfo, gold),
+    IRIS_FIELD(UserPocketInfo, sweets),
+    IRIS_FIELD(UserPocketInfo, donate_score))
+
+IRIS_MODEL(OrderBuyTradesResponse,
+    IRIS_FIELD(OrderBuyTradesResponse, id),
+    IRIS_FIELD(OrderBuyTradesResponse, volume),
+    IRIS_FIELD(OrderBuyTradesResponse, price))
+
+IRIS_MODEL(BuyTradesResponse,
+    IRIS_FIELD(BuyTradesResponse, done_volume),
+    IRIS_FIELD(BuyTradesResponse, sweets_spent),
+    IRIS_FIELD(BuyTradesResponse, new_order))
+
+IRIS_MODEL(OrderSellTradesResponse,
+    IRIS_FIELD(OrderSellTradesResponse, id),
+    IRIS_FIELD(OrderSellTradesResponse, volume),
+    IRIS_FIELD(OrderSellTradesResponse, price))
+
+IRIS_MODEL(SellTradesResponse,
+    IRIS_FIELD(SellTradesResponse, done_volume),
+    IRIS_FIELD(SellTradesResponse, sweets_earned),
+    IRIS_FIELD(SellTradesResponse, new_order))
+
+IRIS_MODEL(OrdersResponse,
+    IRIS_FIELD(OrdersResponse, buy),
+    IRIS_FIELD(OrdersResponse, sell))
+
+IRIS_MODEL(CancelTradesResponse,
+    IRIS_FIELD(CancelTradesResponse, cancelled_orders),
+    IRIS_FIELD(CancelTradesResponse, cancelled_volume))
+
+#undef IRIS_MODEL
+#undef IRIS_FIELD
+
+class DecodeHandler {
+public:
+    using json = nlohmann::json;
+
+    DecodeHandler(void* root, const ValueOps* ops)
+        : root_(root)
+        , rootOps_(ops) {}
+
+    const std::string& error() const { return error_; }
+
+    bool null() {
+        return scalar([](const ValueOps* ops, void* slot) { return ops->null(slot); });
+    }
+    bool boolean(bool value) {
+        return scalar([value](const ValueOps* ops, void* slot) { return ops->boolean(slot, value); });
+    }
+    bool number_integer(json::number_integer_t value) {
+        return scalar([value](const ValueOps* ops, void* slot) {
+            return ops->integer(slot, static_cast<std::int64_t>(value));
+        });
+    }
+    bool number_unsigned(json::number_unsigned_t value) {
+        return scalar([value](const ValueOps* ops, void* slot) {
+            return ops->integer(slot, static_cast<std::int64_t>(value));
+        });
+    }
+    bool number_float(json::number_float_t value, const json::string_t&) {
+        return scalar([value](const ValueOps* ops, void* slot) { return ops->real(slot, value); });
+    }
+    bool string(json::string_t& value) {
+        return scalar([&value](const ValueOps* ops, void* slot) { return ops->string(slot, value); });
+    }
+    bool binary(json::binary_t&) {
+        return fail("unexpected binary value");
+    }
+
+    bool start_object(std::size_t) {
+        return open([](const ValueOps* ops, void* slot, Frame& frame) { return ops->object(slot, frame); });
+    }
+    bool key(json::string_t& name) {
+        if (skipDepth_ > 0) {
+            return true;
+        }
+        Frame& frame = stack_[depth_ - 1];
+        frame.field = nullptr;
+        for (size_t i = 0; i < frame.object->count; ++i) {
+            if (name == frame.object->fields[i].name) {
+                frame.field = &frame.object->fields[i];
+                frame.seen |= std::uint64_t{1} << i;
+                break;
+            }
+        }
+        if (!frame.field) {
+            skipNext_ = true;
+        }
+        return true;
+    }
+    bool end_object() {
+        if (skipDepth_ > 0) {
+            --skipDepth_;
+            return true;
+        }
+        const Frame& frame = stack_[--depth_];
+        for (size_t i = 0; i < frame.object->count; ++i) {
+            if (frame.object->fields[i].required && !(frame.seen & (std::uint64_t{1} << i))) {
+                return fail(std::string("missing field '") + frame.object->fields[i].name + "'");
+            }
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        return open([](const ValueOps* ops, void* slot, Frame& frame) { return ops->array(slot, frame); });
+    }
+    bool end_array() {
+        if (skipDepth_ > 0) {
+            --skipDepth_;
+            return true;
+        }
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        return fail(e.what());
+    }
+
+private:
+    static constexpr size_t kMaxDepth = 16;
+
+    // Resolves the slot the next value is written to. Returns false when the
+    // value belongs to an unknown key and must be skipped.
+    bool destination(void*& slot, const ValueOps*& ops) {
+        if (depth_ == 0) {
+            slot = root_;
+            ops = rootOps_;
+            return true;
+        }
+        Frame& frame = stack_[depth_ - 1];
+        if (frame.object) {
+            if (skipNext_) {
+                skipNext_ = false;
+                return false;
+            }
+            slot = frame.field->slot(frame.target);
+            ops = frame.field->ops;
+            return true;
+        }
+        slot = frame.append(frame.target);
+        ops = frame.element;
+        return true;
+    }
+
+    template <typename Apply>
+    bool scalar(Apply apply) {
+        if (skipDepth_ > 0) {
+            return true;
+        }
+        void* slot = nullptr;
+        const ValueOps* ops = nullptr;
+        if (!destination(slot, ops)) {
+            return true;
+        }
+        return apply(ops, slot) || fail("unexpected value type");
+    }
+
+    template <typename Apply>
+    bool open(Apply apply) {
+        if (skipDepth_ > 0) {
+            ++skipDepth_;
+            return true;
+        }
+        void* slot = nullptr;
+        const ValueOps* ops = nullptr;
+        if (!destination(slot, ops)) {
+            skipDepth_ = 1;
+            return true;
+        }
+        if (depth_ == kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        Frame& frame = stack_[depth_];
+        frame = Frame{};
+        if (!apply(ops, slot, frame)) {
+            return fail("unexpected value type");
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool fail(std::string message) {
+        if (error_.empty()) {
+            error_ = std::move(message);
+        }
+        return false;
+    }
+
+    void* root_;
+    const ValueOps* rootOps_;
+    std::array<Frame, kMaxDepth> stack_;
+    size_t depth_ = 0;
+    size_t skipDepth_ = 0;
+    bool skipNext_ = false;
+    std::string error_;
+};
+
+template <typename T>
+void resetValue(T& value) {
+    value = T{};
+}
+
+// Vectors keep their capacity, so decoding page after page into the same
+// one (as ArrayStreamDecoder does per chunk) stops allocating once warm.
+template <typename T>
+void resetValue(std::vector<T>& value) {
+    value.clear();
+}
+
+} // namespace
+
+template <typename T>
+bool tryDecodeJson(std::string_view body, T& out, std::string& error) {
+    resetValue(out);
+    DecodeHandler handler(&out, &Ops<T>::table);
+    if (!nlohmann::json::sax_parse(body.begin(), body.end(), &handler)) {
+        error = handler.error();
+        return false;
+    }
+    return true;
+}
+
+bool tryDecodeGiveResponse(std::string_view body, std::optional<Response>& out, std::string& error) {
+    auto json = nlohmann::json::parse(body.begin(), body.end(), nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        error = "expected an object";
+        return false;
+    }
+    Response result{0, std::nullopt};
+
+    auto apiError = json.find("error");
+    if (apiError != json.end()) {
+        APIError value{0, "Unknown error"};
+        if (apiError->is_object()) {
+            auto code = apiError->find("code");
+            if (code != apiError->end() && code->is_number_integer()) {
+                value.code = code->get<int>();
+            }
+            auto description = apiError->find("description");
+            if (description != apiError->end() && description->is_string()) {
+                value.description = description->get<std::string>();
+            }
+        }
+        result.error = std::move(value);
+    } else {
+        auto value = json.find("result");
+        if (value != json.end() && value->is_number()) {
+            result.result = value->get<int>();
+        }
+    }
+
+    out = std::move(result);
+    return true;
+}
+
+namespace {
+
+// Characters the element scanner has to look at.
+constexpr std::array<bool, 256> makeScanTable() {
+    std::array<bool, 256> table{};
+    for (unsigned char c : {'"', '\\', '{', '}', '[', ']'}) {
+        table[c] = true;
+    }
+    return table;
+}
+
+constexpr std::array<bool, 256> kScanChars = makeScanTable();
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+} // namespace
+
+template <typename T>
+bool ArrayStreamDecoder<T>::feed(std::string_view chunk) {
+    bool scanned = scan(chunk);
+    bool flushed = flush();
+    return scanned && flushed;
+}
+
+template <typename T>
+bool ArrayStreamDecoder<T>::scan(std::string_view chunk) {
+    // Start of the current element in `chunk`, when it began in this chunk.
+    size_t start = 0;
+    size_t i = 0;
+    while (i < chunk.size()) {
+        char c = chunk[i];
+        switch (state_) {
+            case State::START:
+                if (c == '[') {
+                    state_ = State::FIRST;
+                } else if (!isJsonSpace(c)) {
+                    state_ = State::REJECTED;
+                    continue;
+                }
+                break;
+            case State::FIRST:
+            case State::NEXT:
+                if (c == '{') {
+                    state_ = State::ELEMENT;
+                    start = i;
+                    continue;
+                }
+                if (c == ']' && state_ == State::FIRST) {
+                    state_ = State::DONE;
+                } else if (!isJsonSpace(c)) {
+                    return fail("expected an object in the array");
+                }
+                break;
+            case State::AFTER:
+                if (c == ',') {
+                    state_ = State::NEXT;
+                } else if (c == ']') {
+                    state_ = State::DONE;
+                } else if (!isJsonSpace(c)) {
+                    return fail("expected ',' or ']' after an element");
+                }
+                break;
+            case State::ELEMENT: {
+                // Only strings and brackets matter for finding the end; the
+                // decoder checks the rest.
+                for (; i < chunk.size(); ++i) {
+                    c = chunk[i];
+                    if (!escaped_ && !kScanChars[static_cast<unsigned char>(c)]) {
+                        continue;
+                    }
+                    if (inString_) {
+                        if (escaped_) {
+                            escaped_ = false;
+                        } else if (c == '\\') {
+                            escaped_ = true;
+                        } else if (c == '"') {
+                            inString_ = false;
+                        }
+                    } else if (c == '"') {
+                        inString_ = true;
+                    } else if (c == '{' || c == '[') {
+                        ++depth_;
+                    } else if ((c == '}' || c == ']') && --depth_ == 0) {
+                        break;
+                    }
+                }
+                if (i == chunk.size()) {
+                    partial_.append(chunk.substr(start));
+                    return true;
+                }
+                batch_.push_back(batch_.empty() ? '[' : ',');
+                if (!partial_.empty()) {
+                    batch_.append(partial_);
+                    partial_.clear();
+                }
+                batch_.append(chunk.substr(start, i + 1 - start));
+                start = 0;
+                state_ = State::AFTER;
+                break;
+            }
+            case State::DONE:
+                if (!isJsonSpace(c)) {
+                    return fail("unexpected data after the array");
+                }
+                break;
+            case State::REJECTED:
+                rejected_.append(chunk.substr(i));
+                return true;
+            case State::FAILED:
+                return false;
+        }
+        ++i;
+    }
+    return state_ != State::FAILED;
+}
+
+template <typename T>
+bool ArrayStreamDecoder<T>::finish() {
+    switch (state_) {
+        case State::DONE:
+            return true;
+        case State::FAILED:
+            return false;
+        case State::REJECTED:
+            return fail("expected an array");
+        case State::START:
+            return fail("empty body");
+        default:
+            return fail("truncated array");
+    }
+}
+
+template <typename T>
+bool ArrayStreamDecoder<T>::flush() {
+    if (batch_.empty()) {
+        return true;
+    }
+    batch_.push_back(']');
+    std::string error;
+    auto started = std::chrono::steady_clock::now();
+    bool decoded = tryDecodeJson(batch_, records_, error);
+    decodeTime_ += std::chrono::steady_clock::now() - started;
+    batch_.clear();
+    if (!decoded) {
+        return fail("element " + std::to_string(count_) + " or after: " + error);
+    }
+    for (T& record : records_) {
+        try {
+            sink_(std::move(record));
+        } catch (...) {
+            exception_ = std::current_exception();
+            return fail("record handler threw");
+        }
+        ++count_;
+    }
+    return true;
+}
+
+template <typename T>
+bool ArrayStreamDecoder<T>::fail(std::string error) {
+    // The first failure is the one worth reporting.
+    if (state_ != State::FAILED) {
+        state_ = State::FAILED;
+        error_ = std::move(error);
+    }
+    return false;
+}
+
+template class ArrayStreamDecoder<HistoryData>;
+template class ArrayStreamDecoder<UpdatesLog>;
+
+#define IRIS_INSTANTIATE(Type)                                                                   \
+    template bool tryDecodeJson<Type>(std::string_view, Type&, std::string&);                    \
+    template bool tryDecodeJson<std::optional<Type>>(std::string_view, std::optional<Type>&, std::string&);
+
+IRIS_INSTANTIATE(APIError)
+IRIS_INSTANTIATE(Response)
+IRIS_INSTANTIATE(BalanceData)
+IRIS_INSTANTIATE(HistoryData)
+IRIS_INSTANTIATE(UpdatesLog)
+IRIS_INSTANTIATE(UserRegInfo)
+IRIS_INSTANTIATE(UserSpamInfo)
+IRIS_INSTANTIATE(UserActivityInfo)
+IRIS_INSTANTIATE(UserStarsInfo)
+IRIS_INSTANTIATE(UserPocketInfo)
+IRIS_INSTANTIATE(OrderBuyTradesResponse)
+IRIS_INSTANTIATE(BuyTradesResponse)
+IRIS_INSTANTIATE(OrderSellTradesResponse)
+IRIS_INSTANTIATE(SellTradesResponse)
+IRIS_INSTANTIATE(OrdersResponse)
+IRIS_INSTANTIATE(CancelTradesResponse)
+IRIS_INSTANTIATE(std::vector<HistoryData>)
+IRIS_INSTANTIATE(std::vector<UpdatesLog>)
+IRIS_INSTANTIATE(std::vector<long>)
+
+#undef IRIS_INSTANTIATE
+
+} // namespace iris
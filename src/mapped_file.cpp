@@ -0,0 +1,175 @@
+#include "iris/mapped_file.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace iris {
+
+namespace {
+
+[[noreturn]] void fail(const char* what, const std::string& path) {
+    throw std::runtime_error(std::string(what) + ": " + path);
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : path_(path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        fail("Failed to open file", path);
+    }
+    file_ = file;
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        CloseHandle(file);
+        fail("Failed to stat file", path);
+    }
+    size_ = static_cast<size_t>(length.QuadPart);
+    map();
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+    if (file_) {
+        CloseHandle(static_cast<HANDLE>(file_));
+    }
+}
+
+void MappedFile::map() {
+    if (size_ == 0) {
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(static_cast<HANDLE>(file_), nullptr, PAGE_READWRITE,
+                                        0, 0, nullptr);
+    if (!mapping) {
+        fail("Failed to map file", path_);
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size_);
+    if (!view) {
+        CloseHandle(mapping);
+        fail("Failed to map file", path_);
+    }
+    mapping_ = mapping;
+    data_ = static_cast<char*>(view);
+}
+
+void MappedFile::unmap() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+        mapping_ = nullptr;
+    }
+}
+
+void MappedFile::resize(size_t bytes) {
+    unmap();
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(bytes);
+    if (!SetFilePointerEx(static_cast<HANDLE>(file_), length, nullptr, FILE_BEGIN)
+        || !SetEndOfFile(static_cast<HANDLE>(file_))) {
+        fail("Failed to resize file", path_);
+    }
+    size_ = bytes;
+    map();
+}
+
+void MappedFile::flush() {
+    if (data_) {
+        FlushViewOfFile(data_, size_);
+        FlushFileBuffers(static_cast<HANDLE>(file_));
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : path_(path) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        fail("Failed to open file", path);
+    }
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        ::close(fd_);
+        fail("Failed to stat file", path);
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    map();
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void MappedFile::map() {
+    if (size_ == 0) {
+        return;
+    }
+    void* view = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED) {
+        fail("Failed to map file", path_);
+    }
+    data_ = static_cast<char*>(view);
+}
+
+void MappedFile::unmap() {
+    if (data_) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+}
+
+void MappedFile::resize(size_t bytes) {
+    unmap();
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        fail("Failed to resize file", path_);
+    }
+    size_ = bytes;
+    map();
+}
+
+void MappedFile::flush() {
+    if (data_) {
+        msync(data_, size_, MS_SYNC);
+    }
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : path_(std::move(other.path_))
+    , data_(other.data_)
+    , size_(other.size_)
+#ifdef _WIN32
+    , file_(other.file_)
+    , mapping_(other.mapping_) {
+    other.file_ = nullptr;
+    other.mapping_ = nullptr;
+#else
+    , fd_(other.fd_) {
+    other.fd_ = -1;
+#endif
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+} // namespace iris
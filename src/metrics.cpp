@@ -0,0 +1,312 @@
+#include "iris/metrics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace iris {
+
+namespace {
+
+constexpr std::array<std::string_view, kErrorClassCount> kErrorClassNames = {{
+    "none", "timeout", "transport", "throttled", "http_4xx", "http_5xx", "decode",
+}};
+
+constexpr std::array<std::string_view, kTransferPhaseCount> kTransferPhaseNames = {{
+    "namelookup", "connect", "appconnect", "starttransfer",
+}};
+
+// Prometheus bucket bounds in seconds. The histogram is finer than this;
+// a bucket is counted under the first bound not below its high edge, so a
+// bound never holds samples above it.
+struct Bound {
+    uint64_t micros;
+    std::string_view label;
+};
+
+constexpr Bound kPrometheusBounds[] = {
+    {500, "0.0005"}, {1000, "0.001"}, {2500, "0.0025"}, {5000, "0.005"}, {10000, "0.01"},
+    {25000, "0.025"}, {50000, "0.05"}, {100000, "0.1"}, {250000, "0.25"}, {500000, "0.5"},
+    {1000000, "1"}, {2500000, "2.5"}, {5000000, "5"}, {10000000, "10"}, {30000000, "30"},
+};
+
+int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+uint64_t toMicros(Metrics::Clock::duration duration) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return micros > 0 ? static_cast<uint64_t>(micros) : 0;
+}
+
+template <typename T>
+void appendNumber(std::string& out, T value) {
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+void appendLabels(std::string& out, std::string_view endpoint, std::string_view name = {},
+                  std::string_view value = {}) {
+    out.append("{endpoint=\"").append(endpoint).append("\"");
+    if (!name.empty()) {
+        out.append(",").append(name).append("=\"").append(value).append("\"");
+    }
+}
+
+void appendHeader(std::string& out, std::string_view metric, std::string_view type, std::string_view help) {
+    out.append("# HELP ").append(metric).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(metric).append(" ").append(type).append("\n");
+}
+
+void appendCounter(std::string& out, std::string_view metric, std::string_view endpoint, uint64_t value,
+                   std::string_view name = {}, std::string_view label = {}) {
+    out.append(metric);
+    appendLabels(out, endpoint, name, label);
+    out.append("} ");
+    appendNumber(out, value);
+    out.append("\n");
+}
+
+void appendHistogram(std::string& out, std::string_view metric, std::string_view endpoint,
+                     const HistogramSnapshot& histogram, std::string_view name = {},
+                     std::string_view label = {}) {
+    uint64_t cumulative = 0;
+    size_t bucket = 0;
+    for (const Bound& bound : kPrometheusBounds) {
+        for (; bucket < histogram.buckets.size() && LatencyHistogram::bucketHigh(bucket) <= bound.micros; ++bucket) {
+            cumulative += histogram.buckets[bucket];
+        }
+        out.append(metric).append("_bucket");
+        appendLabels(out, endpoint, name, label);
+        out.append(",le=\"").append(bound.label).append("\"} ");
+        appendNumber(out, cumulative);
+        out.append("\n");
+    }
+    out.append(metric).append("_bucket");
+    appendLabels(out, endpoint, name, label);
+    out.append(",le=\"+Inf\"} ");
+    appendNumber(out, histogram.count);
+    out.append("\n");
+
+    out.append(metric).append("_sum");
+    appendLabels(out, endpoint, name, label);
+    out.append("} ");
+    appendNumber(out, static_cast<double>(histogram.sum) / 1e6);
+    out.append("\n");
+
+    out.append(metric).append("_count");
+    appendLabels(out, endpoint, name, label);
+    out.append("} ");
+    appendNumber(out, histogram.count);
+    out.append("\n");
+}
+
+} // namespace
+
+ErrorClass classifyError(const HttpResponse& response) {
+    switch (response.curlCode) {
+    case CURLE_OK:
+        break;
+    case CURLE_OPERATION_TIMEDOUT:
+        return ErrorClass::TIMEOUT;
+    case CURLE_WRITE_ERROR:
+        // Only a body sink aborts a write: the streamed records did not
+        // decode (or their handler threw).
+        return ErrorClass::DECODE;
+    default:
+        return ErrorClass::TRANSPORT;
+    }
+    if (response.httpCode == 429) {
+        return ErrorClass::THROTTLED;
+    }
+    if (response.httpCode >= 500) {
+        return ErrorClass::HTTP_5XX;
+    }
+    if (response.httpCode >= 400) {
+        return ErrorClass::HTTP_4XX;
+    }
+    return ErrorClass::NONE;
+}
+
+std::string_view errorClassName(ErrorClass error) {
+    return kErrorClassNames[static_cast<size_t>(error)];
+}
+
+std::string_view transferPhaseName(TransferPhase phase) {
+    return kTransferPhaseNames[static_cast<size_t>(phase)];
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto target = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(count)));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min(LatencyHistogram::bucketHigh(i), max);
+        }
+    }
+    return max;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t micros) {
+    micros = std::min(micros, kMaxValue);
+    if (micros < 2 * kSubBuckets) {
+        return static_cast<size_t>(micros);
+    }
+    // Keep the top five bits: the leading one plus a 4-bit sub-bucket.
+    int shift = highestBit(micros) - 4;
+    return static_cast<size_t>(shift) * kSubBuckets + static_cast<size_t>(micros >> shift);
+}
+
+uint64_t LatencyHistogram::bucketLow(size_t index) {
+    if (index < 2 * kSubBuckets) {
+        return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    uint64_t mantissa = index % kSubBuckets + kSubBuckets;
+    return mantissa << shift;
+}
+
+uint64_t LatencyHistogram::bucketHigh(size_t index) {
+    if (index < 2 * kSubBuckets) {
+        return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    uint64_t mantissa = index % kSubBuckets + kSubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    buckets_[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(micros, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (micros > max && !max_.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.buckets.resize(kBucketCount);
+    // Recorders may be mid-update; derive count from the buckets so that
+    // percentiles stay consistent.
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    snapshot.max = max_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void Metrics::recordRequest(EndpointId id, const HttpResponse& response, Clock::duration latency) {
+    Endpoint& endpoint = endpoints_[static_cast<size_t>(id)];
+    endpoint.requests.fetch_add(1, std::memory_order_relaxed);
+    endpoint.outcomes[static_cast<size_t>(classifyError(response))].fetch_add(1, std::memory_order_relaxed);
+    endpoint.latency.record(toMicros(latency));
+
+    const HttpTimings& timings = response.timings;
+    if (timings.bytes > 0) {
+        endpoint.bytesReceived.fetch_add(static_cast<uint64_t>(timings.bytes), std::memory_order_relaxed);
+    }
+    const int64_t phases[kTransferPhaseCount] = {
+        timings.namelookup, timings.connect, timings.appconnect, timings.starttransfer,
+    };
+    for (size_t i = 0; i < kTransferPhaseCount; ++i) {
+        if (phases[i] > 0) {
+            endpoint.phases[i].record(static_cast<uint64_t>(phases[i]));
+        }
+    }
+}
+
+void Metrics::recordDecode(EndpointId id, Clock::duration elapsed, bool ok) {
+    Endpoint& endpoint = endpoints_[static_cast<size_t>(id)];
+    endpoint.decode.record(toMicros(elapsed));
+    if (!ok) {
+        // The transfer itself was counted as a success; move it over.
+        endpoint.outcomes[static_cast<size_t>(ErrorClass::NONE)].fetch_sub(1, std::memory_order_relaxed);
+        endpoint.outcomes[static_cast<size_t>(ErrorClass::DECODE)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+EndpointMetricsSnapshot Metrics::snapshot(EndpointId id) const {
+    const Endpoint& endpoint = endpoints_[static_cast<size_t>(id)];
+    EndpointMetricsSnapshot snapshot;
+    snapshot.id = id;
+    snapshot.path = kEndpointRoutes[static_cast<size_t>(id)].path;
+    snapshot.requests = endpoint.requests.load(std::memory_order_relaxed);
+    snapshot.bytesReceived = endpoint.bytesReceived.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kErrorClassCount; ++i) {
+        snapshot.outcomes[i] = endpoint.outcomes[i].load(std::memory_order_relaxed);
+    }
+    snapshot.latency = endpoint.latency.snapshot();
+    for (size_t i = 0; i < kTransferPhaseCount; ++i) {
+        snapshot.phases[i] = endpoint.phases[i].snapshot();
+    }
+    snapshot.decode = endpoint.decode.snapshot();
+    return snapshot;
+}
+
+std::vector<EndpointMetricsSnapshot> Metrics::snapshot() const {
+    std::vector<EndpointMetricsSnapshot> result;
+    for (const EndpointRoute& route : kEndpointRoutes) {
+        if (endpoints_[static_cast<size_t>(route.id)].requests.load(std::memory_order_relaxed) > 0) {
+            result.push_back(snapshot(route.id));
+        }
+    }
+    return result;
+}
+
+std::string Metrics::prometheus() const {
+    std::vector<EndpointMetricsSnapshot> endpoints = snapshot();
+    std::string out;
+
+    appendHeader(out, "iris_requests_total", "counter", "Finished requests by outcome.");
+    for (const EndpointMetricsSnapshot& endpoint : endpoints) {
+        for (size_t i = 0; i < kErrorClassCount; ++i) {
+            appendCounter(out, "iris_requests_total", endpoint.path, endpoint.outcomes[i], "outcome",
+                          kErrorClassNames[i]);
+        }
+    }
+
+    appendHeader(out, "iris_response_bytes_total", "counter", "Response body bytes received.");
+    for (const EndpointMetricsSnapshot& endpoint : endpoints) {
+        appendCounter(out, "iris_response_bytes_total", endpoint.path, endpoint.bytesReceived);
+    }
+
+    appendHeader(out, "iris_request_duration_seconds", "histogram",
+                 "Request latency as seen by the caller, retries included.");
+    for (const EndpointMetricsSnapshot& endpoint : endpoints) {
+        appendHistogram(out, "iris_request_duration_seconds", endpoint.path, endpoint.latency);
+    }
+
+    appendHeader(out, "iris_transfer_phase_seconds", "histogram",
+                 "Time from transfer start to the end of each curl phase.");
+    for (const EndpointMetricsSnapshot& endpoint : endpoints) {
+        for (size_t i = 0; i < kTransferPhaseCount; ++i) {
+            appendHistogram(out, "iris_transfer_phase_seconds", endpoint.path, endpoint.phases[i], "phase",
+                            kTransferPhaseNames[i]);
+        }
+    }
+
+    appendHeader(out, "iris_decode_duration_seconds", "histogram", "JSON decode time.");
+    for (const EndpointMetricsSnapshot& endpoint : endpoints) {
+        appendHistogram(out, "iris_decode_duration_seconds", endpoint.path, endpoint.decode);
+    }
+    return out;
+}
+
+} // namespace iris
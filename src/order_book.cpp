@@ -0,0 +1,323 @@
+#include "iris/order_book.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace iris {
+
+namespace {
+
+size_t sideIndex(OrderSide side) {
+    return side == OrderSide::BUY ? 0 : 1;
+}
+
+// Only orders with all three fields set can be mirrored.
+template <typename Order>
+std::optional<BookOrder> toBookOrder(const Order& order, OrderSide side, double fallbackPrice) {
+    if (!order.id || !order.volume || *order.volume <= 0) {
+        return std::nullopt;
+    }
+    return BookOrder{*order.id, side, order.price.value_or(fallbackPrice), *order.volume};
+}
+
+template <typename Order>
+void collect(const std::vector<Order>& orders, OrderSide side, std::vector<BookOrder>& out) {
+    for (const Order& order : orders) {
+        if (order.price) {
+            if (auto book = toBookOrder(order, side, *order.price)) {
+                out.push_back(*book);
+            }
+        }
+    }
+}
+
+} // namespace
+
+OrderBook::OrderBook(IrisApi& api, const OrderBookOptions& options)
+    : api_(api)
+    , options_(options) {
+}
+
+std::optional<BuyTradesResponse> OrderBook::buy(double price, int volume) {
+    auto response = api_.buyTrade(price, volume);
+    if (response) {
+        applyBuy(*response, price);
+    }
+    return response;
+}
+
+std::optional<SellTradesResponse> OrderBook::sell(double price, int volume) {
+    auto response = api_.sellTrade(price, volume);
+    if (response) {
+        applySell(*response, price);
+    }
+    return response;
+}
+
+std::optional<CancelTradesResponse> OrderBook::cancelPrice(double price) {
+    auto response = api_.cancelPriceTrade(price);
+    if (response) {
+        applyCancel(*response);
+    }
+    return response;
+}
+
+std::optional<CancelTradesResponse> OrderBook::cancelAll() {
+    auto response = api_.cancelAllTrade();
+    if (response) {
+        applyCancel(*response);
+    }
+    return response;
+}
+
+std::optional<CancelTradesResponse> OrderBook::cancelPart(int id, int volume) {
+    auto response = api_.cancelPartTrade(id, volume);
+    if (response) {
+        applyCancelPart(id, *response);
+    }
+    return response;
+}
+
+LadderResult OrderBook::placeLadder(const std::vector<LadderLevel>& levels, size_t concurrency) {
+    LadderResult result = api_.placeLadder(levels, concurrency);
+    applyLadder(result);
+    return result;
+}
+
+CancelLadderResult OrderBook::cancelLadder(const std::vector<double>& prices, size_t concurrency) {
+    CancelLadderResult result = api_.cancelLadder(prices, concurrency);
+    applyCancel(result.cancelled);
+    return result;
+}
+
+ReplaceLadderResult OrderBook::replaceLadder(const std::vector<double>& prices,
+                                             const std::vector<LadderLevel>& levels,
+                                             size_t concurrency) {
+    ReplaceLadderResult result = api_.replaceLadder(prices, levels, concurrency);
+    applyCancel(result.cancelled.cancelled);
+    applyLadder(result.placed);
+    return result;
+}
+
+ReplaceLadderResult OrderBook::reprice(const std::vector<LadderLevel>& levels, size_t concurrency) {
+    std::vector<double> prices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Levels* side : {&bids_, &asks_}) {
+            for (const auto& entry : *side) {
+                prices.push_back(entry.first);
+            }
+        }
+    }
+    // cancelPriceTrade clears both sides of a price.
+    std::sort(prices.begin(), prices.end());
+    prices.erase(std::unique(prices.begin(), prices.end()), prices.end());
+    return replaceLadder(prices, levels, concurrency);
+}
+
+std::optional<OrderBookDrift> OrderBook::reconcile() {
+    auto orders = api_.getOrdersTrade();
+    if (!orders) {
+        return std::nullopt;
+    }
+    return applyOrders(*orders);
+}
+
+std::optional<OrderBookDrift> OrderBook::reconcileIfStale() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reconciled_ && Clock::now() - *reconciled_ < options_.reconcileInterval) {
+            return OrderBookDrift{};
+        }
+    }
+    return reconcile();
+}
+
+void OrderBook::applyBuy(const BuyTradesResponse& response, double price) {
+    if (!response.new_order) {
+        return;
+    }
+    if (auto order = toBookOrder(*response.new_order, OrderSide::BUY, price)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert(*order);
+    }
+}
+
+void OrderBook::applySell(const SellTradesResponse& response, double price) {
+    if (!response.new_order) {
+        return;
+    }
+    if (auto order = toBookOrder(*response.new_order, OrderSide::SELL, price)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert(*order);
+    }
+}
+
+void OrderBook::applyCancel(const CancelTradesResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int id : response.cancelled_orders) {
+        erase(id);
+    }
+}
+
+void OrderBook::applyCancelPart(int id, const CancelTradesResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool listed = std::find(response.cancelled_orders.begin(), response.cancelled_orders.end(), id)
+        != response.cancelled_orders.end();
+    auto it = byId_.find(id);
+    if (it == byId_.end()) {
+        return;
+    }
+    int remaining = it->second.volume - response.cancelled_volume;
+    if (listed || remaining <= 0) {
+        erase(id);
+    } else {
+        resize(id, remaining);
+    }
+}
+
+void OrderBook::applyLadder(const LadderResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const BookOrder& order : result.orders) {
+        insert(order);
+    }
+}
+
+OrderBookDrift OrderBook::applyOrders(const OrdersResponse& orders) {
+    std::vector<BookOrder> fresh;
+    fresh.reserve(orders.buy.size() + orders.sell.size());
+    collect(orders.buy, OrderSide::BUY, fresh);
+    collect(orders.sell, OrderSide::SELL, fresh);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    OrderBookDrift drift;
+    std::unordered_set<int> seen;
+    seen.reserve(fresh.size());
+    for (const BookOrder& order : fresh) {
+        seen.insert(order.id);
+        auto it = byId_.find(order.id);
+        if (it == byId_.end()) {
+            ++drift.unknown;
+        } else if (it->second.side != order.side || it->second.price != order.price
+                   || it->second.volume != order.volume) {
+            ++drift.changed;
+        }
+    }
+    for (const auto& entry : byId_) {
+        if (!seen.count(entry.first)) {
+            ++drift.missing;
+        }
+    }
+
+    byId_.clear();
+    bids_.clear();
+    asks_.clear();
+    totals_[0] = totals_[1] = 0;
+    for (const BookOrder& order : fresh) {
+        insert(order);
+    }
+    reconciled_ = Clock::now();
+    return drift;
+}
+
+void OrderBook::insert(const BookOrder& order) {
+    erase(order.id);
+    byId_.emplace(order.id, order);
+    Level& level = levelsFor(order.side)[order.price];
+    level.volume += order.volume;
+    ++level.orders;
+    totals_[sideIndex(order.side)] += order.volume;
+}
+
+void OrderBook::erase(int id) {
+    auto it = byId_.find(id);
+    if (it == byId_.end()) {
+        return;
+    }
+    const BookOrder& order = it->second;
+    Levels& levels = levelsFor(order.side);
+    auto level = levels.find(order.price);
+    if (level != levels.end()) {
+        level->second.volume -= order.volume;
+        if (--level->second.orders == 0) {
+            levels.erase(level);
+        }
+    }
+    totals_[sideIndex(order.side)] -= order.volume;
+    byId_.erase(it);
+}
+
+void OrderBook::resize(int id, int volume) {
+    BookOrder& order = byId_.at(id);
+    int delta = volume - order.volume;
+    levelsFor(order.side)[order.price].volume += delta;
+    totals_[sideIndex(order.side)] += delta;
+    order.volume = volume;
+}
+
+std::optional<BookOrder> OrderBook::order(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = byId_.find(id);
+    if (it == byId_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+int OrderBook::volumeAt(OrderSide side, double price) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Levels& levels = levelsFor(side);
+    auto it = levels.find(price);
+    return it == levels.end() ? 0 : it->second.volume;
+}
+
+std::optional<double> OrderBook::bestPrice(OrderSide side) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Levels& levels = levelsFor(side);
+    if (levels.empty()) {
+        return std::nullopt;
+    }
+    return side == OrderSide::BUY ? levels.rbegin()->first : levels.begin()->first;
+}
+
+int OrderBook::totalVolume(OrderSide side) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totals_[sideIndex(side)];
+}
+
+std::vector<PriceLevel> OrderBook::levels(OrderSide side) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Levels& levels = levelsFor(side);
+    std::vector<PriceLevel> result;
+    result.reserve(levels.size());
+    for (const auto& entry : levels) {
+        result.push_back({entry.first, entry.second.volume, entry.second.orders});
+    }
+    if (side == OrderSide::BUY) {
+        std::reverse(result.begin(), result.end());
+    }
+    return result;
+}
+
+std::vector<BookOrder> OrderBook::orders(OrderSide side) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<BookOrder> result;
+    for (const auto& entry : byId_) {
+        if (entry.second.side == side) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(), [side](const BookOrder& a, const BookOrder& b) {
+        if (a.price != b.price) {
+            return side == OrderSide::BUY ? a.price > b.price : a.price < b.price;
+        }
+        return a.id < b.id;
+    });
+    return result;
+}
+
+size_t OrderBook::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return byId_.size();
+}
+
+} // namespace iris
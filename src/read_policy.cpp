@@ -0,0 +1,111 @@
+#include "iris/read_policy.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace iris {
+
+namespace {
+
+// Percentiles are recomputed after this many new samples.
+constexpr size_t kResortEvery = 16;
+
+std::chrono::microseconds percentile(std::vector<uint32_t>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return std::chrono::microseconds(sorted[std::min(index, sorted.size() - 1)]);
+}
+
+} // namespace
+
+ReadPolicy::ReadPolicy(const ReadPolicyOptions& options)
+    : options_(options)
+    , jitter_(std::random_device{}()) {
+    if (options_.window == 0 || options_.minSamples == 0 || options_.minSamples > options_.window) {
+        throw std::invalid_argument("Read policy needs 0 < minSamples <= window");
+    }
+    if (options_.maxAttempts < 1) {
+        throw std::invalid_argument("Read policy needs at least one attempt");
+    }
+    for (Window& window : windows_) {
+        window.samples.reserve(options_.window);
+        window.plan = ReadPlan{options_.maxTimeout, std::chrono::milliseconds(0)};
+    }
+}
+
+ReadPlan ReadPolicy::plan(EndpointId id) {
+    Window& window = windows_[static_cast<size_t>(id)];
+    std::lock_guard<std::mutex> lock(window.mutex);
+    return window.plan;
+}
+
+void ReadPolicy::record(EndpointId id, Clock::duration latency) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    auto sample = static_cast<uint32_t>(std::clamp<int64_t>(micros, 0, UINT32_MAX));
+
+    Window& window = windows_[static_cast<size_t>(id)];
+    std::lock_guard<std::mutex> lock(window.mutex);
+    if (window.samples.size() < options_.window) {
+        window.samples.push_back(sample);
+    } else {
+        window.samples[window.next] = sample;
+    }
+    window.next = (window.next + 1) % options_.window;
+
+    if (window.samples.size() >= options_.minSamples
+        && (++window.sinceSorted >= kResortEvery || window.samples.size() == options_.minSamples)) {
+        updatePlan(window);
+    }
+}
+
+void ReadPolicy::updatePlan(Window& window) {
+    window.sinceSorted = 0;
+    std::vector<uint32_t> sorted(window.samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    using std::chrono::milliseconds;
+    auto tail = percentile(sorted, options_.timeoutPercentile);
+    auto timeout = std::chrono::duration_cast<milliseconds>(tail * options_.timeoutMultiplier);
+    window.plan.timeout = std::clamp(timeout, options_.minTimeout, options_.maxTimeout);
+
+    if (options_.hedge) {
+        auto hedge = std::chrono::duration_cast<milliseconds>(percentile(sorted, options_.hedgePercentile));
+        window.plan.hedgeAfter = std::max(hedge, options_.minHedgeDelay);
+    }
+}
+
+std::chrono::milliseconds ReadPolicy::backoff(int attempt) {
+    auto ceiling = options_.initialBackoff * (int64_t{1} << std::min(attempt, 20));
+    ceiling = std::min<std::chrono::milliseconds>(ceiling, options_.maxBackoff);
+    // Full jitter: uniform in [0, ceiling].
+    std::uniform_int_distribution<int64_t> spread(0, ceiling.count());
+    std::lock_guard<std::mutex> lock(jitterMutex_);
+    return std::chrono::milliseconds(spread(jitter_));
+}
+
+bool ReadPolicy::shouldRetry(const HttpResponse& response) {
+    // CURLE_ABORTED_BY_CALLBACK marks requests dropped on shutdown.
+    if (response.curlCode == CURLE_ABORTED_BY_CALLBACK) {
+        return false;
+    }
+    return response.curlCode != CURLE_OK || response.httpCode >= 500;
+}
+
+void ReadPolicy::countHedge(bool won) {
+    hedges_.fetch_add(1, std::memory_order_relaxed);
+    if (won) {
+        hedgeWins_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ReadPolicy::countRetry() {
+    retries_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ReadPolicyStats ReadPolicy::stats() const {
+    ReadPolicyStats stats;
+    stats.hedges = hedges_.load(std::memory_order_relaxed);
+    stats.hedgeWins = hedgeWins_.load(std::memory_order_relaxed);
+    stats.retries = retries_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace iris
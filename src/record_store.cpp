@@ -0,0 +1,270 @@
+#include "iris/record_store.hpp"
+#include "iris/iris_api.hpp"
+#include <algorithm>
+
+namespace iris {
+
+namespace {
+
+constexpr uint32_t kUpdatesKind = 0x100;
+constexpr uint32_t kTypesKind = 0x200;
+
+uint32_t historyKind(Currency currency) {
+    return static_cast<uint32_t>(currency) + 1;
+}
+
+std::optional<std::string> toOptional(std::optional<std::string_view> value) {
+    if (!value) {
+        return std::nullopt;
+    }
+    return std::string(*value);
+}
+
+Result<std::vector<HistoryData>> fetchHistory(IrisApi& api, Currency currency, int offset) {
+    switch (currency) {
+        case Currency::GOLD:
+            return api.tryGetGoldHistory(offset);
+        case Currency::DONATE_SCORE:
+            return api.tryGetDonateScoreHistory(offset);
+        case Currency::SWEETS:
+        default:
+            return api.tryGetSweetsHistory(offset);
+    }
+}
+
+bool sameRecord(const HistoryData& a, const HistoryData& b) {
+    return a.user_id == b.user_id && a.amount == b.amount && a.timestamp == b.timestamp
+        && a.type == b.type && a.comment == b.comment;
+}
+
+} // namespace
+
+PersistentTypeDictionary::PersistentTypeDictionary(const std::string& directory)
+    : store_(directory, kTypesKind, {{"name", sizeof(StringRef)}}) {
+    for (size_t i = 0; i < store_.size(); ++i) {
+        dictionary_.intern(store_.string(store_.column<StringRef>(0)[i]));
+    }
+}
+
+uint8_t PersistentTypeDictionary::intern(std::string_view name) {
+    if (auto code = dictionary_.find(name)) {
+        return *code;
+    }
+    uint8_t code = dictionary_.intern(name);
+    size_t count = store_.size();
+    store_.reserve(count + 1);
+    store_.column<StringRef>(0)[count] = store_.appendString(name);
+    store_.publish(count + 1, 0);
+    return code;
+}
+
+HistoryStore::HistoryStore(const std::string& directory, Currency currency)
+    : currency_(currency)
+    , store_(directory, historyKind(currency), {
+          {"user_id", sizeof(int64_t)},
+          {"amount", sizeof(int32_t)},
+          {"timestamp", sizeof(int64_t)},
+          {"type", sizeof(uint8_t)},
+          {"comment", sizeof(StringRef)},
+      })
+    , types_(directory + "/types") {
+}
+
+RecordView HistoryStore::view() const {
+    RecordView view;
+    view.userIds = userIds();
+    view.amounts = amounts();
+    view.timestamps = timestamps();
+    view.types = typeCodes();
+    view.size = size();
+    return view;
+}
+
+std::optional<std::string_view> HistoryStore::comment(size_t index) const {
+    const StringRef& ref = store_.column<StringRef>(kComment)[index];
+    if (!ref.present) {
+        return std::nullopt;
+    }
+    return store_.string(ref);
+}
+
+HistoryData HistoryStore::record(size_t index) const {
+    HistoryData record;
+    record.user_id = static_cast<long>(userIds()[index]);
+    record.type = std::string(type(index));
+    record.amount = amounts()[index];
+    record.comment = toOptional(comment(index));
+    record.timestamp = static_cast<long>(timestamps()[index]);
+    return record;
+}
+
+void HistoryStore::append(const std::vector<HistoryData>& records) {
+    if (records.empty()) {
+        return;
+    }
+
+    size_t count = store_.size();
+    store_.reserve(count + records.size());
+    long last = lastTimestamp();
+
+    for (const HistoryData& record : records) {
+        uint8_t type = types_.intern(record.type);
+        StringRef comment = record.comment ? store_.appendString(*record.comment)
+                                           : store_.nullString();
+        store_.column<int64_t>(kUserId)[count] = record.user_id;
+        store_.column<int32_t>(kAmount)[count] = record.amount;
+        store_.column<int64_t>(kTimestamp)[count] = record.timestamp;
+        store_.column<uint8_t>(kType)[count] = type;
+        store_.column<StringRef>(kComment)[count] = comment;
+        last = std::max(last, record.timestamp);
+        ++count;
+    }
+
+    store_.publish(count, last);
+}
+
+size_t HistoryStore::sync(IrisApi& api) {
+    long last = lastTimestamp();
+    bool empty = size() == 0;
+
+    // Nothing is stored until the scan has reached known ground: a page
+    // failing halfway would otherwise leave a gap the cursor has already
+    // moved past.
+    std::vector<HistoryData> fresh;
+    int offset = 0;
+    for (bool reached = false; !reached;) {
+        Result<std::vector<HistoryData>> page = fetchHistory(api, currency_, offset);
+        if (!page) {
+            throw IrisApiException("History sync failed at offset " + std::to_string(offset) + ": "
+                                   + page.error().message());
+        }
+        if (page->empty()) {
+            break;
+        }
+        offset += static_cast<int>(page->size());
+        for (HistoryData& record : *page) {
+            if (!empty && record.timestamp < last) {
+                reached = true;
+                break;
+            }
+            fresh.push_back(std::move(record));
+        }
+    }
+    std::reverse(fresh.begin(), fresh.end());
+
+    if (!empty) {
+        // Records from the last stored second may already be here.
+        std::vector<HistoryData> boundary;
+        for (size_t i = size(); i > 0 && timestamps()[i - 1] == last; --i) {
+            boundary.push_back(record(i - 1));
+        }
+        fresh.erase(std::remove_if(fresh.begin(), fresh.end(), [&](const HistoryData& record) {
+            if (record.timestamp != last) {
+                return false;
+            }
+            auto match = std::find_if(boundary.begin(), boundary.end(),
+                [&](const HistoryData& stored) { return sameRecord(stored, record); });
+            if (match == boundary.end()) {
+                return false;
+            }
+            boundary.erase(match);
+            return true;
+        }), fresh.end());
+    }
+
+    append(fresh);
+    return fresh.size();
+}
+
+UpdatesStore::UpdatesStore(const std::string& directory)
+    : store_(directory, kUpdatesKind, {
+          {"update_id", sizeof(int64_t)},
+          {"user_id", sizeof(int64_t)},
+          {"amount", sizeof(int32_t)},
+          {"timestamp", sizeof(int64_t)},
+          {"type", sizeof(uint8_t)},
+          {"comment", sizeof(StringRef)},
+      })
+    , types_(directory + "/types") {
+}
+
+RecordView UpdatesStore::view() const {
+    RecordView view;
+    view.userIds = userIds();
+    view.amounts = amounts();
+    view.timestamps = timestamps();
+    view.types = typeCodes();
+    view.size = size();
+    return view;
+}
+
+std::optional<std::string_view> UpdatesStore::comment(size_t index) const {
+    const StringRef& ref = store_.column<StringRef>(kComment)[index];
+    if (!ref.present) {
+        return std::nullopt;
+    }
+    return store_.string(ref);
+}
+
+UpdatesLog UpdatesStore::record(size_t index) const {
+    UpdatesLog record;
+    record.update_id = static_cast<long>(updateIds()[index]);
+    record.type = std::string(type(index));
+    record.user_id = static_cast<long>(userIds()[index]);
+    record.amount = amounts()[index];
+    record.comment = toOptional(comment(index));
+    record.timestamp = static_cast<long>(timestamps()[index]);
+    return record;
+}
+
+void UpdatesStore::append(const std::vector<UpdatesLog>& records) {
+    std::vector<const UpdatesLog*> fresh;
+    long last = lastUpdateId();
+    for (const UpdatesLog& record : records) {
+        if (record.update_id > last) {
+            fresh.push_back(&record);
+        }
+    }
+    if (fresh.empty()) {
+        return;
+    }
+    std::sort(fresh.begin(), fresh.end(), [](const UpdatesLog* a, const UpdatesLog* b) {
+        return a->update_id < b->update_id;
+    });
+
+    size_t count = store_.size();
+    store_.reserve(count + fresh.size());
+
+    for (const UpdatesLog* record : fresh) {
+        if (record->update_id <= last) {
+            continue;  // duplicate id inside the batch
+        }
+        uint8_t type = types_.intern(record->type);
+        StringRef comment = record->comment ? store_.appendString(*record->comment)
+                                            : store_.nullString();
+        store_.column<int64_t>(kUpdateId)[count] = record->update_id;
+        store_.column<int64_t>(kUserId)[count] = record->user_id;
+        store_.column<int32_t>(kAmount)[count] = record->amount;
+        store_.column<int64_t>(kTimestamp)[count] = record->timestamp;
+        store_.column<uint8_t>(kType)[count] = type;
+        store_.column<StringRef>(kComment)[count] = comment;
+        last = record->update_id;
+        ++count;
+    }
+
+    store_.publish(count, last);
+}
+
+size_t UpdatesStore::sync(IrisApi& api, int limit) {
+    size_t added = 0;
+    for (;;) {
+        size_t before = size();
+        append(api.getUpdates(lastUpdateId() + 1, limit));
+        if (size() == before) {
+            return added;
+        }
+        added += size() - before;
+    }
+}
+
+} // namespace iris
@@ -0,0 +1,74 @@
+#include "iris/record_view.hpp"
+#include <stdexcept>
+
+namespace iris {
+
+uint8_t TypeDictionary::intern(std::string_view name) {
+    auto it = codes_.find(std::string(name));
+    if (it != codes_.end()) {
+        return it->second;
+    }
+    if (names_.size() == kMaxTypes) {
+        throw std::length_error("Too many distinct record types");
+    }
+    auto code = static_cast<uint8_t>(names_.size());
+    names_.emplace_back(name);
+    codes_.emplace(names_.back(), code);
+    return code;
+}
+
+std::optional<uint8_t> TypeDictionary::find(std::string_view name) const {
+    auto it = codes_.find(std::string(name));
+    if (it == codes_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+RecordTable::RecordTable(const std::vector<HistoryData>& records) {
+    reserve(records.size());
+    for (const HistoryData& record : records) {
+        append(record);
+    }
+}
+
+RecordTable::RecordTable(const std::vector<UpdatesLog>& records) {
+    reserve(records.size());
+    for (const UpdatesLog& record : records) {
+        append(record);
+    }
+}
+
+void RecordTable::reserve(size_t records) {
+    userIds_.reserve(records);
+    amounts_.reserve(records);
+    timestamps_.reserve(records);
+    typeCodes_.reserve(records);
+}
+
+void RecordTable::append(const HistoryData& record) {
+    append(record.user_id, record.amount, record.timestamp, types_.intern(record.type));
+}
+
+void RecordTable::append(const UpdatesLog& record) {
+    append(record.user_id, record.amount, record.timestamp, types_.intern(record.type));
+}
+
+void RecordTable::append(int64_t userId, int32_t amount, int64_t timestamp, uint8_t type) {
+    userIds_.push_back(userId);
+    amounts_.push_back(amount);
+    timestamps_.push_back(timestamp);
+    typeCodes_.push_back(type);
+}
+
+RecordView RecordTable::view() const {
+    RecordView view;
+    view.userIds = userIds_.data();
+    view.amounts = amounts_.data();
+    view.timestamps = timestamps_.data();
+    view.types = typeCodes_.data();
+    view.size = amounts_.size();
+    return view;
+}
+
+} // namespace iris
@@ -0,0 +1,329 @@
+#include "iris/request_scheduler.hpp"
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace iris {
+
+namespace {
+
+RequestScheduler::Clock::duration secondsToDuration(double seconds) {
+    return std::chrono::duration_cast<RequestScheduler::Clock::duration>(
+        std::chrono::duration<double>(seconds));
+}
+
+} // namespace
+
+RequestScheduler::RequestScheduler(const SchedulerOptions& options)
+    : options_(options)
+    , refilled_(Clock::now())
+    , pausedUntil_(refilled_)
+    , backoff_(options.initialBackoff)
+    , jitter_(std::random_device{}()) {
+    if (options_.ratePerSecond <= 0 || options_.burst < 1) {
+        throw std::invalid_argument("Scheduler needs a positive rate and a burst of at least 1");
+    }
+    if (options_.maxInFlight == 0) {
+        throw std::invalid_argument("Scheduler needs maxInFlight of at least 1");
+    }
+    for (size_t i = 0; i < kRequestClassCount; ++i) {
+        if (options_.weights[i] <= 0 || options_.classRates[i] < 0) {
+            throw std::invalid_argument("Scheduler weights must be positive and rates non-negative");
+        }
+        double rate = options_.classRates[i];
+        double capacity = std::max(1.0, rate);
+        classBuckets_[i] = Bucket{capacity, rate, capacity};
+    }
+    shared_ = Bucket{options_.burst, options_.ratePerSecond, options_.burst};
+
+    thread_ = std::thread(&RequestScheduler::run, this);
+}
+
+RequestScheduler::~RequestScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool RequestScheduler::acquire(RequestClass cls, const void* owner) {
+    bool ready = false;
+    bool granted = false;
+    submit(cls, [this, &ready, &granted](bool ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        granted = ok;
+        ready = true;
+        granted_.notify_all();
+    }, owner);
+    std::unique_lock<std::mutex> lock(mutex_);
+    granted_.wait(lock, [&] { return ready; });
+    return granted;
+}
+
+void RequestScheduler::submit(RequestClass cls, Grant grant, const void* owner) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_) {
+            ClassQueue& queue = queues_[static_cast<size_t>(cls)];
+            queue.byOwner[owner].push_back(Entry{std::move(grant), owner});
+            ++queue.size;
+            ++owners_[owner].stats.queued;
+            grant = nullptr;
+        }
+    }
+    if (grant) {
+        grant(false);
+        return;
+    }
+    wake_.notify_one();
+}
+
+bool RequestScheduler::release(const HttpResponse& response) {
+    bool throttled = response.httpCode == 429;
+    bool serverError = response.httpCode >= 500;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inFlight_ > 0) {
+            --inFlight_;
+        }
+        if (throttled || serverError) {
+            ++(throttled ? stats_.throttled : stats_.serverErrors);
+            std::uniform_real_distribution<double> spread(0.5, 1.0);
+            auto pause = std::chrono::duration_cast<Clock::duration>(backoff_ * spread(jitter_));
+            pause = std::max<Clock::duration>(pause, std::chrono::seconds(response.retryAfter));
+            pausedUntil_ = std::max(pausedUntil_, Clock::now() + pause);
+            backoff_ = std::min(backoff_ * 2, options_.maxBackoff);
+            shared_.tokens = 0;
+        } else if (response.curlCode == CURLE_OK) {
+            backoff_ = options_.initialBackoff;
+        }
+    }
+    wake_.notify_one();
+    return throttled;
+}
+
+void RequestScheduler::cancel(const void* owner) {
+    std::vector<Entry> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ClassQueue& queue : queues_) {
+            auto it = queue.byOwner.find(owner);
+            if (it == queue.byOwner.end()) {
+                continue;
+            }
+            queue.size -= it->second.size();
+            std::move(it->second.begin(), it->second.end(), std::back_inserter(dropped));
+            queue.byOwner.erase(it);
+        }
+        owners_.erase(owner);
+    }
+    for (Entry& entry : dropped) {
+        entry.grant(false);
+    }
+}
+
+void RequestScheduler::setBudget(const void* owner, const OwnerBudget& budget) {
+    if (budget.ratePerSecond < 0 || budget.weight <= 0) {
+        throw std::invalid_argument("Owner budget needs a non-negative rate and a positive weight");
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Owner& state = owners_[owner];
+        double capacity = std::max(1.0, budget.burst);
+        state.bucket = Bucket{budget.ratePerSecond > 0 ? capacity : 0, budget.ratePerSecond, capacity};
+        state.weight = budget.weight;
+    }
+    wake_.notify_one();
+}
+
+OwnerStats RequestScheduler::ownerStats(const void* owner) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = owners_.find(owner);
+    return it == owners_.end() ? OwnerStats{} : it->second.stats;
+}
+
+SchedulerStats RequestScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SchedulerStats stats = stats_;
+    for (size_t i = 0; i < kRequestClassCount; ++i) {
+        stats.queued[i] = queues_[i].size;
+    }
+    return stats;
+}
+
+void RequestScheduler::refill(Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - refilled_).count();
+    refilled_ = now;
+    shared_.tokens = std::min(shared_.capacity, shared_.tokens + elapsed * shared_.rate);
+    for (Bucket& bucket : classBuckets_) {
+        if (bucket.rate > 0) {
+            bucket.tokens = std::min(bucket.capacity, bucket.tokens + elapsed * bucket.rate);
+        }
+    }
+    for (auto& [owner, state] : owners_) {
+        Bucket& bucket = state.bucket;
+        if (bucket.rate > 0) {
+            bucket.tokens = std::min(bucket.capacity, bucket.tokens + elapsed * bucket.rate);
+        }
+    }
+}
+
+bool RequestScheduler::ownerReady(const void* owner) const {
+    auto it = owners_.find(owner);
+    return it == owners_.end() || it->second.bucket.rate <= 0 || it->second.bucket.tokens >= 1;
+}
+
+bool RequestScheduler::pickOwner(const ClassQueue& queue, const void*& owner) const {
+    // Same fair queuing as across classes, over owner weights. Owner
+    // finish times are shared by all classes, so an owner's share covers
+    // everything it sends.
+    bool found = false;
+    double bestStart = 0;
+    for (const auto& [candidate, entries] : queue.byOwner) {
+        if (!ownerReady(candidate)) {
+            continue;
+        }
+        auto it = owners_.find(candidate);
+        double start = it == owners_.end() ? ownerTime_ : std::max(it->second.finish, ownerTime_);
+        if (!found || start < bestStart) {
+            found = true;
+            owner = candidate;
+            bestStart = start;
+        }
+    }
+    return found;
+}
+
+int RequestScheduler::pickClass(const void*& owner) const {
+    // Start-time fair queuing: serve the class whose next request would
+    // start first in virtual time. Virtual time follows the start of the
+    // last grant, so a backlogged class keeps its own finish time and gets
+    // its weight's share; an idle one rejoins at the current time.
+    int best = -1;
+    double bestStart = 0;
+    for (size_t i = 0; i < kRequestClassCount; ++i) {
+        const Bucket& bucket = classBuckets_[i];
+        const void* candidate = nullptr;
+        if (queues_[i].size == 0 || (bucket.rate > 0 && bucket.tokens < 1) || !pickOwner(queues_[i], candidate)) {
+            continue;
+        }
+        double start = std::max(finish_[i], virtualTime_);
+        if (best < 0 || start < bestStart) {
+            best = static_cast<int>(i);
+            bestStart = start;
+            owner = candidate;
+        }
+    }
+    return best;
+}
+
+std::optional<RequestScheduler::Clock::time_point> RequestScheduler::nextRefill(Clock::time_point now) const {
+    // When the bucket that blocks a waiting request next yields a token.
+    auto untilToken = [now](const Bucket& bucket) {
+        return now + secondsToDuration((1 - bucket.tokens) / bucket.rate);
+    };
+    std::optional<Clock::time_point> wakeAt;
+    auto consider = [&wakeAt](Clock::time_point at) {
+        wakeAt = wakeAt ? std::min(*wakeAt, at) : at;
+    };
+    for (size_t i = 0; i < kRequestClassCount; ++i) {
+        const Bucket& bucket = classBuckets_[i];
+        if (queues_[i].size == 0) {
+            continue;
+        }
+        if (bucket.rate > 0 && bucket.tokens < 1) {
+            consider(untilToken(bucket));
+            continue;
+        }
+        for (const auto& [owner, entries] : queues_[i].byOwner) {
+            auto it = owners_.find(owner);
+            if (it != owners_.end() && it->second.bucket.rate > 0 && it->second.bucket.tokens < 1) {
+                consider(untilToken(it->second.bucket));
+            }
+        }
+    }
+    return wakeAt;
+}
+
+void RequestScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        Clock::time_point now = Clock::now();
+        refill(now);
+
+        std::optional<Clock::time_point> wakeAt;
+        if (now < pausedUntil_) {
+            wakeAt = pausedUntil_;
+        } else if (inFlight_ < options_.maxInFlight) {
+            const void* owner = nullptr;
+            int cls = pickClass(owner);
+            if (cls >= 0 && shared_.tokens >= 1) {
+                size_t i = static_cast<size_t>(cls);
+                ClassQueue& queue = queues_[i];
+                auto found = queue.byOwner.find(owner);
+                Entry entry = std::move(found->second.front());
+                found->second.pop_front();
+                if (found->second.empty()) {
+                    queue.byOwner.erase(found);
+                }
+                --queue.size;
+
+                shared_.tokens -= 1;
+                if (classBuckets_[i].rate > 0) {
+                    classBuckets_[i].tokens -= 1;
+                }
+                virtualTime_ = std::max(finish_[i], virtualTime_);
+                finish_[i] = virtualTime_ + 1.0 / options_.weights[i];
+                Owner& state = owners_[owner];
+                if (state.bucket.rate > 0) {
+                    state.bucket.tokens -= 1;
+                }
+                ownerTime_ = std::max(state.finish, ownerTime_);
+                state.finish = ownerTime_ + 1.0 / state.weight;
+                --state.stats.queued;
+                ++state.stats.granted;
+                ++inFlight_;
+                ++stats_.granted[i];
+
+                lock.unlock();
+                entry.grant(true);
+                lock.lock();
+                continue;
+            }
+
+            // Sleep until the bucket that blocks a waiting request refills.
+            if (cls >= 0) {
+                wakeAt = now + secondsToDuration((1 - shared_.tokens) / shared_.rate);
+            } else {
+                wakeAt = nextRefill(now);
+            }
+        }
+
+        if (wakeAt) {
+            wake_.wait_until(lock, *wakeAt);
+        } else {
+            wake_.wait(lock);
+        }
+    }
+
+    std::vector<Entry> dropped;
+    for (ClassQueue& queue : queues_) {
+        for (auto& [owner, entries] : queue.byOwner) {
+            std::move(entries.begin(), entries.end(), std::back_inserter(dropped));
+        }
+        queue.byOwner.clear();
+        queue.size = 0;
+    }
+    lock.unlock();
+    for (Entry& entry : dropped) {
+        entry.grant(false);
+    }
+}
+
+} // namespace iris
@@ -0,0 +1,86 @@
+#include "iris/result.hpp"
+#include <array>
+
+namespace iris {
+
+namespace {
+
+constexpr std::array<std::string_view, 8> kErrorCodeNames = {
+    "timeout", "transport", "throttled", "http_4xx", "http_5xx", "api", "decode", "invalid_argument",
+};
+
+ErrorCode httpErrorCode(long httpCode) {
+    if (httpCode == 429) {
+        return ErrorCode::THROTTLED;
+    }
+    return httpCode >= 500 ? ErrorCode::HTTP_5XX : ErrorCode::HTTP_4XX;
+}
+
+} // namespace
+
+std::string_view errorCodeName(ErrorCode code) {
+    return kErrorCodeNames[static_cast<size_t>(code)];
+}
+
+std::string Error::message() const {
+    std::string text(errorCodeName(code));
+    if (curlCode != CURLE_OK) {
+        text += ": CURL error (" + std::to_string(curlCode) + ")";
+    } else if (httpCode != 0 && httpCode != 200) {
+        text += ": HTTP error " + std::to_string(httpCode);
+    }
+    if (apiError) {
+        text += ": " + apiError->description + " (" + std::to_string(apiError->code) + ")";
+    }
+    if (!detail.empty()) {
+        text += ": " + detail;
+    }
+    return text;
+}
+
+Error responseError(const HttpResponse& response) {
+    Error error(ErrorCode::TRANSPORT, response.httpCode);
+    error.curlCode = response.curlCode;
+    error.retryAfter = response.retryAfter;
+    if (response.curlCode != CURLE_OK) {
+        if (response.curlCode == CURLE_OPERATION_TIMEDOUT) {
+            error.code = ErrorCode::TIMEOUT;
+        }
+        error.detail = !response.error.empty() ? response.error : curl_easy_strerror(response.curlCode);
+        return error;
+    }
+    error.code = httpErrorCode(response.httpCode);
+    error.apiError = findApiError(response.body);
+    return error;
+}
+
+std::optional<APIError> findApiError(std::string_view body) {
+    // Cheap reject before parsing: error answers are objects with an
+    // "error" key.
+    if (body.empty() || body.front() != '{' || body.find("\"error\"") == std::string_view::npos) {
+        return std::nullopt;
+    }
+    std::optional<Response> response;
+    std::string error;
+    if (!tryDecodeGiveResponse(body, response, error) || !response) {
+        return std::nullopt;
+    }
+    return std::move(response->error);
+}
+
+Result<Response> rejectApiError(Result<Response> result) {
+    if (result && result->error) {
+        Error error(ErrorCode::API, 200);
+        error.apiError = std::move(result->error);
+        return error;
+    }
+    return result;
+}
+
+Error invalidArgument(const char* reason) {
+    Error error(ErrorCode::INVALID_ARGUMENT);
+    error.detail = reason;
+    return error;
+}
+
+} // namespace iris
@@ -0,0 +1,312 @@
+#include "iris/transport.hpp"
+#include "iris/async_engine.hpp"
+#include <stdexcept>
+
+namespace iris {
+
+namespace {
+
+constexpr std::string_view kRecordingMagic = "IRISREC1";
+constexpr uint8_t kPostFlag = 1;
+
+std::string_view relativeUrl(std::string_view url, std::string_view baseUrl) {
+    if (!baseUrl.empty() && url.substr(0, baseUrl.size()) == baseUrl) {
+        url.remove_prefix(baseUrl.size());
+    }
+    return url;
+}
+
+std::string_view pathOf(std::string_view url) {
+    return url.substr(0, url.find('?'));
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void appendBytes(std::string& out, std::string_view bytes) {
+    appendVarint(out, bytes.size());
+    out.append(bytes);
+}
+
+// Sequential reader over a recording; throws on truncated input.
+class RecordingReader {
+public:
+    explicit RecordingReader(std::string_view data) : data_(data) {}
+
+    bool done() const { return pos_ == data_.size(); }
+
+    uint8_t byte() {
+        need(1);
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid recording: varint too long");
+    }
+
+    std::string_view bytes() {
+        uint64_t length = varint();
+        need(length);
+        std::string_view result = data_.substr(pos_, static_cast<size_t>(length));
+        pos_ += static_cast<size_t>(length);
+        return result;
+    }
+
+private:
+    void need(uint64_t length) const {
+        if (length > data_.size() - pos_) {
+            throw std::runtime_error("Invalid recording: truncated record");
+        }
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+} // namespace
+
+CurlTransport::CurlTransport(std::shared_ptr<ConnectionPool> pool)
+    : pool_(std::move(pool)) {
+    if (!pool_) {
+        throw std::invalid_argument("Connection pool must not be null");
+    }
+}
+
+CurlTransport::~CurlTransport() = default;
+
+void CurlTransport::perform(const HttpRequest& request, HttpResponse& response) {
+    auto lease = pool_->acquire();
+    RequestContext& context = lease.context();
+    context.request = request;
+    prepareTransfer(context, pool_->postHeaders());
+    finishTransfer(context, curl_easy_perform(context.curl));
+    // Swapping keeps both buffers' capacity in use.
+    std::swap(response, context.response);
+}
+
+void CurlTransport::submit(HttpRequest request, Completion done) {
+    std::call_once(engineOnce_, [this] { engine_ = std::make_unique<AsyncEngine>(pool_->share()); });
+    engine_->submit(std::move(request), std::move(done));
+}
+
+RecordingTransport::RecordingTransport(std::shared_ptr<Transport> inner, const std::string& path,
+                                       std::string baseUrl)
+    : inner_(std::move(inner))
+    , baseUrl_(std::move(baseUrl)) {
+    if (!inner_) {
+        throw std::invalid_argument("Recording transport needs an inner transport");
+    }
+    if (baseUrl_.empty()) {
+        throw std::invalid_argument("Recording transport needs the client's base URL");
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Failed to open recording " + path);
+    }
+    out_.write(kRecordingMagic.data(), static_cast<std::streamsize>(kRecordingMagic.size()));
+}
+
+RecordingTransport::~RecordingTransport() {
+    flush();
+}
+
+void RecordingTransport::perform(const HttpRequest& request, HttpResponse& response) {
+    inner_->perform(request, response);
+    write(request, response);
+}
+
+void RecordingTransport::submit(HttpRequest request, Completion done) {
+    HttpRequest sent = request;
+    inner_->submit(std::move(sent), [this, request = std::move(request),
+                                     done = std::move(done)](HttpResponse response) {
+        write(request, response);
+        done(std::move(response));
+    });
+}
+
+size_t RecordingTransport::recorded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recorded_;
+}
+
+void RecordingTransport::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.flush();
+}
+
+void RecordingTransport::write(const HttpRequest& request, const HttpResponse& response) {
+    std::string_view url = request.url;
+    if (url.substr(0, baseUrl_.size()) != baseUrl_) {
+        return;
+    }
+    url.remove_prefix(baseUrl_.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.clear();
+    buffer_.push_back(static_cast<char>(request.isPost ? kPostFlag : 0));
+    appendVarint(buffer_, static_cast<uint64_t>(response.curlCode));
+    appendVarint(buffer_, static_cast<uint64_t>(response.httpCode));
+    appendVarint(buffer_, static_cast<uint64_t>(response.retryAfter));
+    appendBytes(buffer_, url);
+    appendBytes(buffer_, response.body);
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    ++recorded_;
+}
+
+ReplayTransport::ReplayTransport(const std::string& path, std::string baseUrl, const ReplayOptions& options)
+    : baseUrl_(std::move(baseUrl))
+    , options_(options) {
+    if (baseUrl_.empty()) {
+        throw std::invalid_argument("Replay transport needs the client's base URL");
+    }
+    load(path);
+    worker_ = std::thread(&ReplayTransport::run, this);
+}
+
+ReplayTransport::~ReplayTransport() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+void ReplayTransport::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Failed to open recording " + path);
+    }
+    data_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(data_.data(), static_cast<std::streamsize>(data_.size()));
+    if (!in || std::string_view(data_).substr(0, kRecordingMagic.size()) != kRecordingMagic) {
+        throw std::runtime_error("Invalid recording: " + path);
+    }
+
+    RecordingReader reader(std::string_view(data_).substr(kRecordingMagic.size()));
+    while (!reader.done()) {
+        reader.byte();  // flags; matching is by URL only
+        Record record;
+        record.curlCode = static_cast<CURLcode>(reader.varint());
+        record.httpCode = static_cast<long>(reader.varint());
+        record.retryAfter = static_cast<long>(reader.varint());
+        std::string_view url = reader.bytes();
+        record.body = reader.bytes();
+
+        byUrl_[url].records.push_back(records_.size());
+        byPath_[pathOf(url)].records.push_back(records_.size());
+        records_.push_back(record);
+    }
+}
+
+const ReplayTransport::Record* ReplayTransport::pick(std::string_view url) {
+    auto take = [this](Cursor& cursor) -> const Record* {
+        if (cursor.next == cursor.records.size()) {
+            if (!options_.loop) {
+                return nullptr;
+            }
+            cursor.next = 0;
+        }
+        return &records_[cursor.records[cursor.next++]];
+    };
+
+    url = relativeUrl(url, baseUrl_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto exact = byUrl_.find(url);
+    if (exact != byUrl_.end()) {
+        if (const Record* record = take(exact->second)) {
+            ++stats_.served;
+            return record;
+        }
+    }
+    if (options_.matchPath) {
+        auto path = byPath_.find(pathOf(url));
+        if (path != byPath_.end()) {
+            if (const Record* record = take(path->second)) {
+                ++stats_.served;
+                ++stats_.pathMatches;
+                return record;
+            }
+        }
+    }
+    ++stats_.misses;
+    return nullptr;
+}
+
+void ReplayTransport::perform(const HttpRequest& request, HttpResponse& response) {
+    response.timings = {};
+    response.error.clear();
+    const Record* record = pick(request.url);
+    if (!record) {
+        response.curlCode = CURLE_OK;
+        response.httpCode = 404;
+        response.retryAfter = 0;
+        response.body.clear();
+        return;
+    }
+    response.curlCode = record->curlCode;
+    response.httpCode = record->httpCode;
+    response.retryAfter = record->retryAfter;
+    response.body.assign(record->body);
+    response.timings.bytes = static_cast<int64_t>(record->body.size());
+    if (record->curlCode != CURLE_OK) {
+        response.error = curl_easy_strerror(record->curlCode);
+    }
+}
+
+void ReplayTransport::submit(HttpRequest request, Completion done) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queue_.push_back(Job{std::move(request), std::move(done)});
+    }
+    wake_.notify_one();
+}
+
+ReplayStats ReplayTransport::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ReplayTransport::run() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        bool stopping = stopping_;
+        lock.unlock();
+
+        HttpResponse response;
+        if (stopping) {
+            response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+            response.error = "Replay transport stopped";
+        } else {
+            perform(job.request, response);
+        }
+        try {
+            job.done(std::move(response));
+        } catch (...) {
+            // A throwing completion must not stop the worker.
+        }
+        lock.lock();
+    }
+}
+
+} // namespace iris
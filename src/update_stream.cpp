@@ -0,0 +1,147 @@
+#include "iris/update_stream.hpp"
+#include "iris/iris_api.hpp"
+#include <algorithm>
+
+namespace iris {
+
+namespace {
+
+constexpr std::chrono::milliseconds kPollSlice{100};
+constexpr std::chrono::milliseconds kBackpressureSlice{10};
+
+} // namespace
+
+UpdateStream::UpdateStream(IrisApi& api, UpdateStreamOptions options)
+    : api_(api)
+    , options_(options)
+    , queue_(options.capacity)
+    , offset_(options.offset)
+    , stopping_(false)
+    , waiters_(0)
+    , producerWaiting_(false) {
+    poller_ = std::thread(&UpdateStream::run, this);
+}
+
+UpdateStream::~UpdateStream() {
+    stop();
+}
+
+void UpdateStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        stopping_.store(true, std::memory_order_release);
+    }
+    readable_.notify_all();
+    writable_.notify_all();
+    if (poller_.joinable() && poller_.get_id() != std::this_thread::get_id()) {
+        poller_.join();
+    }
+}
+
+bool UpdateStream::tryPop(UpdatesLog& update) {
+    if (!queue_.tryPop(update)) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producerWaiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        writable_.notify_one();
+    }
+    return true;
+}
+
+bool UpdateStream::pop(UpdatesLog& update, std::chrono::milliseconds timeout) {
+    if (tryPop(update)) {
+        return true;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool popped = false;
+    while (!(popped = queue_.tryPop(update)) && !stopping_.load(std::memory_order_acquire)) {
+        if (readable_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            popped = queue_.tryPop(update);
+            break;
+        }
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    lock.unlock();
+
+    if (popped && producerWaiting_.load(std::memory_order_relaxed)) {
+        writable_.notify_one();
+    }
+    return popped;
+}
+
+bool UpdateStream::deliver(UpdatesLog update) {
+    while (!queue_.tryPush(std::move(update))) {
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        producerWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (stopping_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (queue_.size() >= queue_.capacity()) {
+            writable_.wait_for(lock, kBackpressureSlice);
+        }
+        producerWaiting_.store(false, std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        readable_.notify_one();
+    }
+    return true;
+}
+
+void UpdateStream::idle(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    writable_.wait_for(lock, delay, [this] { return stopping_.load(std::memory_order_acquire); });
+}
+
+void UpdateStream::run() {
+    auto pending = api_.getUpdatesAsync(offset(), options_.limit);
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (pending.wait_for(kPollSlice) != std::future_status::ready) {
+            continue;
+        }
+
+        std::vector<UpdatesLog> batch = pending.get();
+        long current = offset();
+        long next = current;
+        for (const auto& update : batch) {
+            next = std::max(next, update.update_id + 1);
+        }
+
+        if (next == current) {
+            idle(options_.idleDelay);
+            pending = api_.getUpdatesAsync(current, options_.limit);
+            continue;
+        }
+
+        // Prefetch the next page before handing this one to consumers. The
+        // offset only moves past updates that made it into the queue, so
+        // after stop() it still points at the first one left undelivered.
+        pending = api_.getUpdatesAsync(next, options_.limit);
+
+        for (auto& update : batch) {
+            if (update.update_id < current) {
+                continue;
+            }
+            long after = update.update_id + 1;
+            if (!deliver(std::move(update))) {
+                return;
+            }
+            if (after > offset()) {
+                offset_.store(after, std::memory_order_release);
+            }
+        }
+    }
+}
+
+} // namespace iris
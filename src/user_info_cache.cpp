@@ -0,0 +1,183 @@
+#include "iris/user_info_cache.hpp"
+#include "iris/iris_api.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace iris {
+
+namespace {
+
+size_t shardIndex(long userId, size_t shardCount) {
+    // Fibonacci hashing spreads sequential ids across shards.
+    auto mixed = static_cast<uint64_t>(userId) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(mixed >> 32) % shardCount;
+}
+
+} // namespace
+
+template <typename T>
+UserInfoCache::Table<T>::Table(std::chrono::milliseconds ttl, size_t shardCount, size_t maxEntries)
+    : ttl(ttl)
+    , maxPerShard(std::max<size_t>(1, maxEntries / std::max<size_t>(1, shardCount)))
+    , shards(std::max<size_t>(1, shardCount)) {
+}
+
+template <typename T>
+UserInfoCache::Shard<T>& UserInfoCache::Table<T>::shardFor(long userId) {
+    return shards[shardIndex(userId, shards.size())];
+}
+
+template <typename T>
+void UserInfoCache::Table<T>::makeRoom(Shard<T>& shard, Clock::time_point now) {
+    auto& entries = shard.entries;
+    if (entries.size() < maxPerShard) {
+        return;
+    }
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        bool expired = !it->second.loader && it->second.expires <= now;
+        it = expired ? entries.erase(it) : std::next(it);
+    }
+
+    // Still full of live entries: drop ready ones until a tenth is free.
+    size_t target = maxPerShard - std::max<size_t>(1, maxPerShard / 10);
+    for (auto it = entries.begin(); it != entries.end() && entries.size() > target;) {
+        it = !it->second.loader ? entries.erase(it) : std::next(it);
+    }
+}
+
+UserInfoCache::UserInfoCache(IrisApi& api, const UserInfoCacheOptions& options)
+    : api_(api)
+    , reg_(options.regTtl, options.shards, options.maxEntries)
+    , spam_(options.spamTtl, options.shards, options.maxEntries)
+    , activity_(options.activityTtl, options.shards, options.maxEntries)
+    , stars_(options.starsTtl, options.shards, options.maxEntries)
+    , pocket_(options.pocketTtl, options.shards, options.maxEntries)
+    , hits_(0)
+    , misses_(0)
+    , coalesced_(0) {
+}
+
+template <typename T>
+std::optional<T> UserInfoCache::lookup(Table<T>& table, long userId,
+                                       std::optional<T> (IrisApi::*fetch)(long)) {
+    Shard<T>& shard = table.shardFor(userId);
+    std::promise<std::optional<T>> promise;
+    std::shared_future<std::optional<T>> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto now = Clock::now();
+        auto it = shard.entries.find(userId);
+
+        if (it != shard.entries.end()) {
+            Entry<T>& entry = it->second;
+            if (entry.loader) {
+                coalesced_.fetch_add(1, std::memory_order_relaxed);
+                pending = entry.value;
+            } else if (now < entry.expires) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return entry.value.get();
+            }
+        }
+
+        if (!pending.valid()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            if (it == shard.entries.end()) {
+                table.makeRoom(shard, now);
+                it = shard.entries.try_emplace(userId).first;
+            }
+            it->second.value = promise.get_future().share();
+            it->second.loader = &promise;
+        }
+    }
+
+    if (pending.valid()) {
+        return pending.get();
+    }
+
+    std::optional<T> result;
+    try {
+        result = (api_.*fetch)(userId);
+    } catch (...) {
+        // Keep waiters from hanging; they see a failed lookup.
+    }
+    promise.set_value(result);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(userId);
+    if (it != shard.entries.end() && it->second.loader == &promise) {
+        if (result && table.ttl.count() > 0) {
+            it->second.loader = nullptr;
+            it->second.expires = Clock::now() + table.ttl;
+        } else {
+            shard.entries.erase(it);
+        }
+    }
+    return result;
+}
+
+std::optional<UserRegInfo> UserInfoCache::checkUserReg(long userId) {
+    return lookup(reg_, userId, &IrisApi::checkUserReg);
+}
+
+std::optional<UserSpamInfo> UserInfoCache::checkUserSpam(long userId) {
+    return lookup(spam_, userId, &IrisApi::checkUserSpam);
+}
+
+std::optional<UserActivityInfo> UserInfoCache::checkUserActivity(long userId) {
+    return lookup(activity_, userId, &IrisApi::checkUserActivity);
+}
+
+std::optional<UserStarsInfo> UserInfoCache::checkUserStars(long userId) {
+    return lookup(stars_, userId, &IrisApi::checkUserStars);
+}
+
+std::optional<UserPocketInfo> UserInfoCache::checkUserPocket(long userId) {
+    return lookup(pocket_, userId, &IrisApi::checkUserPocket);
+}
+
+namespace {
+
+template <typename Table>
+void eraseUser(Table& table, long userId) {
+    auto& shard = table.shardFor(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(userId);
+}
+
+template <typename Table>
+void eraseAll(Table& table) {
+    for (auto& shard : table.shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+} // namespace
+
+void UserInfoCache::invalidate(long userId) {
+    eraseUser(reg_, userId);
+    eraseUser(spam_, userId);
+    eraseUser(activity_, userId);
+    eraseUser(stars_, userId);
+    eraseUser(pocket_, userId);
+}
+
+void UserInfoCache::clear() {
+    eraseAll(reg_);
+    eraseAll(spam_);
+    eraseAll(activity_);
+    eraseAll(stars_);
+    eraseAll(pocket_);
+}
+
+UserInfoCacheStats UserInfoCache::stats() const {
+    UserInfoCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace iris
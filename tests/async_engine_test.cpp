@@ -0,0 +1,99 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/async_engine.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// Engine shutdown: a completion may drop the engine's last owner, and every
+// callback runs exactly once, including for transfers submitted after the
+// engine began stopping.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+iris::HttpRequest request(const std::string& baseUrl, const char* path) {
+    iris::HttpRequest request;
+    request.url = baseUrl + "/" + path;
+    return request;
+}
+
+bool waitFor(const std::atomic<int>& value, int expected) {
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+    while (value.load() != expected && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return value.load() == expected;
+}
+
+// The completion of a fast request releases the engine while a slow one is
+// still running, so the engine is destroyed on its own loop thread.
+void destroyedByCompletion(const std::string& baseUrl) {
+    auto engine = std::make_shared<iris::AsyncEngine>();
+    std::atomic<int> finished{0};
+    std::atomic<CURLcode> slowCode{CURLE_OK};
+    std::atomic<bool> loopThread{false};
+
+    // Once curl has seen the host answer over HTTP/1.1, it no longer holds
+    // new transfers back waiting to multiplex them onto a busy connection.
+    std::atomic<int> warmed{0};
+    engine->submit(request(baseUrl, "fast"), [&](iris::HttpResponse) { ++warmed; });
+    IRIS_CHECK(waitFor(warmed, 1));
+
+    engine->submit(request(baseUrl, "slow"), [&](iris::HttpResponse response) {
+        slowCode = response.curlCode;
+        ++finished;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    iris::AsyncEngine* raw = engine.get();
+    auto owner = std::make_shared<std::shared_ptr<iris::AsyncEngine>>(std::move(engine));
+    raw->submit(request(baseUrl, "fast"), [&, owner](iris::HttpResponse response) {
+        IRIS_CHECK_EQ(response.httpCode, 200L);
+        std::thread::id self = std::this_thread::get_id();
+        owner->reset();
+        loopThread = self == std::this_thread::get_id();
+        ++finished;
+    });
+
+    IRIS_CHECK(waitFor(finished, 2));
+    IRIS_CHECK(loopThread.load());
+    IRIS_CHECK_EQ(slowCode.load(), CURLE_ABORTED_BY_CALLBACK);
+}
+
+// A completion run while the engine stops submits again; that transfer is
+// answered as aborted instead of being dropped.
+void submitAfterStop(const std::string& baseUrl) {
+    std::atomic<int> finished{0};
+    std::atomic<CURLcode> retryCode{CURLE_OK};
+    {
+        iris::AsyncEngine engine;
+        engine.submit(request(baseUrl, "slow"), [&](iris::HttpResponse response) {
+            IRIS_CHECK_EQ(response.curlCode, CURLE_ABORTED_BY_CALLBACK);
+            ++finished;
+            engine.submit(request(baseUrl, "fast"), [&](iris::HttpResponse retry) {
+                retryCode = retry.curlCode;
+                ++finished;
+            });
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    IRIS_CHECK_EQ(finished.load(), 2);
+    IRIS_CHECK_EQ(retryCode.load(), CURLE_ABORTED_BY_CALLBACK);
+}
+
+} // namespace
+
+int main() {
+    iris::bench::MockServer server([](std::string_view target, std::string& body) {
+        if (target.find("slow") != std::string_view::npos) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        }
+        body = "{}";
+    });
+
+    destroyedByCompletion(server.baseUrl());
+    submitAfterStop(server.baseUrl());
+    return iris::test::result();
+}
@@ -0,0 +1,77 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/async_engine.hpp>
+#include <iris/iris_api.hpp>
+#include <iris/read_policy.hpp>
+#include <iris/request_scheduler.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Destroying a client while its async reads are being retried: every
+// callback runs once, destruction waits only for attempts already out, and
+// no retry is sent after it started.
+
+namespace {
+
+constexpr int kCalls = 8;
+
+struct Outcome {
+    std::atomic<int> finished{0};
+    std::atomic<int> succeeded{0};
+};
+
+void run(const std::string& baseUrl, std::atomic<int>& requests, bool sharedEngine, bool scheduled) {
+    using Clock = std::chrono::steady_clock;
+    Outcome outcome;
+    auto engine = std::make_shared<iris::AsyncEngine>();
+    Clock::time_point closing;
+    {
+        iris::ReadPolicyOptions options;
+        options.hedge = false;
+        options.maxAttempts = 200;
+        options.initialBackoff = std::chrono::milliseconds(20);
+        options.maxBackoff = std::chrono::milliseconds(20);
+        iris::IrisApi api(1, "token", baseUrl);
+        api.setReadPolicy(std::make_shared<iris::ReadPolicy>(options));
+        if (sharedEngine) {
+            api.setEngine(engine);
+        }
+        if (scheduled) {
+            api.setScheduler(std::make_shared<iris::RequestScheduler>());
+        }
+        for (int i = 0; i < kCalls; ++i) {
+            api.getBalanceAsync([&outcome](std::optional<iris::BalanceData> balance) {
+                outcome.succeeded += balance.has_value();
+                ++outcome.finished;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        closing = Clock::now();
+    }
+    // Retrying to the end would take up to 200 attempts * 20 ms.
+    IRIS_CHECK(Clock::now() - closing < std::chrono::milliseconds(500));
+    IRIS_CHECK_EQ(outcome.finished.load(), kCalls);
+    IRIS_CHECK_EQ(outcome.succeeded.load(), 0);
+
+    int sent = requests.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    IRIS_CHECK_EQ(requests.load(), sent);
+}
+
+} // namespace
+
+int main() {
+    std::atomic<int> requests{0};
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{
+        [&](std::string_view, std::string& body) {
+            ++requests;
+            body = R"({"error":"unavailable"})";
+            return 503;
+        }});
+
+    run(server.baseUrl(), requests, false, false);
+    run(server.baseUrl(), requests, true, false);
+    run(server.baseUrl(), requests, false, true);
+    return iris::test::result();
+}
@@ -0,0 +1,142 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/balance_ledger.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// The ledger seeds from the server, applies each update once, moves with
+// gives and trades, reports drift, skips a reconcile that overlapped an
+// event, and never shows a torn snapshot.
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct FakeBalance {
+    std::mutex mutex;
+    std::string body = R"({"gold":12,"sweets":100.5,"donate_score":40})";
+    std::atomic<bool> slow{false};
+
+    void handle(std::string_view target, std::string& out) {
+        if (target.find("/balance") == std::string_view::npos) {
+            out = R"({"result":1})";
+            return;
+        }
+        if (slow) {
+            std::this_thread::sleep_for(200ms);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        out = body;
+    }
+
+    void set(const std::string& balance) {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = balance;
+    }
+};
+
+iris::UpdatesLog update(long id, const std::string& type, int amount) {
+    return iris::UpdatesLog{id, type, 1, amount, std::nullopt, 1700000000};
+}
+
+} // namespace
+
+int main() {
+    FakeBalance server;
+    iris::bench::MockServer mock([&](std::string_view target, std::string& body) { server.handle(target, body); });
+    iris::IrisApi api(1, "token", mock.baseUrl());
+    iris::BalanceLedger ledger(api);
+
+    // The first reconcile seeds and reports no drift.
+    IRIS_CHECK(!ledger.seeded());
+    auto drift = ledger.reconcile();
+    IRIS_CHECK(drift && drift->empty());
+    IRIS_CHECK(ledger.seeded());
+    IRIS_CHECK_EQ(ledger.gold(), 12);
+    IRIS_CHECK(ledger.sweets() == 100.5);
+    IRIS_CHECK_EQ(ledger.donateScore(), 40);
+
+    // Each update_id counts once; ids at or below the last are ignored.
+    ledger.applyUpdate(update(5, "sweets_log", 10));
+    ledger.applyUpdate(update(5, "sweets_log", 10));
+    ledger.applyUpdate(update(4, "gold_log", 10));
+    ledger.applyUpdate(update(6, "something_else", 99));
+    ledger.applyUpdate(update(7, "gold_log", 3));
+    IRIS_CHECK(ledger.sweets() == 110.5);
+    IRIS_CHECK_EQ(ledger.gold(), 15);
+    IRIS_CHECK_EQ(ledger.stats().duplicates, uint64_t{2});
+    IRIS_CHECK_EQ(ledger.stats().applied, uint64_t{2});
+
+    // Trades move gold one way and sweets the other.
+    ledger.applyBuy(iris::BuyTradesResponse{2, 1.5, std::nullopt});
+    IRIS_CHECK_EQ(ledger.gold(), 17);
+    IRIS_CHECK(ledger.sweets() == 109.0);
+    ledger.applySell(iris::SellTradesResponse{1, 0.75, std::nullopt});
+    IRIS_CHECK_EQ(ledger.gold(), 16);
+    IRIS_CHECK(ledger.sweets() == 109.75);
+
+    // A rejected give leaves the ledger alone, a successful one debits.
+    ledger.applyGive(iris::Currency::SWEETS, 5, iris::Response{0, iris::APIError{1, "no"}});
+    IRIS_CHECK(ledger.sweets() == 109.75);
+    IRIS_CHECK(ledger.giveSweets(10, 42).has_value());
+    IRIS_CHECK(ledger.sweets() == 99.75);
+    IRIS_CHECK(ledger.covers(iris::Currency::SWEETS, 99.75));
+    IRIS_CHECK(!ledger.covers(iris::Currency::SWEETS, 100));
+
+    server.set(R"({"gold":16,"sweets":99.75,"donate_score":40})");
+    drift = ledger.reconcile();
+    IRIS_CHECK(drift && drift->empty());
+
+    server.set(R"({"gold":20,"sweets":99.75,"donate_score":38})");
+    drift = ledger.reconcile();
+    IRIS_CHECK(drift && drift->gold == 4 && drift->sweets == 0 && drift->donateScore == -2);
+    IRIS_CHECK_EQ(ledger.gold(), 20);
+    IRIS_CHECK_EQ(ledger.donateScore(), 38);
+    IRIS_CHECK_EQ(ledger.stats().reconciles, uint64_t{3});
+    IRIS_CHECK_EQ(ledger.stats().drifts, uint64_t{1});
+
+    // An event applied while getBalance is in flight makes the answer
+    // ambiguous: the reconcile is skipped and the event stands.
+    server.slow = true;
+    auto overlapped = std::async(std::launch::async, [&] { return ledger.reconcile(); });
+    std::this_thread::sleep_for(50ms);
+    ledger.applyUpdate(update(8, "sweets_log", 1));
+    IRIS_CHECK(!overlapped.get().has_value());
+    server.slow = false;
+    IRIS_CHECK_EQ(ledger.stats().skipped, uint64_t{1});
+    IRIS_CHECK(ledger.sweets() == 100.75);
+
+    // Seqlock: readers never see the fields of two different writes.
+    {
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+        std::thread writer([&] {
+            for (int i = 0; i < 200000; ++i) {
+                ledger.applyBalance(iris::BalanceData{i, static_cast<double>(i), i});
+            }
+            done = true;
+        });
+        auto read = [&] {
+            while (!done) {
+                iris::BalanceData balance = ledger.snapshot();
+                if (balance.gold != balance.donate_score || balance.sweets != balance.gold) {
+                    ++torn;
+                }
+            }
+        };
+        std::thread reader1(read);
+        std::thread reader2(read);
+        writer.join();
+        reader1.join();
+        reader2.join();
+        IRIS_CHECK_EQ(torn.load(), 0);
+        iris::BalanceData last = ledger.snapshot();
+        IRIS_CHECK_EQ(last.gold, 199999);
+    }
+
+    return iris::test::result();
+}
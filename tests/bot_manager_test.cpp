@@ -0,0 +1,45 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/bot_manager.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+// removeBot() drops the bot's queued requests even while a caller still
+// holds its client, so they neither go out nor wait on the shared budget.
+
+int main() {
+    using namespace std::chrono_literals;
+
+    std::atomic<int> requests{0};
+    iris::bench::MockServer server([&](std::string_view, std::string& body) {
+        requests.fetch_add(1);
+        std::this_thread::sleep_for(300ms);
+        body = "[]";
+    });
+
+    iris::BotManagerOptions options;
+    options.scheduler.ratePerSecond = 1000;
+    options.scheduler.burst = 1000;
+    options.scheduler.maxInFlight = 1;
+    iris::BotManager manager(options);
+    auto busy = manager.addBot(1, "token", {}, server.baseUrl());
+    auto removed = manager.addBot(2, "token", {}, server.baseUrl());
+
+    // The first bot holds the only slot; the second one's call waits.
+    auto first = busy->tryGetSweetsHistoryAsync();
+    std::this_thread::sleep_for(100ms);
+    auto queued = removed->tryGetSweetsHistoryAsync();
+    std::this_thread::sleep_for(50ms);
+
+    IRIS_CHECK(manager.removeBot(2));
+    IRIS_CHECK(queued.wait_for(100ms) == std::future_status::ready);
+    iris::Result<std::vector<iris::HistoryData>> dropped = queued.get();
+    IRIS_CHECK(!dropped && dropped.error().code == iris::ErrorCode::TRANSPORT);
+    IRIS_CHECK(first.get().ok());
+    IRIS_CHECK_EQ(requests.load(), 1);
+    IRIS_CHECK_EQ(manager.size(), size_t{1});
+
+    return iris::test::result();
+}
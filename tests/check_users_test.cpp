@@ -0,0 +1,82 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <string>
+#include <vector>
+
+// checkUsers() returns one row per requested id, in order, with every field
+// that failed to load left empty.
+
+namespace {
+
+int answer(std::string_view target, std::string& body) {
+    long userId = std::stol(std::string(target.substr(target.find("user_id=") + 8)));
+    std::string id = std::to_string(userId);
+    if (target.find("user_info/reg") != std::string_view::npos) {
+        body = R"({"timestamp":)" + std::to_string(1600000000 + userId) + "}";
+    } else if (target.find("user_info/spam") != std::string_view::npos) {
+        if (userId == 12) {
+            body = "Not Found";
+            return 404;
+        }
+        body = R"({"spam":)" + std::string(userId == 13 ? "true" : "false") + R"(,"ignore":false,"scam":false})";
+    } else if (target.find("user_info/activity") != std::string_view::npos) {
+        body = R"({"messages":)" + id + R"(,"characters":0,"forwarded":0,"replies":0,"mentions":0})";
+    } else if (target.find("user_info/stars") != std::string_view::npos) {
+        body = R"({"stars":)" + id + R"(,"rank":"r)" + id + R"("})";
+    } else {
+        if (userId == 13) {
+            body = "Not Found";
+            return 404;
+        }
+        if (userId == 14) {
+            body = "not json";
+            return 200;
+        }
+        body = R"({"gold":)" + id + R"(,"sweets":0.5,"donate_score":0})";
+    }
+    return 200;
+}
+
+} // namespace
+
+int main() {
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{answer});
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    std::vector<long> userIds{11, 12, 13, 14, 11};
+    std::vector<iris::UserInfoRow> rows = api.checkUsers(userIds, iris::UserInfoField::ALL, 3);
+    IRIS_CHECK_EQ(rows.size(), userIds.size());
+    if (rows.size() != userIds.size()) {
+        return iris::test::result();
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const iris::UserInfoRow& row = rows[i];
+        long userId = userIds[i];
+        IRIS_CHECK_EQ(row.userId, userId);
+        IRIS_CHECK(row.reg && row.reg->timestamp == 1600000000 + userId);
+        IRIS_CHECK(row.activity && row.activity->messages == userId);
+        IRIS_CHECK(row.stars && row.stars->stars == userId && row.stars->rank == "r" + std::to_string(userId));
+    }
+
+    IRIS_CHECK(rows[0].spam && !rows[0].spam->spam);
+    IRIS_CHECK(!rows[1].spam);
+    IRIS_CHECK(rows[2].spam && rows[2].spam->spam);
+    IRIS_CHECK(rows[3].spam && !rows[3].spam->spam);
+
+    IRIS_CHECK(rows[0].pocket && rows[0].pocket->gold == 11);
+    IRIS_CHECK(rows[1].pocket && rows[1].pocket->gold == 12);
+    IRIS_CHECK(!rows[2].pocket);
+    IRIS_CHECK(!rows[3].pocket);
+    IRIS_CHECK(rows[4].pocket && rows[4].pocket->gold == 11);
+
+    // Only the requested kinds are fetched.
+    rows = api.checkUsers({12}, iris::UserInfoField::REG | iris::UserInfoField::STARS);
+    IRIS_CHECK_EQ(rows.size(), size_t(1));
+    if (!rows.empty()) {
+        IRIS_CHECK(rows[0].reg && rows[0].stars);
+        IRIS_CHECK(!rows[0].spam && !rows[0].activity && !rows[0].pocket);
+    }
+    return iris::test::result();
+}
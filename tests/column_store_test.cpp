@@ -0,0 +1,66 @@
+#include "test_util.hpp"
+#include <iris/column_store.hpp>
+#include <filesystem>
+#include <stdexcept>
+
+// ColumnStore reopen and validation of the files against the header.
+
+namespace {
+
+const std::vector<iris::ColumnSpec> kColumns = {{"value", sizeof(int64_t)}, {"text", sizeof(iris::StringRef)}};
+
+void fill(const std::string& directory, size_t rows) {
+    iris::ColumnStore store(directory, 7, kColumns);
+    store.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        store.column<int64_t>(0)[i] = static_cast<int64_t>(i * 3);
+        store.column<iris::StringRef>(1)[i] = store.appendString("row " + std::to_string(i));
+    }
+    store.publish(rows, 42);
+    store.flush();
+}
+
+bool opens(const std::string& directory) {
+    try {
+        iris::ColumnStore store(directory, 7, kColumns);
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+} // namespace
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / "iriscpp_column_store_test";
+    fs::remove_all(directory);
+
+    fill(directory.string(), 3000);
+    {
+        iris::ColumnStore store(directory.string(), 7, kColumns);
+        IRIS_CHECK_EQ(store.size(), size_t{3000});
+        IRIS_CHECK_EQ(store.cursor(), int64_t{42});
+        IRIS_CHECK_EQ(store.column<int64_t>(0)[2999], int64_t{8997});
+        IRIS_CHECK(store.string(store.column<iris::StringRef>(1)[17]) == "row 17");
+    }
+
+    IRIS_CHECK(opens(directory.string()));
+    bool wrongKind = false;
+    try {
+        iris::ColumnStore store(directory.string(), 8, kColumns);
+    } catch (const std::runtime_error&) {
+        wrongKind = true;
+    }
+    IRIS_CHECK(wrongKind);
+
+    fs::resize_file(directory / "value.col", 2999 * sizeof(int64_t));
+    IRIS_CHECK(!opens(directory.string()));
+
+    fill((directory / "heap").string(), 10);
+    fs::resize_file(directory / "heap" / "strings.heap", 5);
+    IRIS_CHECK(!opens((directory / "heap").string()));
+
+    fs::remove_all(directory);
+    return iris::test::result();
+}
@@ -0,0 +1,106 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/exceptions.hpp>
+#include <iris/iris_api.hpp>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef IRIS_HAS_COROUTINES
+#error "coroutine_test needs a compiler with C++20 coroutines"
+#endif
+
+// co_await on an IrisApi Future: a pending request resumes the coroutine on
+// the thread that completed it, a ready one resumes it right away, and an
+// exception thrown after resumption reaches the coroutine's caller.
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Starts eagerly; the coroutine's value or exception lands in `outcome`.
+template <typename T>
+struct Task {
+    struct promise_type {
+        std::promise<T> result;
+
+        Task get_return_object() { return Task{result.get_future()}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_value(T value) { result.set_value(std::move(value)); }
+        void unhandled_exception() { result.set_exception(std::current_exception()); }
+    };
+
+    std::future<T> outcome;
+};
+
+struct Resumed {
+    std::optional<iris::BalanceData> balance;
+    std::thread::id thread;
+};
+
+Task<Resumed> awaitBalance(iris::Future<std::optional<iris::BalanceData>> future) {
+    std::optional<iris::BalanceData> balance = co_await future;
+    co_return Resumed{std::move(balance), std::this_thread::get_id()};
+}
+
+Task<size_t> awaitHistory(iris::IrisApi& api, int offset) {
+    iris::Result<std::vector<iris::HistoryData>> history = co_await api.tryGetSweetsHistoryAsync(offset);
+    co_return history.value().size();
+}
+
+int answer(std::string_view target, std::string& body) {
+    if (target.find("pocket/balance") != std::string_view::npos) {
+        // Slow enough that the coroutine is suspended before it arrives.
+        std::this_thread::sleep_for(50ms);
+        body = R"({"gold":3,"sweets":1.5,"donate_score":7})";
+        return 200;
+    }
+    if (target.find("offset=10") != std::string_view::npos) {
+        body = R"({"error":{"code":404,"description":"Not found"}})";
+        return 404;
+    }
+    body = R"([{"user_id":1,"type":"give","amount":5,"comment":null,"timestamp":1},)"
+           R"({"user_id":2,"type":"take","amount":6,"comment":"x","timestamp":2}])";
+    return 200;
+}
+
+} // namespace
+
+int main() {
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{answer});
+    iris::IrisApi api(1, "token", server.baseUrl());
+    std::thread::id caller = std::this_thread::get_id();
+
+    Task<Resumed> pending = awaitBalance(api.getBalanceAsync());
+    IRIS_CHECK(pending.outcome.wait_for(5s) == std::future_status::ready);
+    Resumed resumed = pending.outcome.get();
+    IRIS_CHECK(resumed.balance && resumed.balance->gold == 3 && resumed.balance->donate_score == 7);
+    IRIS_CHECK(resumed.thread != caller);
+
+    iris::Future<std::optional<iris::BalanceData>> ready = api.getBalanceAsync();
+    ready.wait();
+    Task<Resumed> immediate = awaitBalance(std::move(ready));
+    IRIS_CHECK(immediate.outcome.wait_for(0s) == std::future_status::ready);
+    resumed = immediate.outcome.get();
+    IRIS_CHECK(resumed.balance && resumed.balance->sweets == 1.5);
+    IRIS_CHECK(resumed.thread == caller);
+
+    Task<size_t> found = awaitHistory(api, 0);
+    IRIS_CHECK(found.outcome.wait_for(5s) == std::future_status::ready);
+    IRIS_CHECK_EQ(found.outcome.get(), size_t(2));
+
+    Task<size_t> missing = awaitHistory(api, 10);
+    IRIS_CHECK(missing.outcome.wait_for(5s) == std::future_status::ready);
+    bool threw = false;
+    try {
+        missing.outcome.get();
+    } catch (const iris::IrisApiException&) {
+        threw = true;
+    }
+    IRIS_CHECK(threw);
+    return iris::test::result();
+}
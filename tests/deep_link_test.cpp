@@ -0,0 +1,88 @@
+#include "test_util.hpp"
+#include <iris/deep_link.hpp>
+#include <iris/iris_api.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Links and validation messages stay exactly what the stringstream and
+// std::regex implementation produced.
+
+namespace {
+
+std::string rejection(iris::IrisApi& api, int count, const std::string& comment) {
+    try {
+        api.generateDeepLink(iris::Currency::SWEETS, count, comment);
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return {};
+}
+
+} // namespace
+
+int main() {
+    using iris::Currency;
+
+    iris::IrisApi api(123456, "token");
+
+    IRIS_CHECK(api.generateDeepLink(Currency::SWEETS, 10)
+               == "https://t.me/iris_black_bot?start=give_bot123456_10");
+    IRIS_CHECK(api.generateDeepLink(Currency::GOLD, 1, "Prize_2024")
+               == "https://t.me/iris_black_bot?start=givegold_bot123456_1_Prize_2024");
+    IRIS_CHECK(api.generateDeepLink(Currency::DONATE_SCORE, 2147483647, "")
+               == "https://t.me/iris_black_bot?start=givedonate_score_bot123456_2147483647");
+    IRIS_CHECK(api.generateDeepLink(Currency::SWEETS, 5, std::string(128, 'z'))
+               == "https://t.me/iris_black_bot?start=give_bot123456_5_" + std::string(128, 'z'));
+
+    IRIS_CHECK(api.generateBotPermissionsDeepLink({})
+               == "https://t.me/iris_black_bot?start=request_rights_123456");
+    IRIS_CHECK(api.generateBotPermissionsDeepLink({iris::BotPermission::REG, iris::BotPermission::ACTIVITY,
+                                                   iris::BotPermission::SPAM, iris::BotPermission::STARS,
+                                                   iris::BotPermission::POCKET})
+               == "https://t.me/iris_black_bot?start=request_rights_123456_reg_activity_spam_stars_pocket");
+
+    const std::string positive = "Count must be positive";
+    const std::string tooLong = "Comment must not exceed 128 characters";
+    const std::string badChars = "Comment can only contain letters, numbers and underscore";
+    IRIS_CHECK(rejection(api, 0, "") == positive);
+    IRIS_CHECK(rejection(api, -3, "ok") == positive);
+    IRIS_CHECK(rejection(api, 1, std::string(129, 'a')) == tooLong);
+    IRIS_CHECK(rejection(api, 1, "with space") == badChars);
+    IRIS_CHECK(rejection(api, 1, "dash-") == badChars);
+    IRIS_CHECK(rejection(api, 1, "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb7") == badChars);
+    IRIS_CHECK(rejection(api, 1, std::string("a\0b", 3)) == badChars);
+    IRIS_CHECK(rejection(api, 1, "\xff") == badChars);
+
+    iris::DeepLinks none = api.generateDeepLinks({});
+    IRIS_CHECK(none.empty());
+    IRIS_CHECK_EQ(none.size(), size_t{0});
+    IRIS_CHECK(none.buffer().empty());
+
+    iris::DeepLinks links = api.generateDeepLinks(
+        {{Currency::SWEETS, 10, ""}, {Currency::GOLD, 7, "a_b"}, {Currency::DONATE_SCORE, 300, "X"}});
+    std::vector<std::string> expected{
+        "https://t.me/iris_black_bot?start=give_bot123456_10",
+        "https://t.me/iris_black_bot?start=givegold_bot123456_7_a_b",
+        "https://t.me/iris_black_bot?start=givedonate_score_bot123456_300_X",
+    };
+    IRIS_CHECK_EQ(links.size(), expected.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < expected.size() && i < links.size(); ++i) {
+        IRIS_CHECK(links[i] == expected[i]);
+        IRIS_CHECK_EQ(links.offset(i), offset);
+        offset += expected[i].size();
+    }
+    IRIS_CHECK_EQ(links.offset(links.size()), offset);
+    IRIS_CHECK(links.buffer() == expected[0] + expected[1] + expected[2]);
+
+    std::string bulkError;
+    try {
+        api.generateDeepLinks({{Currency::SWEETS, 1, ""}, {Currency::SWEETS, 0, ""}});
+    } catch (const std::invalid_argument& e) {
+        bulkError = e.what();
+    }
+    IRIS_CHECK(bulkError == "Deep link 1: " + positive);
+
+    return iris::test::result();
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace iris {
+namespace test {
+
+// Trade endpoints for MockServer. Buys at 1.0 and above and sells at 0.2 and
+// below fill at once; other orders rest. Price 0.33 is refused. Orders can
+// also be filled or placed "by someone else" to produce drift.
+class FakeExchange {
+public:
+    void handle(std::string_view target, std::string& body) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (target.find("trade/my_orders") != std::string_view::npos) {
+            body = "{\"buy\":" + list(true) + ",\"sell\":" + list(false) + "}";
+            return;
+        }
+        if (target.find("trade/cancel_all") != std::string_view::npos) {
+            cancel([](const Order&) { return true; }, body);
+            return;
+        }
+        if (target.find("trade/cancel_part") != std::string_view::npos) {
+            int id = std::stoi(queryValue(target, "id"));
+            int volume = std::stoi(queryValue(target, "volume"));
+            auto it = orders_.find(id);
+            int cancelled = it == orders_.end() ? 0 : std::min(volume, it->second.volume);
+            bool whole = it != orders_.end() && cancelled == it->second.volume;
+            if (whole) {
+                orders_.erase(it);
+            } else if (it != orders_.end()) {
+                it->second.volume -= cancelled;
+            }
+            body = "{\"cancelled_orders\":[" + (whole ? std::to_string(id) : std::string()) + "],"
+                + "\"cancelled_volume\":" + std::to_string(cancelled) + "}";
+            return;
+        }
+        std::string priceText = queryValue(target, "price");
+        double price = std::stod(priceText);
+        if (target.find("trade/cancel_price") != std::string_view::npos) {
+            cancel([&](const Order& order) { return key(order.price) == key(price); }, body);
+            return;
+        }
+        if (key(price) == key(0.33)) {
+            body = R"({"error":{"code":3,"description":"Bad price"}})";
+            return;
+        }
+        bool buy = target.find("trade/buy") != std::string_view::npos;
+        int volume = std::stoi(queryValue(target, "volume"));
+        bool fills = buy ? price >= 1.0 : price <= 0.2;
+        body = "{\"done_volume\":" + std::to_string(fills ? volume : 0) + ","
+            + (buy ? "\"sweets_spent\":" : "\"sweets_earned\":") + std::to_string(fills ? price * volume : 0.0)
+            + ",\"new_order\":";
+        if (fills) {
+            body += "null}";
+            return;
+        }
+        int id = nextId_++;
+        orders_[id] = Order{buy, price, volume};
+        body += "{\"id\":" + std::to_string(id) + ",\"volume\":" + std::to_string(volume) + ",\"price\":"
+            + priceText + "}}";
+    }
+
+    int resting(double price) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int volume = 0;
+        for (const auto& entry : orders_) {
+            if (key(entry.second.price) == key(price)) {
+                volume += entry.second.volume;
+            }
+        }
+        return volume;
+    }
+
+    // Another trader takes `volume` off order `id`.
+    void fill(int id, int volume) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = orders_.find(id);
+        if (it != orders_.end() && (it->second.volume -= volume) <= 0) {
+            orders_.erase(it);
+        }
+    }
+
+    // An order placed outside the client under test; returns its id.
+    int place(bool buy, double price, int volume) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        orders_[nextId_] = Order{buy, price, volume};
+        return nextId_++;
+    }
+
+private:
+    struct Order {
+        bool buy;
+        double price;
+        int volume;
+    };
+
+    static long long key(double price) {
+        return std::llround(price * 1e6);
+    }
+
+    static std::string queryValue(std::string_view target, std::string_view name) {
+        size_t at = target.find(std::string(name) + "=");
+        if (at == std::string_view::npos) {
+            return {};
+        }
+        at += name.size() + 1;
+        return std::string(target.substr(at, target.find('&', at) - at));
+    }
+
+    std::string list(bool buy) const {
+        std::string out = "[";
+        for (const auto& entry : orders_) {
+            if (entry.second.buy != buy) {
+                continue;
+            }
+            if (out.size() > 1) {
+                out += ",";
+            }
+            out += "{\"id\":" + std::to_string(entry.first) + ",\"volume\":"
+                + std::to_string(entry.second.volume) + ",\"price\":" + std::to_string(entry.second.price) + "}";
+        }
+        return out + "]";
+    }
+
+    template <typename Match>
+    void cancel(Match match, std::string& body) {
+        std::string ids;
+        int volume = 0;
+        for (auto it = orders_.begin(); it != orders_.end();) {
+            if (!match(it->second)) {
+                ++it;
+                continue;
+            }
+            ids += (ids.empty() ? "" : ",") + std::to_string(it->first);
+            volume += it->second.volume;
+            it = orders_.erase(it);
+        }
+        body = "{\"cancelled_orders\":[" + ids + "],\"cancelled_volume\":" + std::to_string(volume) + "}";
+    }
+
+    std::mutex mutex_;
+    std::map<int, Order> orders_;
+    int nextId_ = 1;
+};
+
+} // namespace test
+} // namespace iris
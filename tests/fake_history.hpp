@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iris/models.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iris {
+namespace test {
+
+// Finite pocket history for MockServer: serves `records` newest first in
+// pages of kPageSize by the `offset` query value. The page at `failOffset`
+// answers 500. Records can be added while the server runs.
+struct FakeHistory {
+    static constexpr size_t kPageSize = 25;
+
+    std::mutex mutex;
+    std::vector<HistoryData> records;
+    long failOffset = -1;
+    size_t requests = 0;
+
+    void add(long timestamp, int amount) {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.insert(records.begin(), HistoryData{100000 + amount, "give", amount,
+            amount % 2 ? std::optional<std::string>("payout " + std::to_string(amount)) : std::nullopt,
+            timestamp});
+    }
+
+    int handle(std::string_view target, std::string& body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++requests;
+        size_t offset = 0;
+        size_t at = target.find("offset=");
+        if (at != std::string_view::npos) {
+            offset = std::stoul(std::string(target.substr(at + 7)));
+        }
+        if (static_cast<long>(offset) == failOffset) {
+            body = R"({"error":"unavailable"})";
+            return 500;
+        }
+        body = "[";
+        for (size_t i = offset; i < records.size() && i < offset + kPageSize; ++i) {
+            const HistoryData& record = records[i];
+            if (i > offset) body += ',';
+            body += R"({"user_id":)" + std::to_string(record.user_id) + R"(,"type":")" + record.type
+                + R"(","amount":)" + std::to_string(record.amount) + R"(,"comment":)"
+                + (record.comment ? '"' + *record.comment + '"' : std::string("null"))
+                + R"(,"timestamp":)" + std::to_string(record.timestamp) + "}";
+        }
+        body += "]";
+        return 200;
+    }
+};
+
+} // namespace test
+} // namespace iris
@@ -0,0 +1,62 @@
+#include "fake_history.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/history_range.hpp>
+#include <iris/iris_api.hpp>
+
+// HistoryRange walks every page in order, stops on stopWhen, and reports a
+// failed page instead of ending as if the history were complete.
+
+int main() {
+    iris::test::FakeHistory history;
+    for (int i = 0; i < 80; ++i) {
+        history.add(1700000000 + i, i + 1);
+    }
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{
+        [&](std::string_view target, std::string& body) { return history.handle(target, body); }});
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    {
+        iris::HistoryRange range(api, iris::Currency::SWEETS);
+        long expected = 1700000079;
+        size_t count = 0;
+        for (const iris::HistoryData& record : range) {
+            IRIS_CHECK_EQ(record.timestamp, expected);
+            --expected;
+            ++count;
+        }
+        IRIS_CHECK_EQ(count, size_t{80});
+        IRIS_CHECK(!range.failed());
+        IRIS_CHECK_EQ(range.pagesFetched(), size_t{4});
+        IRIS_CHECK_EQ(range.pageSize(), iris::test::FakeHistory::kPageSize);
+    }
+
+    {
+        iris::HistoryRangeOptions options;
+        options.stopWhen = [](const iris::HistoryData& record) { return record.timestamp < 1700000050; };
+        iris::HistoryRange range(api, iris::Currency::GOLD, options);
+        size_t count = 0;
+        for (auto it = range.begin(); it != range.end(); ++it) {
+            ++count;
+        }
+        IRIS_CHECK_EQ(count, size_t{30});
+        IRIS_CHECK(!range.failed());
+    }
+
+    {
+        history.failOffset = 50;
+        iris::HistoryRange range(api, iris::Currency::SWEETS);
+        size_t count = 0;
+        for (const iris::HistoryData& record : range) {
+            (void)record;
+            ++count;
+        }
+        IRIS_CHECK_EQ(count, size_t{50});
+        IRIS_CHECK(range.failed());
+        IRIS_CHECK(range.error().code == iris::ErrorCode::HTTP_5XX);
+        IRIS_CHECK_EQ(range.error().httpCode, 500L);
+        IRIS_CHECK_EQ(range.offset(), 50);
+    }
+
+    return iris::test::result();
+}
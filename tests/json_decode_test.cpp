@@ -0,0 +1,78 @@
+#include "mock_iris.hpp"
+#include "test_util.hpp"
+#include <iris/json_decode.hpp>
+#include <string>
+#include <vector>
+
+// tryDecodeJson decodes what json::parse + get<T> does, skips unknown keys,
+// accepts absent or null optionals and rejects what get<T> would throw on.
+
+namespace {
+
+template <typename T>
+bool matchesDom(const std::string& body) {
+    T decoded{};
+    std::string error;
+    if (!iris::tryDecodeJson(body, decoded, error)) {
+        return false;
+    }
+    return nlohmann::json(decoded) == nlohmann::json(nlohmann::json::parse(body).get<T>());
+}
+
+template <typename T>
+bool rejects(const std::string& body) {
+    T decoded{};
+    std::string error;
+    return !iris::tryDecodeJson(body, decoded, error) && !error.empty();
+}
+
+} // namespace
+
+int main() {
+    IRIS_CHECK(matchesDom<std::vector<iris::HistoryData>>(iris::bench::makeHistoryPage(200)));
+    IRIS_CHECK(matchesDom<std::vector<iris::UpdatesLog>>(iris::bench::makeUpdatesPage(200)));
+    IRIS_CHECK(matchesDom<std::vector<iris::HistoryData>>("[]"));
+    IRIS_CHECK(matchesDom<std::vector<iris::HistoryData>>(
+        R"([{"user_id":1,"type":"give","amount":-5,"comment":"п\"x\"\n","timestamp":1700000000}])"));
+    IRIS_CHECK(matchesDom<iris::BalanceData>(R"({"gold":12,"sweets":1534.25,"donate_score":40})"));
+    IRIS_CHECK(matchesDom<iris::UserActivityInfo>(
+        R"({"messages":1,"characters":2,"forwarded":3,"replies":4,"mentions":5})"));
+    IRIS_CHECK(matchesDom<iris::BuyTradesResponse>(
+        R"({"done_volume":3,"sweets_spent":1.5,"new_order":{"id":7,"volume":2,"price":0.75}})"));
+    IRIS_CHECK(matchesDom<iris::BuyTradesResponse>(R"({"done_volume":3,"sweets_spent":1.5,"new_order":null})"));
+    IRIS_CHECK(matchesDom<iris::OrdersResponse>(
+        R"({"buy":[{"id":1,"volume":2,"price":0.5}],"sell":[{"id":2,"volume":1,"price":0.6}]})"));
+    IRIS_CHECK(matchesDom<iris::CancelTradesResponse>(R"({"cancelled_orders":[1,2,3],"cancelled_volume":9})"));
+    IRIS_CHECK(matchesDom<std::vector<long>>("[1,2,6000000000]"));
+
+    // Unknown keys, nested ones included, are skipped; optionals may be absent.
+    {
+        std::vector<iris::HistoryData> records;
+        std::string error;
+        IRIS_CHECK(iris::tryDecodeJson(
+            R"([{"extra":{"a":[1,{"b":null}]},"user_id":1,"type":"give","amount":2,"timestamp":3,"more":"x"}])",
+            records, error));
+        IRIS_CHECK_EQ(records.size(), size_t{1});
+        IRIS_CHECK(records.size() == 1 && records[0].user_id == 1 && !records[0].comment
+                   && records[0].timestamp == 3);
+    }
+
+    IRIS_CHECK(rejects<std::vector<iris::HistoryData>>(R"([{"user_id":1,"type":"give","amount":2}])"));
+    IRIS_CHECK(rejects<std::vector<iris::HistoryData>>(
+        R"([{"user_id":"1","type":"give","amount":2,"comment":null,"timestamp":3}])"));
+    IRIS_CHECK(rejects<std::vector<iris::HistoryData>>(R"({"error":{"code":1,"description":"x"}})"));
+    IRIS_CHECK(rejects<std::vector<iris::HistoryData>>(R"([{"user_id":1,)"));
+    IRIS_CHECK(rejects<iris::BalanceData>(R"({"gold":null,"sweets":1,"donate_score":2})"));
+    IRIS_CHECK(rejects<iris::BalanceData>("[]"));
+
+    // A reused output holds only the latest decode.
+    {
+        std::vector<iris::HistoryData> records;
+        std::string error;
+        IRIS_CHECK(iris::tryDecodeJson(iris::bench::makeHistoryPage(50), records, error));
+        IRIS_CHECK(iris::tryDecodeJson(iris::bench::makeHistoryPage(3), records, error));
+        IRIS_CHECK_EQ(records.size(), size_t{3});
+    }
+
+    return iris::test::result();
+}
@@ -0,0 +1,67 @@
+#include "fake_exchange.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// Ladders against a small exchange: fills and resting orders are summed,
+// cancels merged, and a level at a price being replaced is only placed
+// once the old orders at that price are gone.
+
+int main() {
+    using iris::OrderSide;
+
+    iris::test::FakeExchange exchange;
+    iris::bench::MockServer server([&](std::string_view target, std::string& body) {
+        exchange.handle(target, body);
+    });
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    std::vector<iris::LadderLevel> levels{
+        {OrderSide::BUY, 0.5, 10}, {OrderSide::BUY, 0.6, 20}, {OrderSide::BUY, 1.5, 4},
+        {OrderSide::SELL, 0.9, 7}, {OrderSide::SELL, 0.1, 30}, {OrderSide::BUY, 0.33, 1}};
+    iris::LadderResult placed = api.placeLadder(levels, 2);
+
+    IRIS_CHECK_EQ(placed.fills.size(), levels.size());
+    IRIS_CHECK_EQ(placed.failed, size_t{1});
+    IRIS_CHECK(placed.fills.size() == levels.size() && !placed.fills[5].success);
+    IRIS_CHECK_EQ(placed.boughtVolume, 4);
+    IRIS_CHECK_EQ(placed.soldVolume, 30);
+    IRIS_CHECK(std::abs(placed.sweetsSpent - 6.0) < 1e-9);
+    IRIS_CHECK(std::abs(placed.sweetsEarned - 3.0) < 1e-9);
+    IRIS_CHECK_EQ(placed.orders.size(), size_t{3});
+    IRIS_CHECK_EQ(exchange.resting(0.5), 10);
+    IRIS_CHECK_EQ(exchange.resting(0.9), 7);
+
+    // Resting 0.5 and 0.6 are replaced; the new 0.5 must survive the cancel.
+    iris::ReplaceLadderResult replaced = api.replaceLadder(
+        {0.5, 0.6}, {{OrderSide::BUY, 0.5, 3}, {OrderSide::BUY, 0.4, 5}}, 8);
+    IRIS_CHECK(replaced.cancelled.failedPrices.empty());
+    IRIS_CHECK_EQ(replaced.cancelled.cancelled.cancelled_volume, 30);
+    IRIS_CHECK_EQ(replaced.cancelled.cancelled.cancelled_orders.size(), size_t{2});
+    IRIS_CHECK_EQ(replaced.placed.failed, size_t{0});
+    IRIS_CHECK_EQ(replaced.placed.orders.size(), size_t{2});
+    IRIS_CHECK_EQ(exchange.resting(0.5), 3);
+    IRIS_CHECK_EQ(exchange.resting(0.6), 0);
+    IRIS_CHECK_EQ(exchange.resting(0.4), 5);
+
+    iris::CancelLadderResult cancelled = api.cancelLadder({0.4, 0.5, 0.9, 0.7}, 3);
+    IRIS_CHECK(cancelled.failedPrices.empty());
+    IRIS_CHECK_EQ(cancelled.cancelled.cancelled_volume, 15);
+    IRIS_CHECK_EQ(cancelled.cancelled.cancelled_orders.size(), size_t{3});
+
+    // Nothing is sent when any level is invalid.
+    bool threw = false;
+    try {
+        api.placeLadder({{OrderSide::BUY, 0.8, 1}, {OrderSide::SELL, 0.8, 0}});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    IRIS_CHECK(threw);
+    IRIS_CHECK_EQ(exchange.resting(0.8), 0);
+
+    return iris::test::result();
+}
@@ -0,0 +1,89 @@
+#include "test_util.hpp"
+#include <iris/metrics.hpp>
+#include <string>
+
+// Histogram buckets tile the value range, percentiles come from them, and
+// the Prometheus export never counts a sample under a bound below it.
+
+namespace {
+
+uint64_t renderedBucket(const std::string& text, std::string_view path, std::string_view le) {
+    std::string key = "iris_request_duration_seconds_bucket{endpoint=\"" + std::string(path) + "\",le=\""
+        + std::string(le) + "\"} ";
+    size_t at = text.find(key);
+    if (at == std::string::npos) {
+        return ~uint64_t{0};
+    }
+    return std::stoull(text.substr(at + key.size()));
+}
+
+} // namespace
+
+int main() {
+    using iris::LatencyHistogram;
+
+    for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        IRIS_CHECK(LatencyHistogram::bucketLow(i) <= LatencyHistogram::bucketHigh(i));
+        IRIS_CHECK_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketLow(i)), i);
+        IRIS_CHECK_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketHigh(i)), i);
+        if (i + 1 < LatencyHistogram::kBucketCount) {
+            IRIS_CHECK_EQ(LatencyHistogram::bucketHigh(i) + 1, LatencyHistogram::bucketLow(i + 1));
+        }
+    }
+    IRIS_CHECK_EQ(LatencyHistogram::bucketHigh(LatencyHistogram::kBucketCount - 1), LatencyHistogram::kMaxValue);
+    IRIS_CHECK_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::kMaxValue + 1000),
+                  LatencyHistogram::kBucketCount - 1);
+    for (uint64_t value : {uint64_t{0}, uint64_t{31}, uint64_t{32}, uint64_t{100}, uint64_t{5100},
+                           uint64_t{123456789}}) {
+        size_t index = LatencyHistogram::bucketIndex(value);
+        IRIS_CHECK(LatencyHistogram::bucketLow(index) <= value && value <= LatencyHistogram::bucketHigh(index));
+    }
+
+    {
+        // Exact below 32us.
+        LatencyHistogram histogram;
+        for (uint64_t value = 0; value < 32; ++value) {
+            histogram.record(value);
+        }
+        iris::HistogramSnapshot snapshot = histogram.snapshot();
+        IRIS_CHECK_EQ(snapshot.count, uint64_t{32});
+        IRIS_CHECK_EQ(snapshot.sum, uint64_t{496});
+        IRIS_CHECK_EQ(snapshot.percentile(0.5), uint64_t{15});
+        IRIS_CHECK_EQ(snapshot.percentile(0.0), uint64_t{0});
+        IRIS_CHECK_EQ(snapshot.percentile(1.0), uint64_t{31});
+        IRIS_CHECK_EQ(iris::HistogramSnapshot{}.percentile(0.5), uint64_t{0});
+    }
+    {
+        // Above that, a percentile is its bucket's high edge, capped by max.
+        LatencyHistogram histogram;
+        histogram.record(100);
+        histogram.record(5100);
+        iris::HistogramSnapshot snapshot = histogram.snapshot();
+        IRIS_CHECK_EQ(snapshot.percentile(0.5), LatencyHistogram::bucketHigh(LatencyHistogram::bucketIndex(100)));
+        IRIS_CHECK_EQ(snapshot.percentile(0.99), uint64_t{5100});
+    }
+
+    // 5100us falls in a bucket that straddles 5ms: it belongs to le="0.01".
+    iris::Metrics metrics;
+    iris::HttpResponse response;
+    response.httpCode = 200;
+    for (int micros : {100, 5100, 20000, 2000000}) {
+        metrics.recordRequest(iris::EndpointId::BALANCE, response, std::chrono::microseconds(micros));
+    }
+    std::string text = metrics.prometheus();
+    std::string_view path = metrics.snapshot(iris::EndpointId::BALANCE).path;
+    IRIS_CHECK_EQ(renderedBucket(text, path, "0.0005"), uint64_t{1});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "0.0025"), uint64_t{1});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "0.005"), uint64_t{1});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "0.01"), uint64_t{2});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "0.025"), uint64_t{3});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "1"), uint64_t{3});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "2.5"), uint64_t{4});
+    IRIS_CHECK_EQ(renderedBucket(text, path, "+Inf"), uint64_t{4});
+    IRIS_CHECK(text.find("iris_request_duration_seconds_count{endpoint=\"" + std::string(path) + "\"} 4\n")
+               != std::string::npos);
+    IRIS_CHECK(text.find("iris_requests_total{endpoint=\"" + std::string(path) + "\",outcome=\"none\"} 4\n")
+               != std::string::npos);
+
+    return iris::test::result();
+}
@@ -0,0 +1,104 @@
+#include "fake_exchange.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/order_book.hpp>
+#include <vector>
+
+// The mirror's levels and totals follow rests, partial and full cancels and
+// re-inserted ids, and reconcile() counts what changed behind its back.
+
+namespace {
+
+bool sameLevels(const std::vector<iris::PriceLevel>& levels, const std::vector<iris::PriceLevel>& expected) {
+    if (levels.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].price != expected[i].price || levels[i].volume != expected[i].volume
+            || levels[i].orders != expected[i].orders) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    using iris::OrderSide;
+
+    iris::test::FakeExchange exchange;
+    iris::bench::MockServer server([&](std::string_view target, std::string& body) {
+        exchange.handle(target, body);
+    });
+    iris::IrisApi api(1, "token", server.baseUrl());
+    iris::OrderBook book(api);
+
+    IRIS_CHECK(book.buy(0.5, 10).has_value());   // id 1
+    IRIS_CHECK(book.buy(0.5, 5).has_value());    // id 2
+    IRIS_CHECK(book.sell(0.9, 7).has_value());   // id 3
+    IRIS_CHECK(book.buy(1.5, 4).has_value());    // fills, nothing rests
+    IRIS_CHECK(book.buy(0.4, 3).has_value());    // id 4
+    IRIS_CHECK_EQ(book.size(), size_t{4});
+    IRIS_CHECK_EQ(book.volumeAt(OrderSide::BUY, 0.5), 15);
+    IRIS_CHECK_EQ(book.volumeAt(OrderSide::BUY, 1.5), 0);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 18);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::SELL), 7);
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.5, 15, 2}, {0.4, 3, 1}}));
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::SELL), {{0.9, 7, 1}}));
+    IRIS_CHECK(book.bestPrice(OrderSide::BUY) == 0.5);
+
+    // Partial cancel resizes the order and its level.
+    IRIS_CHECK(book.cancelPart(1, 4).has_value());
+    IRIS_CHECK(book.order(1) && book.order(1)->volume == 6);
+    IRIS_CHECK_EQ(book.volumeAt(OrderSide::BUY, 0.5), 11);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 14);
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.5, 11, 2}, {0.4, 3, 1}}));
+
+    // Cancelling all of an order removes it.
+    IRIS_CHECK(book.cancelPart(2, 5).has_value());
+    IRIS_CHECK(!book.order(2));
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.5, 6, 1}, {0.4, 3, 1}}));
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 9);
+
+    // An id seen again replaces the old order instead of adding to it.
+    iris::BuyTradesResponse again{0, 0, iris::OrderBuyTradesResponse{4, 8, 0.4}};
+    book.applyBuy(again, 0.4);
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.5, 6, 1}, {0.4, 8, 1}}));
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 14);
+    IRIS_CHECK_EQ(book.size(), size_t{3});
+
+    // Behind the mirror's back: id 3 filled, id 1 partly filled, one order
+    // placed elsewhere; id 4 still has 3 on the server.
+    exchange.fill(3, 7);
+    exchange.fill(1, 2);
+    exchange.place(false, 0.8, 5);
+    std::optional<iris::OrderBookDrift> drift = book.reconcile();
+    IRIS_CHECK(drift.has_value());
+    if (drift) {
+        IRIS_CHECK_EQ(drift->missing, size_t{1});
+        IRIS_CHECK_EQ(drift->unknown, size_t{1});
+        IRIS_CHECK_EQ(drift->changed, size_t{2});
+    }
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.5, 4, 1}, {0.4, 3, 1}}));
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::SELL), {{0.8, 5, 1}}));
+    IRIS_CHECK_EQ(book.volumeAt(OrderSide::SELL, 0.9), 0);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 7);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::SELL), 5);
+
+    drift = book.reconcile();
+    IRIS_CHECK(drift && drift->empty());
+
+    IRIS_CHECK(book.cancelPrice(0.5).has_value());
+    IRIS_CHECK(sameLevels(book.levels(OrderSide::BUY), {{0.4, 3, 1}}));
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 3);
+
+    IRIS_CHECK(book.cancelAll().has_value());
+    IRIS_CHECK_EQ(book.size(), size_t{0});
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::BUY), 0);
+    IRIS_CHECK_EQ(book.totalVolume(OrderSide::SELL), 0);
+    IRIS_CHECK(book.levels(OrderSide::BUY).empty() && book.levels(OrderSide::SELL).empty());
+    IRIS_CHECK(book.reconcile() && book.reconcile()->empty());
+
+    return iris::test::result();
+}
@@ -0,0 +1,93 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Every failed payout item says why: a transport, HTTP or decode failure
+// keeps its Error just like an Iris rejection does. A batch whose items
+// complete synchronously does not nest one call per item.
+
+namespace {
+
+// Answers inside submit(), as a stopping scheduler does for its grants.
+class InlineTransport : public iris::Transport {
+public:
+    void perform(const iris::HttpRequest&, iris::HttpResponse& response) override {
+        response = iris::HttpResponse{};
+        response.httpCode = 200;
+        response.body = R"({"result":1})";
+    }
+    void submit(iris::HttpRequest request, Completion done) override {
+        iris::HttpResponse response;
+        perform(request, response);
+        done(std::move(response));
+    }
+};
+
+} // namespace
+
+int main() {
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{
+        [](std::string_view target, std::string& body) {
+            if (target.find("user_id=2&") != std::string_view::npos) {
+                body = R"({"error":{"code":7,"description":"Not enough sweets"}})";
+                return 200;
+            }
+            if (target.find("user_id=3&") != std::string_view::npos) {
+                body = "Not Found";
+                return 404;
+            }
+            if (target.find("user_id=4&") != std::string_view::npos) {
+                body = "not json";
+                return 200;
+            }
+            body = R"({"result":1})";
+            return 200;
+        }});
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    std::vector<iris::PayoutItem> items{{1, 10, ""}, {2, 10, ""}, {3, 10, ""}, {4, 10, ""}};
+    std::vector<iris::PayoutResult> results = api.giveSweetsBatch(items);
+    IRIS_CHECK_EQ(results.size(), items.size());
+    if (results.size() != items.size()) {
+        return iris::test::result();
+    }
+
+    IRIS_CHECK(results[0].success());
+    IRIS_CHECK(results[0].response && results[0].response->result == 1);
+    IRIS_CHECK(!results[0].error);
+
+    IRIS_CHECK(!results[1].success());
+    IRIS_CHECK_EQ(results[1].errorCode, 7);
+    IRIS_CHECK(results[1].error && results[1].error->code == iris::ErrorCode::API);
+    IRIS_CHECK(results[1].error && results[1].error->apiError
+               && results[1].error->apiError->description == "Not enough sweets");
+
+    IRIS_CHECK(!results[2].success());
+    IRIS_CHECK(results[2].error && results[2].error->code == iris::ErrorCode::HTTP_4XX);
+    IRIS_CHECK(results[2].error && results[2].error->httpCode == 404);
+    IRIS_CHECK(results[2].error && !results[2].error->message().empty());
+
+    IRIS_CHECK(!results[3].success());
+    IRIS_CHECK(results[3].error && results[3].error->code == iris::ErrorCode::DECODE);
+    IRIS_CHECK(results[3].error && !results[3].error->detail.empty());
+
+    // Deep enough to overflow the stack if each item started the next one
+    // from inside its own completion.
+    {
+        iris::IrisApi inlineApi(1, "token", server.baseUrl());
+        inlineApi.setTransport(std::make_shared<InlineTransport>());
+        std::vector<iris::PayoutItem> many(200000, iris::PayoutItem{1, 10, ""});
+        std::vector<iris::PayoutResult> manyResults = inlineApi.giveSweetsBatch(many, {8, true});
+        IRIS_CHECK_EQ(manyResults.size(), many.size());
+        size_t succeeded = 0;
+        for (const iris::PayoutResult& result : manyResults) {
+            succeeded += result.success() ? 1 : 0;
+        }
+        IRIS_CHECK_EQ(succeeded, many.size());
+    }
+
+    return iris::test::result();
+}
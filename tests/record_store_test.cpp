@@ -0,0 +1,77 @@
+#include "fake_history.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/record_store.hpp>
+#include <filesystem>
+
+// HistoryStore against a finite, paginated history: full and incremental
+// syncs, reopening, and a page failing mid-scan.
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / "iriscpp_record_store_test";
+    fs::remove_all(directory);
+
+    iris::test::FakeHistory history;
+    for (int i = 0; i < 60; ++i) {
+        history.add(1700000000 + i, i + 1);
+    }
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{
+        [&](std::string_view target, std::string& body) { return history.handle(target, body); }});
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    {
+        iris::HistoryStore store(directory.string(), iris::Currency::SWEETS);
+        IRIS_CHECK_EQ(store.sync(api), size_t{60});
+        IRIS_CHECK_EQ(store.size(), size_t{60});
+        IRIS_CHECK_EQ(store.lastTimestamp(), 1700000059L);
+        IRIS_CHECK_EQ(store.amounts()[0], 1);
+        IRIS_CHECK(store.record(0).comment == std::optional<std::string>("payout 1"));
+        IRIS_CHECK(!store.record(1).comment);
+
+        // Two new records, one sharing the last stored second: only the
+        // first page is needed and nothing is stored twice.
+        history.add(1700000059, 500);
+        history.add(1700000060, 501);
+        history.requests = 0;
+        IRIS_CHECK_EQ(store.sync(api), size_t{2});
+        IRIS_CHECK_EQ(history.requests, size_t{1});
+        IRIS_CHECK_EQ(store.size(), size_t{62});
+        IRIS_CHECK_EQ(store.amounts()[61], 501);
+
+        IRIS_CHECK_EQ(store.sync(api), size_t{0});
+        store.flush();
+    }
+
+    {
+        iris::HistoryStore store(directory.string(), iris::Currency::SWEETS);
+        IRIS_CHECK_EQ(store.size(), size_t{62});
+        IRIS_CHECK_EQ(store.lastTimestamp(), 1700000060L);
+        IRIS_CHECK(store.type(0) == "give");
+
+        // The second page fails: nothing from the first page may be kept,
+        // and the next sync must still pick everything up.
+        for (int i = 0; i < 30; ++i) {
+            history.add(1700000100 + i, 600 + i);
+        }
+        history.failOffset = static_cast<long>(iris::test::FakeHistory::kPageSize);
+        bool threw = false;
+        try {
+            store.sync(api);
+        } catch (const iris::IrisApiException&) {
+            threw = true;
+        }
+        IRIS_CHECK(threw);
+        IRIS_CHECK_EQ(store.size(), size_t{62});
+        IRIS_CHECK_EQ(store.lastTimestamp(), 1700000060L);
+
+        history.failOffset = -1;
+        IRIS_CHECK_EQ(store.sync(api), size_t{30});
+        IRIS_CHECK_EQ(store.size(), size_t{92});
+        IRIS_CHECK_EQ(store.lastTimestamp(), 1700000129L);
+    }
+
+    fs::remove_all(directory);
+    return iris::test::result();
+}
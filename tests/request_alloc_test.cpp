@@ -0,0 +1,60 @@
+#include "bench_util.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+
+// The pooled blocking path must not touch the heap once warmed up: every
+// operator new left in a call has to come from decoding the body, which is
+// measured on its own and subtracted.
+
+namespace {
+
+constexpr std::string_view kBalance = R"({"gold":12,"sweets":1534.25,"donate_score":40})";
+constexpr std::string_view kGive = R"({"result":1})";
+constexpr size_t kIterations = 500;
+
+template <typename Fn>
+size_t allocationsPerCall(Fn&& fn) {
+    iris::bench::trackAllocations();
+    size_t before = iris::bench::allocations();
+    for (size_t i = 0; i < kIterations; ++i) {
+        fn();
+    }
+    size_t after = iris::bench::allocations();
+    iris::bench::trackAllocations(false);
+    return (after - before) / kIterations;
+}
+
+} // namespace
+
+int main() {
+    iris::bench::MockServer server([](std::string_view target, std::string& body) {
+        body.append(target.find("/balance") != std::string_view::npos ? kBalance : kGive);
+    });
+    iris::IrisApi api(1, "token", server.baseUrl());
+    const std::string comment = "test payout";
+
+    // Warm up: connections, pooled contexts and their buffers.
+    for (int i = 0; i < 50; ++i) {
+        IRIS_CHECK(api.tryGetBalance().ok());
+        IRIS_CHECK(api.tryGiveSweets(10, 42, comment).ok());
+    }
+
+    size_t balance = allocationsPerCall([&] { IRIS_CHECK(api.tryGetBalance().ok()); });
+    size_t balanceDecode = allocationsPerCall([&] {
+        std::optional<iris::BalanceData> decoded;
+        std::string error;
+        IRIS_CHECK(iris::tryDecodeResult(kBalance, decoded, error));
+    });
+    IRIS_CHECK_EQ(balance - balanceDecode, size_t{0});
+
+    size_t give = allocationsPerCall([&] { IRIS_CHECK(api.tryGiveSweets(10, 42, comment).ok()); });
+    size_t giveDecode = allocationsPerCall([&] {
+        std::optional<iris::Response> decoded;
+        std::string error;
+        IRIS_CHECK(iris::tryDecodeGiveResponse(kGive, decoded, error));
+    });
+    IRIS_CHECK_EQ(give - giveDecode, size_t{0});
+
+    return iris::test::result();
+}
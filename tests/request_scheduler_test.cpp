@@ -0,0 +1,58 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/request_scheduler.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <thread>
+
+// A blocking call whose queued request is dropped by cancel() must fail
+// without being sent and without handing back a slot it never held.
+
+int main() {
+    using namespace std::chrono_literals;
+
+    std::atomic<int> requests{0};
+    iris::bench::MockServer server([&](std::string_view, std::string& body) {
+        if (requests.fetch_add(1) == 0) {
+            std::this_thread::sleep_for(300ms);
+        }
+        body = R"({"gold":12,"sweets":1534.25,"donate_score":40})";
+    });
+
+    iris::SchedulerOptions options;
+    options.ratePerSecond = 1000;
+    options.burst = 1000;
+    options.maxInFlight = 1;
+    auto scheduler = std::make_shared<iris::RequestScheduler>(options);
+    iris::IrisApi api(1, "token", server.baseUrl());
+    api.setScheduler(scheduler);
+
+    // The first call holds the only slot; the second waits in the queue.
+    auto first = std::async(std::launch::async, [&] { return api.tryGetBalance().ok(); });
+    std::this_thread::sleep_for(100ms);
+    auto second = std::async(std::launch::async, [&] { return api.tryGetBalance(); });
+    std::this_thread::sleep_for(50ms);
+    scheduler->cancel(&api);
+
+    iris::Result<iris::BalanceData> dropped = second.get();
+    IRIS_CHECK(!dropped.ok());
+    IRIS_CHECK(!dropped && dropped.error().code == iris::ErrorCode::TRANSPORT);
+    IRIS_CHECK_EQ(requests.load(), 1);
+    IRIS_CHECK(first.get());
+
+    // The slot is back exactly once: further calls are granted.
+    auto third = std::async(std::launch::async, [&] { return api.tryGetBalance().ok(); });
+    IRIS_CHECK(third.wait_for(2s) == std::future_status::ready);
+    if (third.wait_for(0s) == std::future_status::ready) {
+        IRIS_CHECK(third.get());
+    } else {
+        // A leaked slot leaves the call queued forever; do not wait on it.
+        std::_Exit(iris::test::result());
+    }
+    IRIS_CHECK_EQ(requests.load(), 2);
+
+    return iris::test::result();
+}
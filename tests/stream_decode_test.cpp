@@ -0,0 +1,130 @@
+#include "bench_util.hpp"
+#include "mock_iris.hpp"
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/json_decode.hpp>
+#include <iris/metrics.hpp>
+#include <string>
+#include <vector>
+
+// ArrayStreamDecoder gives the same records however the body is cut, keeps
+// its buffers between chunks, and streamed calls report decode time and
+// decode failures to Metrics.
+
+namespace {
+
+using Decoder = iris::ArrayStreamDecoder<iris::HistoryData>;
+
+std::vector<iris::HistoryData> decodeWhole(const std::string& body) {
+    std::vector<iris::HistoryData> records;
+    std::string error;
+    IRIS_CHECK(iris::tryDecodeJson(body, records, error));
+    return records;
+}
+
+bool same(const iris::HistoryData& a, const iris::HistoryData& b) {
+    return a.user_id == b.user_id && a.type == b.type && a.amount == b.amount && a.comment == b.comment
+        && a.timestamp == b.timestamp;
+}
+
+void checkSplits(const std::string& body) {
+    std::vector<iris::HistoryData> expected = decodeWhole(body);
+    for (size_t cut = 0; cut <= body.size(); ++cut) {
+        std::vector<iris::HistoryData> records;
+        Decoder decoder([&](iris::HistoryData&& record) { records.push_back(std::move(record)); });
+        IRIS_CHECK(decoder.feed(std::string_view(body).substr(0, cut)));
+        IRIS_CHECK(decoder.feed(std::string_view(body).substr(cut)));
+        IRIS_CHECK(decoder.finish());
+        IRIS_CHECK_EQ(records.size(), expected.size());
+        for (size_t i = 0; i < records.size() && i < expected.size(); ++i) {
+            IRIS_CHECK(same(records[i], expected[i]));
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    checkSplits(iris::bench::makeHistoryPage(4));
+    checkSplits(R"( [ {"user_id":1,"type":"give","amount":2,"comment":"a \"}\\\" ] {","timestamp":3},)"
+                R"( {"user_id":4,"type":"x","amount":5,"comment":null,"timestamp":6} ] )");
+    checkSplits("[]");
+
+    {
+        Decoder decoder([](iris::HistoryData&&) {});
+        IRIS_CHECK(decoder.feed(R"({"error":{"code":5,"description":"no"}})"));
+        IRIS_CHECK(!decoder.finish());
+        IRIS_CHECK(decoder.rejected().find("description") != std::string::npos);
+    }
+    {
+        Decoder decoder([](iris::HistoryData&&) {});
+        decoder.feed(R"([{"user_id":1,"type":"give","amount":2,"comment":null,"timestamp":3},{"user_)");
+        IRIS_CHECK(!decoder.finish());
+    }
+
+    // Warm, the decoder reuses its batch and record buffers: what a chunk
+    // allocates is the parser's own setup, the same for 1 element or 64.
+    {
+        auto element = [](int i) {
+            return R"({"user_id":)" + std::to_string(100 + i)
+                + R"(,"type":"give","amount":1,"comment":null,"timestamp":1700000000},)";
+        };
+        std::string one = element(0);
+        std::string many;
+        for (int i = 0; i < 64; ++i) {
+            many += element(i);
+        }
+        size_t received = 0;
+        Decoder decoder([&](iris::HistoryData&&) { ++received; });
+        decoder.feed("[");
+        for (int i = 0; i < 4; ++i) {
+            decoder.feed(many);
+        }
+        auto allocationsPerFeed = [&](const std::string& chunk) {
+            iris::bench::trackAllocations();
+            size_t before = iris::bench::allocations();
+            for (int i = 0; i < 16; ++i) {
+                decoder.feed(chunk);
+            }
+            size_t allocated = iris::bench::allocations() - before;
+            iris::bench::trackAllocations(false);
+            return allocated / 16;
+        };
+        size_t perOne = allocationsPerFeed(one);
+        size_t perMany = allocationsPerFeed(many);
+        IRIS_CHECK_EQ(perMany, perOne);
+        IRIS_CHECK_EQ(received, size_t{20 * 64 + 16});
+        IRIS_CHECK(decoder.decodeTime().count() > 0);
+    }
+
+    // Streamed calls record decode time; a body the decoder aborts counts as
+    // a decode failure, not a transport one.
+    {
+        iris::bench::MockServer server([](std::string_view target, std::string& body) {
+            body = target.find("offset=") == std::string_view::npos
+                ? iris::bench::makeHistoryPage(500)
+                : R"([{"user_id":1,"type":"give","amount":"many","comment":null,"timestamp":3}])";
+        });
+        iris::IrisApi api(1, "token", server.baseUrl());
+        auto metrics = std::make_shared<iris::Metrics>();
+        api.setMetrics(metrics);
+
+        size_t streamed = 0;
+        auto ok = api.streamSweetsHistory(0, [&](iris::HistoryData&&) { ++streamed; });
+        IRIS_CHECK(ok.ok() && *ok == 500);
+        IRIS_CHECK_EQ(streamed, size_t{500});
+
+        auto bad = api.streamSweetsHistory(7, [](iris::HistoryData&&) {});
+        IRIS_CHECK(!bad && bad.error().code == iris::ErrorCode::DECODE);
+
+        auto snapshot = metrics->snapshot(iris::EndpointId::SWEETS_HISTORY);
+        IRIS_CHECK_EQ(snapshot.requests, uint64_t{2});
+        IRIS_CHECK_EQ(snapshot.decode.count, uint64_t{2});
+        IRIS_CHECK_EQ(snapshot.outcomes[static_cast<size_t>(iris::ErrorClass::NONE)], uint64_t{1});
+        IRIS_CHECK_EQ(snapshot.outcomes[static_cast<size_t>(iris::ErrorClass::DECODE)], uint64_t{1});
+        IRIS_CHECK_EQ(snapshot.outcomes[static_cast<size_t>(iris::ErrorClass::TRANSPORT)], uint64_t{0});
+    }
+
+    return iris::test::result();
+}
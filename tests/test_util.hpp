@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// Minimal checks for the test executables: a failed check is reported with
+// its location and the test keeps going; main() returns iris::test::result().
+
+namespace iris {
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const std::string& what) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what.c_str());
+    ++failures();
+}
+
+inline int result() {
+    if (failures() > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace iris
+
+#define IRIS_CHECK(condition)                                        \
+    do {                                                             \
+        if (!(condition)) {                                          \
+            ::iris::test::fail(__FILE__, __LINE__, #condition);      \
+        }                                                            \
+    } while (0)
+
+#define IRIS_CHECK_EQ(actual, expected)                                                        \
+    do {                                                                                       \
+        const auto& actualValue = (actual);                                                    \
+        const auto& expectedValue = (expected);                                                \
+        if (!(actualValue == expectedValue)) {                                                 \
+            ::iris::test::fail(__FILE__, __LINE__, std::string(#actual " == " #expected " (") \
+                + std::to_string(actualValue) + " vs " + std::to_string(expectedValue) + ")"); \
+        }                                                                                      \
+    } while (0)
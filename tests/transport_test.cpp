@@ -0,0 +1,75 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/transport.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+// Recording through CurlTransport keeps the token out of the file, and the
+// replay answers like the server did.
+
+int main() {
+    namespace fs = std::filesystem;
+    const std::string token = "secret-token-123";
+    fs::path path = fs::temp_directory_path() / "iriscpp_transport_test.irisrec";
+
+    iris::bench::MockServer server([](std::string_view target, std::string& body) {
+        body = target.find("/balance") != std::string_view::npos
+            ? R"({"gold":12,"sweets":1534.25,"donate_score":40})"
+            : R"([{"user_id":7,"type":"give","amount":3,"comment":null,"timestamp":1700000000}])";
+    });
+    const std::string baseUrl = server.baseUrl() + "/api/1_" + token + "/v0.3";
+
+    bool rejected = false;
+    try {
+        iris::RecordingTransport unsafe(std::make_shared<iris::CurlTransport>(), path.string(), "");
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    IRIS_CHECK(rejected);
+
+    {
+        iris::IrisApi api(1, token, baseUrl);
+        auto recorder = std::make_shared<iris::RecordingTransport>(
+            std::make_shared<iris::CurlTransport>(), path.string(), api.baseUrl());
+        api.setTransport(recorder);
+        auto balance = api.tryGetBalance();
+        IRIS_CHECK(balance.ok() && balance->gold == 12);
+        auto history = api.getSweetsHistoryAsync(0).get();
+        IRIS_CHECK_EQ(history.size(), size_t{1});
+        IRIS_CHECK_EQ(recorder->recorded(), size_t{2});
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::string recording((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    IRIS_CHECK(recording.find(token) == std::string::npos);
+    IRIS_CHECK(recording.find("pocket/balance") != std::string::npos);
+
+    rejected = false;
+    try {
+        iris::ReplayTransport unmatched(path.string(), "");
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    IRIS_CHECK(rejected);
+
+    // Default options: exact URLs first, then the same path.
+    {
+        iris::IrisApi replayed(1, token, "https://iris.invalid/api/1_" + token + "/v0.3");
+        auto replay = std::make_shared<iris::ReplayTransport>(path.string(), replayed.baseUrl());
+        replayed.setTransport(replay);
+        auto balance = replayed.tryGetBalance();
+        IRIS_CHECK(balance.ok() && balance->sweets == 1534.25);
+        auto history = replayed.tryGetSweetsHistory();
+        IRIS_CHECK(history.ok() && history->size() == 1 && (*history)[0].user_id == 7);
+        auto paged = replayed.tryGetSweetsHistory(50);
+        IRIS_CHECK(paged.ok() && paged->size() == 1);
+        IRIS_CHECK_EQ(replay->stats().pathMatches, uint64_t{1});
+        IRIS_CHECK_EQ(replay->stats().misses, uint64_t{0});
+    }
+
+    fs::remove(path);
+    return iris::test::result();
+}
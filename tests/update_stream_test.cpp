@@ -0,0 +1,80 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/update_stream.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// UpdateStream only moves its offset past updates it has queued, so a stream
+// stopped while the queue is full resumes exactly where delivery ended.
+// Offsets beyond INT_MAX go out unchanged.
+
+namespace {
+
+constexpr long kFirstId = 3000000000L;
+constexpr long kUpdates = 100;
+
+long queryOffset(std::string_view target) {
+    size_t at = target.find("offset=");
+    return at == std::string_view::npos ? 0 : std::stol(std::string(target.substr(at + 7)));
+}
+
+} // namespace
+
+int main() {
+    using namespace std::chrono_literals;
+
+    iris::bench::MockServer server([](std::string_view target, std::string& body) {
+        body = "[";
+        for (long id = std::max(queryOffset(target), kFirstId); id < kFirstId + kUpdates; ++id) {
+            if (body.size() > 1) body += ',';
+            body += R"({"update_id":)" + std::to_string(id) + R"(,"type":"sweets_log","user_id":7,"amount":1,)"
+                R"("comment":null,"timestamp":1700000000})";
+        }
+        body += "]";
+    });
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    iris::UpdateStreamOptions options;
+    options.offset = kFirstId;
+    options.capacity = 8;
+    options.idleDelay = 10ms;
+
+    long resumeFrom = 0;
+    long expected = kFirstId;
+    {
+        iris::UpdateStream stream(api, options);
+        iris::UpdatesLog update;
+        for (int i = 0; i < 5; ++i) {
+            IRIS_CHECK(stream.pop(update, 2s));
+            IRIS_CHECK_EQ(update.update_id, expected);
+            ++expected;
+        }
+        // Let the poller fill the queue and block on it.
+        std::this_thread::sleep_for(200ms);
+        IRIS_CHECK_EQ(stream.queued(), options.capacity);
+        stream.stop();
+
+        while (stream.tryPop(update)) {
+            IRIS_CHECK_EQ(update.update_id, expected);
+            ++expected;
+        }
+        resumeFrom = stream.offset();
+        IRIS_CHECK_EQ(resumeFrom, expected);
+        IRIS_CHECK(resumeFrom < kFirstId + kUpdates);
+    }
+
+    // A new stream from the saved offset picks up the rest.
+    options.offset = resumeFrom;
+    iris::UpdateStream stream(api, options);
+    iris::UpdatesLog update;
+    while (expected < kFirstId + kUpdates && stream.pop(update, 2s)) {
+        IRIS_CHECK_EQ(update.update_id, expected);
+        ++expected;
+    }
+    IRIS_CHECK_EQ(expected, kFirstId + kUpdates);
+
+    return iris::test::result();
+}
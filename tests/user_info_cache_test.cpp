@@ -0,0 +1,130 @@
+#include "mock_server.hpp"
+#include "test_util.hpp"
+#include <iris/iris_api.hpp>
+#include <iris/user_info_cache.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Concurrent misses share one request, answers live for their TTL, failures
+// are not kept and an invalidation is not undone by a load still in flight.
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class CountingServer {
+public:
+    // User 1 answers slowly, user 9 fails once.
+    int handle(std::string_view target, std::string& body) {
+        long userId = std::stol(std::string(target.substr(target.find("user_id=") + 8)));
+        int count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            count = ++requests_[userId];
+        }
+        if (userId == 1 || userId == 5) {
+            std::this_thread::sleep_for(300ms);
+        }
+        if (userId == 9 && count == 1) {
+            body = "oops";
+            return 500;
+        }
+        if (target.find("user_info/spam") != std::string_view::npos) {
+            body = R"({"spam":false,"ignore":false,"scam":false})";
+        } else {
+            body = R"({"timestamp":)" + std::to_string(1600000000 + userId) + "}";
+        }
+        return 200;
+    }
+
+    int requests(long userId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_[userId];
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<long, int> requests_;
+};
+
+} // namespace
+
+int main() {
+    CountingServer counting;
+    iris::bench::MockServer server(iris::bench::MockServer::StatusHandler{
+        [&](std::string_view target, std::string& body) { return counting.handle(target, body); }});
+    iris::IrisApi api(1, "token", server.baseUrl());
+
+    iris::UserInfoCacheOptions options;
+    options.regTtl = 400ms;
+    iris::UserInfoCache cache(api, options);
+
+    // Eight concurrent misses, one request.
+    {
+        std::vector<std::future<std::optional<iris::UserRegInfo>>> lookups;
+        for (int i = 0; i < 8; ++i) {
+            lookups.push_back(std::async(std::launch::async, [&] { return cache.checkUserReg(1); }));
+        }
+        for (auto& lookup : lookups) {
+            auto reg = lookup.get();
+            IRIS_CHECK(reg && reg->timestamp == 1600000001);
+        }
+        IRIS_CHECK_EQ(counting.requests(1), 1);
+        iris::UserInfoCacheStats stats = cache.stats();
+        IRIS_CHECK_EQ(stats.misses, uint64_t{1});
+        IRIS_CHECK_EQ(stats.coalesced, uint64_t{7});
+        IRIS_CHECK_EQ(stats.hits, uint64_t{0});
+    }
+
+    // A hit within the TTL, a refetch after it.
+    {
+        IRIS_CHECK(cache.checkUserReg(2).has_value());
+        IRIS_CHECK(cache.checkUserReg(2).has_value());
+        IRIS_CHECK_EQ(counting.requests(2), 1);
+        IRIS_CHECK_EQ(cache.stats().hits, uint64_t{1});
+        std::this_thread::sleep_for(500ms);
+        IRIS_CHECK(cache.checkUserReg(2).has_value());
+        IRIS_CHECK_EQ(counting.requests(2), 2);
+    }
+
+    // Types are cached apart.
+    {
+        IRIS_CHECK(cache.checkUserSpam(2).has_value());
+        IRIS_CHECK_EQ(counting.requests(2), 3);
+    }
+
+    // A failure is not cached.
+    {
+        IRIS_CHECK(!cache.checkUserReg(9).has_value());
+        IRIS_CHECK(cache.checkUserReg(9).has_value());
+        IRIS_CHECK(cache.checkUserReg(9).has_value());
+        IRIS_CHECK_EQ(counting.requests(9), 2);
+    }
+
+    // Invalidated while loading: the late answer is not stored.
+    {
+        auto loading = std::async(std::launch::async, [&] { return cache.checkUserReg(5); });
+        std::this_thread::sleep_for(100ms);
+        cache.invalidate(5);
+        IRIS_CHECK(loading.get().has_value());
+        IRIS_CHECK(cache.checkUserReg(5).has_value());
+        IRIS_CHECK_EQ(counting.requests(5), 2);
+        IRIS_CHECK(cache.checkUserReg(5).has_value());
+        IRIS_CHECK_EQ(counting.requests(5), 2);
+    }
+
+    // invalidate() drops settled entries of every type.
+    {
+        cache.invalidate(2);
+        IRIS_CHECK(cache.checkUserSpam(2).has_value());
+        IRIS_CHECK_EQ(counting.requests(2), 4);
+    }
+
+    return iris::test::result();
+}